@@ -38,6 +38,46 @@ unsigned long bot_lasttime; // last time messages' scan has been done
 const int ledPin = LED_BUILTIN;
 int ledStatus = 0;
 
+void handleLedOn(UniversalTelegramBot &bot, telegramMessage &message, TelegramCommandArgs &args)
+{
+  digitalWrite(ledPin, LOW); // turn the LED on (HIGH is the voltage level)
+  ledStatus = 1;
+  bot.sendMessage(message.chat_id, "Led is ON", "");
+}
+
+void handleLedOff(UniversalTelegramBot &bot, telegramMessage &message, TelegramCommandArgs &args)
+{
+  ledStatus = 0;
+  digitalWrite(ledPin, HIGH); // turn the LED off (LOW is the voltage level)
+  bot.sendMessage(message.chat_id, "Led is OFF", "");
+}
+
+void handleStatus(UniversalTelegramBot &bot, telegramMessage &message, TelegramCommandArgs &args)
+{
+  if (ledStatus)
+  {
+    bot.sendMessage(message.chat_id, "Led is ON", "");
+  }
+  else
+  {
+    bot.sendMessage(message.chat_id, "Led is OFF", "");
+  }
+}
+
+void handleStart(UniversalTelegramBot &bot, telegramMessage &message, TelegramCommandArgs &args)
+{
+  String from_name = message.from_name;
+  if (from_name == "")
+    from_name = "Guest";
+
+  String welcome = "Welcome to Universal Arduino Telegram Bot library, " + from_name + ".\n";
+  welcome += "This is Flash Led Bot example.\n\n";
+  welcome += "/ledon : to switch the Led ON\n";
+  welcome += "/ledoff : to switch the Led OFF\n";
+  welcome += "/status : Returns current status of LED\n";
+  bot.sendMessage(message.chat_id, welcome, "Markdown");
+}
+
 void handleNewMessages(int numNewMessages)
 {
   Serial.print("handleNewMessages ");
@@ -45,52 +85,11 @@ void handleNewMessages(int numNewMessages)
 
   for (int i = 0; i < numNewMessages; i++)
   {
-    String chat_id = bot.messages[i].chat_id;
-    String text = bot.messages[i].text;
-
-    String from_name = bot.messages[i].from_name;
-    if (from_name == "")
-      from_name = "Guest";
-
-    if (text == "/ledon")
-    {
-      digitalWrite(ledPin, LOW); // turn the LED on (HIGH is the voltage level)
-      ledStatus = 1;
-      bot.sendMessage(chat_id, "Led is ON", "");
-    }
-
-    if (text == "/ledoff")
-    {
-      ledStatus = 0;
-      digitalWrite(ledPin, HIGH); // turn the LED off (LOW is the voltage level)
-      bot.sendMessage(chat_id, "Led is OFF", "");
-    }
-
-    if (text == "/status")
-    {
-      if (ledStatus)
-      {
-        bot.sendMessage(chat_id, "Led is ON", "");
-      }
-      else
-      {
-        bot.sendMessage(chat_id, "Led is OFF", "");
-      }
-    }
-
-    if (text == "/start")
-    {
-      String welcome = "Welcome to Universal Arduino Telegram Bot library, " + from_name + ".\n";
-      welcome += "This is Flash Led Bot example.\n\n";
-      welcome += "/ledon : to switch the Led ON\n";
-      welcome += "/ledoff : to switch the Led OFF\n";
-      welcome += "/status : Returns current status of LED\n";
-      bot.sendMessage(chat_id, welcome, "Markdown");
-    }
+    // Runs the handler registered with bot.on() in setup()
+    bot.dispatch(bot.messages[i]);
   }
 }
 
-
 void setup()
 {
   Serial.begin(115200);
@@ -123,6 +122,12 @@ void setup()
     now = time(nullptr);
   }
   Serial.println(now);
+
+  bot.on("/ledon", handleLedOn);
+  bot.on("/ledoff", handleLedOff);
+  bot.on("/status", handleStatus);
+  bot.on("/start", handleStart);
+  bot.getMe(); // so "/status@YourBot" in a group is recognised
 }
 
 void loop()
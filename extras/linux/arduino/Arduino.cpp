@@ -0,0 +1,108 @@
+/*
+   Arduino compatibility layer for building UniversalTelegramBot natively on
+   Linux.
+ */
+
+#include "Arduino.h"
+
+#include <poll.h>
+#include <sched.h>
+#include <stdio.h>
+#include <time.h>
+#include <unistd.h>
+
+HardwareSerial Serial;
+
+static uint64_t clockMicros() {
+  struct timespec ts;
+  clock_gettime(CLOCK_MONOTONIC, &ts);
+  return (uint64_t)ts.tv_sec * 1000000ULL + ts.tv_nsec / 1000;
+}
+
+static uint64_t monotonicMicros() {
+  // Function-local static: initialised once even with several threads
+  static const uint64_t start = clockMicros();
+  return clockMicros() - start;
+}
+
+unsigned long millis() {
+  return (unsigned long)(monotonicMicros() / 1000);
+}
+
+unsigned long micros() {
+  return (unsigned long)monotonicMicros();
+}
+
+void delay(unsigned long ms) {
+  struct timespec ts;
+  ts.tv_sec = ms / 1000;
+  ts.tv_nsec = (long)(ms % 1000) * 1000000L;
+  while (nanosleep(&ts, &ts) != 0) {
+  }
+}
+
+void delayMicroseconds(unsigned int us) {
+  struct timespec ts;
+  ts.tv_sec = us / 1000000;
+  ts.tv_nsec = (long)(us % 1000000) * 1000L;
+  while (nanosleep(&ts, &ts) != 0) {
+  }
+}
+
+void yield() {
+  // Nothing to service on the host; busy loops in the library call this
+  // between polls, so give the CPU away briefly instead of spinning
+  sched_yield();
+}
+
+long random(long howbig) {
+  if (howbig == 0) return 0;
+  return ::random() % howbig;
+}
+
+long random(long howsmall, long howbig) {
+  if (howsmall >= howbig) return howsmall;
+  return random(howbig - howsmall) + howsmall;
+}
+
+void randomSeed(unsigned long seed) {
+  if (seed != 0) srandom(seed);
+}
+
+/*********************************************/
+/*  Serial                                   */
+/*********************************************/
+
+int HardwareSerial::available() {
+  if (_peeked >= 0) return 1;
+  struct pollfd pfd = {STDIN_FILENO, POLLIN, 0};
+  return poll(&pfd, 1, 0) > 0 && (pfd.revents & POLLIN) ? 1 : 0;
+}
+
+int HardwareSerial::read() {
+  if (_peeked >= 0) {
+    int c = _peeked;
+    _peeked = -1;
+    return c;
+  }
+  if (!available()) return -1;
+  unsigned char c;
+  return ::read(STDIN_FILENO, &c, 1) == 1 ? c : -1;
+}
+
+int HardwareSerial::peek() {
+  if (_peeked < 0) _peeked = read();
+  return _peeked;
+}
+
+size_t HardwareSerial::write(uint8_t c) {
+  return fwrite(&c, 1, 1, stdout);
+}
+
+size_t HardwareSerial::write(const uint8_t *buffer, size_t size) {
+  return fwrite(buffer, 1, size, stdout);
+}
+
+void HardwareSerial::flush() {
+  fflush(stdout);
+}
@@ -0,0 +1,41 @@
+/*
+   Minimal Arduino IPAddress for the host build of UniversalTelegramBot.
+ */
+
+#ifndef IPAddress_h
+#define IPAddress_h
+
+#include <stdint.h>
+
+#include "WString.h"
+
+class IPAddress {
+public:
+  IPAddress() : _address{0, 0, 0, 0} {}
+  IPAddress(uint8_t a, uint8_t b, uint8_t c, uint8_t d) : _address{a, b, c, d} {}
+
+  uint8_t operator[](int index) const { return _address[index]; }
+  uint8_t &operator[](int index) { return _address[index]; }
+
+  bool operator==(const IPAddress &other) const {
+    for (int i = 0; i < 4; i++) {
+      if (_address[i] != other._address[i]) return false;
+    }
+    return true;
+  }
+  bool operator!=(const IPAddress &other) const { return !(*this == other); }
+
+  String toString() const {
+    String s;
+    for (int i = 0; i < 4; i++) {
+      if (i) s += '.';
+      s += (unsigned int)_address[i];
+    }
+    return s;
+  }
+
+private:
+  uint8_t _address[4];
+};
+
+#endif
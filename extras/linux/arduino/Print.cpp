@@ -0,0 +1,118 @@
+/*
+   Minimal Arduino Print for the host build of UniversalTelegramBot.
+ */
+
+#include "Print.h"
+
+#include <stdarg.h>
+#include <stdio.h>
+#include <stdlib.h>
+
+size_t Print::write(const uint8_t *buffer, size_t size) {
+  size_t n = 0;
+  while (size--) {
+    if (write(*buffer++)) n++;
+    else break;
+  }
+  return n;
+}
+
+size_t Print::print(const __FlashStringHelper *str) {
+  return write(reinterpret_cast<const char *>(str));
+}
+
+size_t Print::print(const String &s) {
+  return write(s.c_str(), s.length());
+}
+
+size_t Print::print(const char str[]) {
+  return write(str);
+}
+
+size_t Print::print(char c) {
+  return write((uint8_t)c);
+}
+
+size_t Print::print(unsigned char value, int base) {
+  return print((unsigned long long)value, base);
+}
+
+size_t Print::print(int value, int base) {
+  return print((long long)value, base);
+}
+
+size_t Print::print(unsigned int value, int base) {
+  return print((unsigned long long)value, base);
+}
+
+size_t Print::print(long value, int base) {
+  return print((long long)value, base);
+}
+
+size_t Print::print(unsigned long value, int base) {
+  return print((unsigned long long)value, base);
+}
+
+size_t Print::print(long long value, int base) {
+  if (base == DEC && value < 0) {
+    return print('-') + print(0ULL - (unsigned long long)value, base);
+  }
+  return print((unsigned long long)value, base);
+}
+
+size_t Print::print(unsigned long long value, int base) {
+  if (base == 0) return write((uint8_t)value);
+  return print(String(value, (unsigned char)base));
+}
+
+size_t Print::print(double value, int digits) {
+  return print(String(value, (unsigned char)digits));
+}
+
+size_t Print::println() {
+  return write("\r\n");
+}
+
+#define PRINTLN(TYPE)                          \
+  size_t Print::println(TYPE value) {          \
+    size_t n = print(value);                   \
+    return n + println();                      \
+  }
+
+#define PRINTLN_BASE(TYPE)                     \
+  size_t Print::println(TYPE value, int base) { \
+    size_t n = print(value, base);             \
+    return n + println();                      \
+  }
+
+PRINTLN(const __FlashStringHelper *)
+PRINTLN(const String &)
+PRINTLN(const char *)
+PRINTLN(char)
+PRINTLN_BASE(unsigned char)
+PRINTLN_BASE(int)
+PRINTLN_BASE(unsigned int)
+PRINTLN_BASE(long)
+PRINTLN_BASE(unsigned long)
+PRINTLN_BASE(long long)
+PRINTLN_BASE(unsigned long long)
+PRINTLN_BASE(double)
+
+size_t Print::printf(const char *format, ...) {
+  char buf[128];
+  va_list args;
+  va_start(args, format);
+  int len = vsnprintf(buf, sizeof(buf), format, args);
+  va_end(args);
+  if (len < 0) return 0;
+  if ((size_t)len < sizeof(buf)) return write((const uint8_t *)buf, len);
+
+  char *big = (char *)malloc(len + 1);
+  if (big == nullptr) return 0;
+  va_start(args, format);
+  vsnprintf(big, len + 1, format, args);
+  va_end(args);
+  size_t n = write((const uint8_t *)big, len);
+  free(big);
+  return n;
+}
@@ -0,0 +1,542 @@
+/*
+   Minimal Arduino String for the host build of UniversalTelegramBot.
+ */
+
+#include "WString.h"
+
+#include <ctype.h>
+#include <stdio.h>
+#include <stdlib.h>
+
+static void formatUnsigned(char *buf, unsigned long long value, unsigned char base) {
+  char tmp[66];
+  int i = 0;
+  if (base < 2) base = 10;
+  do {
+    int digit = (int)(value % base);
+    tmp[i++] = (char)(digit < 10 ? '0' + digit : 'a' + digit - 10);
+    value /= base;
+  } while (value != 0);
+  int j = 0;
+  while (i > 0) buf[j++] = tmp[--i];
+  buf[j] = '\0';
+}
+
+static void formatSigned(char *buf, long long value, unsigned char base) {
+  if (value < 0 && base == 10) {
+    buf[0] = '-';
+    formatUnsigned(buf + 1, 0ULL - (unsigned long long)value, base);
+  } else {
+    formatUnsigned(buf, (unsigned long long)value, base);
+  }
+}
+
+/*********************************************/
+/*  Constructors                             */
+/*********************************************/
+
+String::String(const char *cstr) {
+  init();
+  if (cstr) copy(cstr, strlen(cstr));
+}
+
+String::String(const char *cstr, unsigned int length) {
+  init();
+  if (cstr) copy(cstr, length);
+}
+
+String::String(const String &value) {
+  init();
+  *this = value;
+}
+
+String::String(String &&rval) {
+  init();
+  move(rval);
+}
+
+String::String(const __FlashStringHelper *str) {
+  init();
+  *this = str;
+}
+
+String::String(char c) {
+  init();
+  char buf[2] = {c, '\0'};
+  *this = buf;
+}
+
+String::String(unsigned char value, unsigned char base) {
+  init();
+  char buf[66];
+  formatUnsigned(buf, value, base);
+  *this = buf;
+}
+
+String::String(int value, unsigned char base) {
+  init();
+  char buf[67];
+  formatSigned(buf, value, base);
+  *this = buf;
+}
+
+String::String(unsigned int value, unsigned char base) {
+  init();
+  char buf[66];
+  formatUnsigned(buf, value, base);
+  *this = buf;
+}
+
+String::String(long value, unsigned char base) {
+  init();
+  char buf[67];
+  formatSigned(buf, value, base);
+  *this = buf;
+}
+
+String::String(unsigned long value, unsigned char base) {
+  init();
+  char buf[66];
+  formatUnsigned(buf, value, base);
+  *this = buf;
+}
+
+String::String(long long value, unsigned char base) {
+  init();
+  char buf[67];
+  formatSigned(buf, value, base);
+  *this = buf;
+}
+
+String::String(unsigned long long value, unsigned char base) {
+  init();
+  char buf[66];
+  formatUnsigned(buf, value, base);
+  *this = buf;
+}
+
+String::String(float value, unsigned char decimalPlaces) {
+  init();
+  char buf[64];
+  snprintf(buf, sizeof(buf), "%.*f", decimalPlaces, (double)value);
+  *this = buf;
+}
+
+String::String(double value, unsigned char decimalPlaces) {
+  init();
+  char buf[64];
+  snprintf(buf, sizeof(buf), "%.*f", decimalPlaces, value);
+  *this = buf;
+}
+
+String::~String() {
+  free(_buffer);
+}
+
+/*********************************************/
+/*  Memory Management                        */
+/*********************************************/
+
+void String::init() {
+  _buffer = nullptr;
+  _capacity = 0;
+  _len = 0;
+}
+
+void String::invalidate() {
+  free(_buffer);
+  init();
+}
+
+bool String::reserve(unsigned int size) {
+  if (_buffer && _capacity >= size) return true;
+  if (changeBuffer(size)) {
+    if (_len == 0) _buffer[0] = '\0';
+    return true;
+  }
+  return false;
+}
+
+bool String::changeBuffer(unsigned int maxStrLen) {
+  char *newbuffer = (char *)realloc(_buffer, maxStrLen + 1);
+  if (newbuffer) {
+    _buffer = newbuffer;
+    _capacity = maxStrLen;
+    return true;
+  }
+  return false;
+}
+
+String &String::copy(const char *cstr, unsigned int length) {
+  if (!reserve(length)) {
+    invalidate();
+    return *this;
+  }
+  _len = length;
+  memmove(_buffer, cstr, length);
+  _buffer[length] = '\0';
+  return *this;
+}
+
+void String::move(String &rhs) {
+  if (this != &rhs) {
+    free(_buffer);
+    _buffer = rhs._buffer;
+    _capacity = rhs._capacity;
+    _len = rhs._len;
+    rhs.init();
+  }
+}
+
+String &String::operator=(const String &rhs) {
+  if (this == &rhs) return *this;
+  if (rhs._buffer) copy(rhs._buffer, rhs._len);
+  else invalidate();
+  return *this;
+}
+
+String &String::operator=(String &&rval) {
+  move(rval);
+  return *this;
+}
+
+String &String::operator=(const char *cstr) {
+  if (cstr) copy(cstr, strlen(cstr));
+  else invalidate();
+  return *this;
+}
+
+String &String::operator=(const __FlashStringHelper *str) {
+  return *this = reinterpret_cast<const char *>(str);
+}
+
+/*********************************************/
+/*  concat                                   */
+/*********************************************/
+
+bool String::concat(const String &s) {
+  if (&s == this) {
+    unsigned int len = _len;
+    if (!reserve(len * 2)) return false;
+    memcpy(_buffer + len, _buffer, len);
+    _len = len * 2;
+    _buffer[_len] = '\0';
+    return true;
+  }
+  return concat(s.c_str(), s._len);
+}
+
+bool String::concat(const char *cstr, unsigned int length) {
+  unsigned int newlen = _len + length;
+  if (!cstr) return false;
+  if (length == 0) return true;
+  if (newlen > _capacity) {
+    // cstr may point into our own buffer, which realloc can move
+    bool self = _buffer && cstr >= _buffer && cstr < _buffer + _len;
+    size_t offset = self ? cstr - _buffer : 0;
+    // Grow geometrically so byte-at-a-time appends stay linear
+    unsigned int grow = _capacity + (_capacity >> 1);
+    if (!reserve(newlen > grow ? newlen : grow)) return false;
+    if (self) cstr = _buffer + offset;
+  }
+  memcpy(_buffer + _len, cstr, length);
+  _len = newlen;
+  _buffer[_len] = '\0';
+  return true;
+}
+
+bool String::concat(const char *cstr) {
+  if (!cstr) return false;
+  return concat(cstr, strlen(cstr));
+}
+
+bool String::concat(const __FlashStringHelper *str) {
+  return concat(reinterpret_cast<const char *>(str));
+}
+
+bool String::concat(char c) {
+  return concat(&c, 1);
+}
+
+bool String::concat(unsigned char num) {
+  char buf[66];
+  formatUnsigned(buf, num, 10);
+  return concat(buf);
+}
+
+bool String::concat(int num) {
+  char buf[67];
+  formatSigned(buf, num, 10);
+  return concat(buf);
+}
+
+bool String::concat(unsigned int num) {
+  char buf[66];
+  formatUnsigned(buf, num, 10);
+  return concat(buf);
+}
+
+bool String::concat(long num) {
+  char buf[67];
+  formatSigned(buf, num, 10);
+  return concat(buf);
+}
+
+bool String::concat(unsigned long num) {
+  char buf[66];
+  formatUnsigned(buf, num, 10);
+  return concat(buf);
+}
+
+bool String::concat(long long num) {
+  char buf[67];
+  formatSigned(buf, num, 10);
+  return concat(buf);
+}
+
+bool String::concat(unsigned long long num) {
+  char buf[66];
+  formatUnsigned(buf, num, 10);
+  return concat(buf);
+}
+
+bool String::concat(float num) {
+  return concat(String(num));
+}
+
+bool String::concat(double num) {
+  return concat(String(num));
+}
+
+StringSumHelper &operator+(const StringSumHelper &lhs, const String &rhs) {
+  StringSumHelper &a = const_cast<StringSumHelper &>(lhs);
+  if (!a.concat(rhs)) a.invalidate();
+  return a;
+}
+
+StringSumHelper &operator+(const StringSumHelper &lhs, const char *cstr) {
+  StringSumHelper &a = const_cast<StringSumHelper &>(lhs);
+  if (!cstr || !a.concat(cstr)) a.invalidate();
+  return a;
+}
+
+StringSumHelper &operator+(const StringSumHelper &lhs, const __FlashStringHelper *rhs) {
+  StringSumHelper &a = const_cast<StringSumHelper &>(lhs);
+  if (!a.concat(rhs)) a.invalidate();
+  return a;
+}
+
+#define STRING_SUM_NUMBER(TYPE)                                          \
+  StringSumHelper &operator+(const StringSumHelper &lhs, TYPE num) {     \
+    StringSumHelper &a = const_cast<StringSumHelper &>(lhs);             \
+    if (!a.concat(num)) a.invalidate();                                  \
+    return a;                                                            \
+  }
+
+STRING_SUM_NUMBER(char)
+STRING_SUM_NUMBER(int)
+STRING_SUM_NUMBER(unsigned int)
+STRING_SUM_NUMBER(long)
+STRING_SUM_NUMBER(unsigned long)
+STRING_SUM_NUMBER(long long)
+STRING_SUM_NUMBER(float)
+STRING_SUM_NUMBER(double)
+
+/*********************************************/
+/*  Comparison                               */
+/*********************************************/
+
+int String::compareTo(const String &s) const {
+  return strcmp(c_str(), s.c_str());
+}
+
+bool String::equals(const String &s) const {
+  return _len == s._len && compareTo(s) == 0;
+}
+
+bool String::equals(const char *cstr) const {
+  if (!cstr) return _len == 0;
+  return strcmp(c_str(), cstr) == 0;
+}
+
+bool String::equalsIgnoreCase(const String &s) const {
+  if (_len != s._len) return false;
+  for (unsigned int i = 0; i < _len; i++) {
+    if (tolower((unsigned char)_buffer[i]) != tolower((unsigned char)s._buffer[i])) return false;
+  }
+  return true;
+}
+
+bool String::startsWith(const String &prefix) const {
+  if (_len < prefix._len) return false;
+  return startsWith(prefix, 0);
+}
+
+bool String::startsWith(const String &prefix, unsigned int offset) const {
+  if (offset > _len || _len - offset < prefix._len) return false;
+  return strncmp(c_str() + offset, prefix.c_str(), prefix._len) == 0;
+}
+
+bool String::endsWith(const String &suffix) const {
+  if (_len < suffix._len) return false;
+  return strcmp(c_str() + _len - suffix._len, suffix.c_str()) == 0;
+}
+
+/*********************************************/
+/*  Character Access                         */
+/*********************************************/
+
+char String::charAt(unsigned int index) const {
+  return operator[](index);
+}
+
+void String::setCharAt(unsigned int index, char c) {
+  if (index < _len) _buffer[index] = c;
+}
+
+char &String::operator[](unsigned int index) {
+  static char dummy_writable_char;
+  if (index >= _len || !_buffer) {
+    dummy_writable_char = 0;
+    return dummy_writable_char;
+  }
+  return _buffer[index];
+}
+
+char String::operator[](unsigned int index) const {
+  if (index >= _len || !_buffer) return 0;
+  return _buffer[index];
+}
+
+void String::getBytes(unsigned char *buf, unsigned int bufsize, unsigned int index) const {
+  if (!bufsize || !buf) return;
+  if (index >= _len) {
+    buf[0] = 0;
+    return;
+  }
+  unsigned int n = bufsize - 1;
+  if (n > _len - index) n = _len - index;
+  memcpy(buf, _buffer + index, n);
+  buf[n] = 0;
+}
+
+void String::toCharArray(char *buf, unsigned int bufsize, unsigned int index) const {
+  getBytes((unsigned char *)buf, bufsize, index);
+}
+
+/*********************************************/
+/*  Search                                   */
+/*********************************************/
+
+int String::indexOf(char c, unsigned int fromIndex) const {
+  if (fromIndex >= _len) return -1;
+  const char *temp = strchr(_buffer + fromIndex, c);
+  if (temp == nullptr) return -1;
+  return temp - _buffer;
+}
+
+int String::indexOf(const String &s, unsigned int fromIndex) const {
+  if (fromIndex >= _len) return -1;
+  const char *found = strstr(_buffer + fromIndex, s.c_str());
+  if (found == nullptr) return -1;
+  return found - _buffer;
+}
+
+int String::lastIndexOf(char c) const {
+  if (_len == 0) return -1;
+  const char *temp = strrchr(_buffer, c);
+  if (temp == nullptr) return -1;
+  return temp - _buffer;
+}
+
+int String::lastIndexOf(const String &s) const {
+  if (s._len == 0 || s._len > _len) return -1;
+  for (int i = (int)(_len - s._len); i >= 0; i--) {
+    if (strncmp(_buffer + i, s.c_str(), s._len) == 0) return i;
+  }
+  return -1;
+}
+
+String String::substring(unsigned int left, unsigned int right) const {
+  if (left > right) {
+    unsigned int temp = right;
+    right = left;
+    left = temp;
+  }
+  if (left >= _len) return String();
+  if (right > _len) right = _len;
+  return String(_buffer + left, right - left);
+}
+
+/*********************************************/
+/*  Modification                             */
+/*********************************************/
+
+void String::replace(char find, char replace) {
+  for (unsigned int i = 0; i < _len; i++) {
+    if (_buffer[i] == find) _buffer[i] = replace;
+  }
+}
+
+void String::replace(const String &find, const String &replace) {
+  if (_len == 0 || find._len == 0) return;
+  String result;
+  unsigned int i = 0;
+  while (i < _len) {
+    if (i + find._len <= _len && strncmp(_buffer + i, find._buffer, find._len) == 0) {
+      result.concat(replace);
+      i += find._len;
+    } else {
+      result.concat(_buffer[i]);
+      i++;
+    }
+  }
+  move(result);
+}
+
+void String::remove(unsigned int index) {
+  remove(index, (unsigned int)-1);
+}
+
+void String::remove(unsigned int index, unsigned int count) {
+  if (index >= _len) return;
+  if (count > _len - index) count = _len - index;
+  memmove(_buffer + index, _buffer + index + count, _len - index - count);
+  _len -= count;
+  _buffer[_len] = '\0';
+}
+
+void String::toLowerCase() {
+  for (unsigned int i = 0; i < _len; i++) _buffer[i] = (char)tolower((unsigned char)_buffer[i]);
+}
+
+void String::toUpperCase() {
+  for (unsigned int i = 0; i < _len; i++) _buffer[i] = (char)toupper((unsigned char)_buffer[i]);
+}
+
+void String::trim() {
+  if (_len == 0) return;
+  char *begin = _buffer;
+  while (isspace((unsigned char)*begin)) begin++;
+  char *end = _buffer + _len - 1;
+  while (end >= begin && isspace((unsigned char)*end)) end--;
+  _len = end + 1 - begin;
+  if (begin > _buffer) memmove(_buffer, begin, _len);
+  _buffer[_len] = '\0';
+}
+
+/*********************************************/
+/*  Parsing / Conversion                     */
+/*********************************************/
+
+long String::toInt() const {
+  return _buffer ? atol(_buffer) : 0;
+}
+
+float String::toFloat() const {
+  return (float)toDouble();
+}
+
+double String::toDouble() const {
+  return _buffer ? atof(_buffer) : 0;
+}
@@ -0,0 +1,185 @@
+/*
+   Microbenchmarks for the hot paths of UniversalTelegramBot, run against an
+   in-memory ScriptedClient so only library time is measured:
+
+     readHTTPAnswer/...  HTTP reader over recorded responses
+     getUpdates/...      one update per type through processResult
+                         (document includes the getFile round trip),
+                         under two update_ids far apart in turn so the
+                         duplicate filter lets every poll through
+     sendMessage/...     payload serialization alone, and the full call
+
+     telegram_bench [filter] [--min-time MS] [--csv]
+
+   Reports time, allocation calls and requested bytes per operation. Keep the
+   output of a known-good build around and compare against it, e.g.
+     telegram_bench --csv > before.csv
+ */
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include <chrono>
+#include <string>
+
+#include <AllocStats.h>
+#include <ScriptedClient.h>
+#include <UniversalTelegramBot.h>
+
+#include "corpus.h"
+
+static const char *filter = nullptr;
+static long minTimeMs = 200;
+static bool csv = false;
+
+template <typename Fn>
+static void measure(const std::string &name, Fn fn) {
+  if (filter && name.find(filter) == std::string::npos) return;
+
+  for (int i = 0; i < 16; i++) fn(); // warm up caches and the allocator
+
+  typedef std::chrono::steady_clock clock;
+  unsigned long iterations = 64;
+  double ns;
+  AllocStats used;
+  for (;;) {
+    AllocStats before = AllocStats::snapshot();
+    clock::time_point start = clock::now();
+    for (unsigned long i = 0; i < iterations; i++) fn();
+    clock::time_point end = clock::now();
+    used = AllocStats::snapshot() - before;
+    ns = std::chrono::duration<double, std::nano>(end - start).count();
+    if (ns >= minTimeMs * 1e6 || iterations >= (1ul << 30)) break;
+    iterations *= 2;
+  }
+
+  double allocs = (double)used.allocations / iterations;
+  double bytes = (double)used.bytesAllocated / iterations;
+  if (csv) {
+    printf("%s,%.1f,%.2f,%.1f,%lu\n", name.c_str(), ns / iterations, allocs, bytes, iterations);
+  } else {
+    printf("%-44s %12.1f %10.2f %12.1f %10lu\n", name.c_str(), ns / iterations, allocs, bytes,
+           iterations);
+  }
+  fflush(stdout);
+}
+
+static void benchReader() {
+  ScriptedClient client;
+  UniversalTelegramBot bot("123456:TOKEN", client);
+
+  struct {
+    const char *name;
+    std::string body;
+  } cases[] = {
+    {"empty_updates", emptyUpdatesBody},
+    {"text", updateCorpus[0].body},
+    {"callback_query", updateCorpus[2].body},
+    {"send_message_reply", sendMessageBody},
+  };
+
+  for (size_t i = 0; i < sizeof(cases) / sizeof(cases[0]); i++) {
+    const size_t chunkSizes[] = {0, 128};
+    for (size_t c = 0; c < 2; c++) {
+      std::string response = telegramHttpResponse(cases[i].body, 200, chunkSizes[c]);
+      std::string name = std::string("readHTTPAnswer/") + cases[i].name +
+                         (chunkSizes[c] ? "/chunked" : "/length");
+      measure(name, [&]() {
+        client.load(response);
+        String body;
+        if (!bot.readHTTPAnswer(body)) abort();
+      });
+    }
+  }
+}
+
+static void benchUpdates() {
+  for (size_t i = 0; i < sizeof(updateCorpus) / sizeof(updateCorpus[0]); i++) {
+    // The same update under a second update_id far from the first, so
+    // that neither is ever dropped as a duplicate of the other
+    std::string body = updateCorpus[i].body;
+    size_t id = body.find("\"update_id\":") + strlen("\"update_id\":");
+    std::string farBody = body;
+    farBody[id] = farBody[id] == '9' ? '1' : farBody[id] + 1;
+
+    ScriptedClient client;
+    client.respond("/getUpdates?offset=1&", telegramHttpResponse(body));
+    client.respond("/getUpdates?offset=2&", telegramHttpResponse(farBody));
+    client.respond("/getFile", telegramHttpResponse(getFileBody));
+    UniversalTelegramBot bot("123456:TOKEN", client);
+
+    if (bot.getUpdates(1) != 1 || bot.getUpdates(2) != 1) {
+      fprintf(stderr, "getUpdates/%s: update not recognised\n", updateCorpus[i].name);
+      exit(1);
+    }
+
+    // Every poll brings an update_id new to the duplicate filter
+    long offset = 1;
+    measure(std::string("getUpdates/") + updateCorpus[i].name, [&]() {
+      if (bot.getUpdates(offset) != 1) abort();
+      offset = 3 - offset;
+    });
+  }
+
+  ScriptedClient client;
+  client.respond("/getUpdates", telegramHttpResponse(emptyUpdatesBody));
+  UniversalTelegramBot bot("123456:TOKEN", client);
+  measure("getUpdates/empty", [&]() { bot.getUpdates(1); });
+}
+
+static void benchSend() {
+  const String chatId = "100200300";
+  const String text = "Kitchen: 21.4 C, 48% RH, lights off";
+
+  // Same payload as UniversalTelegramBot::sendMessage builds and
+  // sendPostToTelegram writes out
+  measure("sendMessage/payload", [&]() {
+    JsonDocument payload;
+    payload["chat_id"] = chatId;
+    payload["text"] = text;
+    payload["parse_mode"] = "Markdown";
+    JsonObject object = payload.as<JsonObject>();
+    int length = measureJson(object);
+    String out;
+    serializeJson(object, out);
+    if ((int)out.length() != length) abort();
+  });
+
+  ScriptedClient client;
+  client.respond("/sendMessage", telegramHttpResponse(sendMessageBody));
+  UniversalTelegramBot bot("123456:TOKEN", client);
+  measure("sendMessage/call", [&]() {
+    if (!bot.sendMessage(chatId, text, "Markdown")) abort();
+  });
+}
+
+int main(int argc, char **argv) {
+  for (int i = 1; i < argc; i++) {
+    if (!strcmp(argv[i], "--min-time") && i + 1 < argc) {
+      minTimeMs = atol(argv[++i]);
+    } else if (!strcmp(argv[i], "--csv")) {
+      csv = true;
+    } else if (argv[i][0] != '-') {
+      filter = argv[i];
+    } else {
+      fprintf(stderr, "usage: %s [filter] [--min-time MS] [--csv]\n", argv[0]);
+      return 2;
+    }
+  }
+
+  if (!AllocStats::available()) {
+    fprintf(stderr, "allocation counting needs glibc, allocation columns will read 0\n");
+  }
+  if (csv) {
+    printf("benchmark,ns_per_op,allocs_per_op,bytes_per_op,iterations\n");
+  } else {
+    printf("%-44s %12s %10s %12s %10s\n", "benchmark", "ns/op", "allocs/op", "bytes/op",
+           "iters");
+  }
+
+  benchReader();
+  benchUpdates();
+  benchSend();
+  return 0;
+}
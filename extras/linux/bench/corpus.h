@@ -0,0 +1,46 @@
+/*
+   getUpdates bodies as api.telegram.org returns them, one per update type
+   the library extracts, plus the replies to the follow-up calls.
+   Identifiers and names are anonymised, shapes and field order are not.
+ */
+
+#ifndef corpus_h
+#define corpus_h
+
+struct CorpusEntry {
+  const char *name;
+  const char *body;
+};
+
+static const CorpusEntry updateCorpus[] = {
+  {"text", R"({"ok":true,"result":[{"update_id":815600001,
+"message":{"message_id":4211,"from":{"id":100200300,"is_bot":false,"first_name":"Alex","last_name":"Doe","username":"alexdoe","language_code":"en"},"chat":{"id":100200300,"first_name":"Alex","last_name":"Doe","username":"alexdoe","type":"private"},"date":1704067200,"text":"/status kitchen","entities":[{"offset":0,"length":7,"type":"bot_command"}]}}]})"},
+
+  {"document", R"({"ok":true,"result":[{"update_id":815600002,
+"message":{"message_id":4212,"from":{"id":100200300,"is_bot":false,"first_name":"Alex","last_name":"Doe","username":"alexdoe","language_code":"en"},"chat":{"id":100200300,"first_name":"Alex","last_name":"Doe","username":"alexdoe","type":"private"},"date":1704067260,"document":{"file_name":"firmware-1.4.2.bin","mime_type":"application/octet-stream","file_id":"BQACAgQAAxkBAAIQdGWYk3m2nYq0Xx5f4mB2YxwAAQbPZwACHhQAAlbqyVB9nq7kZx7aHjQE","file_unique_id":"AgADHhQAAlbqyVA","file_size":912384},"caption":"OTA please"}}]})"},
+
+  {"callback_query", R"({"ok":true,"result":[{"update_id":815600003,
+"callback_query":{"id":"430412345678901234","from":{"id":100200300,"is_bot":false,"first_name":"Alex","last_name":"Doe","username":"alexdoe","language_code":"en"},"message":{"message_id":4213,"from":{"id":6000000001,"is_bot":true,"first_name":"Home Bot","username":"home_esp_bot"},"chat":{"id":100200300,"first_name":"Alex","last_name":"Doe","username":"alexdoe","type":"private"},"date":1704067300,"text":"Light is OFF","reply_markup":{"inline_keyboard":[[{"text":"Turn on","callback_data":"light_on"},{"text":"Turn off","callback_data":"light_off"}]]}},"chat_instance":"-4856170398564873412","data":"light_on"}}]})"},
+
+  {"channel_post", R"({"ok":true,"result":[{"update_id":815600004,
+"channel_post":{"message_id":87,"sender_chat":{"id":-1001234567890,"title":"Greenhouse alerts","username":"greenhouse_alerts","type":"channel"},"chat":{"id":-1001234567890,"title":"Greenhouse alerts","username":"greenhouse_alerts","type":"channel"},"date":1704067400,"text":"Humidity below 40% in bay 3"}}]})"},
+
+  {"edited_message", R"({"ok":true,"result":[{"update_id":815600005,
+"edited_message":{"message_id":4210,"from":{"id":100200300,"is_bot":false,"first_name":"Alex","last_name":"Doe","username":"alexdoe","language_code":"en"},"chat":{"id":-1009876543210,"title":"Family","type":"supergroup"},"date":1704067000,"edit_date":1704067450,"text":"/set thermostat 21.5"}}]})"},
+
+  {"contact", R"({"ok":true,"result":[{"update_id":815600006,
+"message":{"message_id":4214,"from":{"id":100200300,"is_bot":false,"first_name":"Alex","last_name":"Doe","username":"alexdoe","language_code":"en"},"chat":{"id":100200300,"first_name":"Alex","last_name":"Doe","username":"alexdoe","type":"private"},"date":1704067500,"contact":{"phone_number":"+15555550123","first_name":"Sam","last_name":"Roe","user_id":100200400}}}]})"},
+
+  {"location", R"({"ok":true,"result":[{"update_id":815600007,
+"message":{"message_id":4215,"from":{"id":100200300,"is_bot":false,"first_name":"Alex","last_name":"Doe","username":"alexdoe","language_code":"en"},"chat":{"id":100200300,"first_name":"Alex","last_name":"Doe","username":"alexdoe","type":"private"},"date":1704067560,"location":{"latitude":52.370216,"longitude":4.895168}}}]})"},
+};
+
+static const char getFileBody[] =
+    R"({"ok":true,"result":{"file_id":"BQACAgQAAxkBAAIQdGWYk3m2nYq0Xx5f4mB2YxwAAQbPZwACHhQAAlbqyVB9nq7kZx7aHjQE","file_unique_id":"AgADHhQAAlbqyVA","file_size":912384,"file_path":"documents/file_17.bin"}})";
+
+static const char sendMessageBody[] =
+    R"({"ok":true,"result":{"message_id":4216,"from":{"id":6000000001,"is_bot":true,"first_name":"Home Bot","username":"home_esp_bot"},"chat":{"id":100200300,"first_name":"Alex","last_name":"Doe","username":"alexdoe","type":"private"},"date":1704067600,"text":"Kitchen: 21.4 C, 48% RH, lights off"}})";
+
+static const char emptyUpdatesBody[] = R"({"ok":true,"result":[]})";
+
+#endif
@@ -0,0 +1,92 @@
+/*******************************************************************
+    Echo bot written with coroutines (C++20, see TelegramCoroutines.h).
+    /countdown counts down in that chat, one number a second, while
+    other chats keep getting their echoes.
+
+    TELEGRAM_BOT_TOKEN   bot token from BotFather (required)
+    TELEGRAM_API_HOST    Bot API server, defaults to api.telegram.org
+    TELEGRAM_API_PORT    port of that server, defaults to 443
+    TELEGRAM_API_TLS     set to 0 for a plain-HTTP local server
+ *******************************************************************/
+
+#include <stdio.h>
+#include <stdlib.h>
+
+#include <PosixClient.h>
+#include <TelegramCoroutines.h>
+#ifdef TELEGRAM_HAS_OPENSSL
+#include <OpenSSLClient.h>
+#endif
+
+static String env(const char *name, const char *fallback) {
+  const char *value = getenv(name);
+  return value && *value ? String(value) : String(fallback);
+}
+
+TelegramTask countdown(TelegramCoroutines &co, String chat_id) {
+  for (int i = 5; i > 0; i--) {
+    co_await co.sendMessage(chat_id, String(i));
+    co_await co.sleep(1000);
+  }
+  co_await co.sendMessage(chat_id, "Lift off");
+}
+
+TelegramTask echo(TelegramCoroutines &co, String chat_id, String text) {
+  TelegramReply reply = co_await co.sendMessage(chat_id, text);
+  if (!reply.result.ok) {
+    printf("echo to %s failed: %d\n", chat_id.c_str(), reply.result.errorCode);
+  }
+}
+
+TelegramTask poller(TelegramCoroutines &co) {
+  for (;;) {
+    int numNewMessages = co_await co.getUpdates();
+    for (int i = 0; i < numNewMessages; i++) {
+      const telegramMessage &message = co.bot.messages[i];
+      if (message.text == "/countdown") {
+        countdown(co, message.chat_id);
+      } else {
+        echo(co, message.chat_id, message.text);
+      }
+    }
+  }
+}
+
+int main() {
+  String token = env("TELEGRAM_BOT_TOKEN", "");
+  if (token.isEmpty()) {
+    fprintf(stderr, "TELEGRAM_BOT_TOKEN is not set\n");
+    return 1;
+  }
+
+  String host = env("TELEGRAM_API_HOST", TELEGRAM_HOST);
+  bool tls = env("TELEGRAM_API_TLS", "1") != "0";
+  int port = env("TELEGRAM_API_PORT", tls ? "443" : "80").toInt();
+
+  // One connection long-polls, the other carries the replies
+  PosixClient plainPoll, plainSend;
+#ifdef TELEGRAM_HAS_OPENSSL
+  OpenSSLClient securePoll, secureSend;
+  Client &pollClient = tls ? (Client &)securePoll : (Client &)plainPoll;
+  Client &sendClient = tls ? (Client &)secureSend : (Client &)plainSend;
+#else
+  if (tls) {
+    fprintf(stderr, "Built without OpenSSL, set TELEGRAM_API_TLS=0\n");
+    return 1;
+  }
+  Client &pollClient = plainPoll;
+  Client &sendClient = plainSend;
+#endif
+
+  UniversalTelegramBot bot(token, pollClient);
+  bot.addClient(sendClient);
+  bot.setServer(host, port, tls);
+  bot.longPoll = 30;
+
+  TelegramCoroutines co(bot);
+  poller(co);
+  for (;;) {
+    co.poll();
+    delay(1);
+  }
+}
@@ -0,0 +1,83 @@
+/*******************************************************************
+    A Telegram bot that echoes back what it's sent, built natively on
+    Linux with the host build of UniversalTelegramBot.
+
+    TELEGRAM_BOT_TOKEN   bot token from BotFather (required)
+    TELEGRAM_API_HOST    Bot API server, defaults to api.telegram.org
+    TELEGRAM_API_PORT    port of that server, defaults to 443
+    TELEGRAM_API_TLS     set to 0 for a plain-HTTP local server
+    TELEGRAM_RECORD      file to record the session to, for
+                         telegram_replay (token redacted)
+    TELEGRAM_OFFSET_FILE file to keep the update offset in, so a
+                         restarted bot goes on where it stopped
+ *******************************************************************/
+
+#include <stdio.h>
+#include <stdlib.h>
+
+#include <PosixClient.h>
+#include <RecordingClient.h>
+#include <UniversalTelegramBot.h>
+#ifdef TELEGRAM_HAS_OPENSSL
+#include <OpenSSLClient.h>
+#endif
+
+static String env(const char *name, const char *fallback) {
+  const char *value = getenv(name);
+  return value && *value ? String(value) : String(fallback);
+}
+
+int main() {
+  String token = env("TELEGRAM_BOT_TOKEN", "");
+  if (token.isEmpty()) {
+    fprintf(stderr, "TELEGRAM_BOT_TOKEN is not set\n");
+    return 1;
+  }
+
+  String host = env("TELEGRAM_API_HOST", TELEGRAM_HOST);
+  bool tls = env("TELEGRAM_API_TLS", "1") != "0";
+  int port = env("TELEGRAM_API_PORT", tls ? "443" : "80").toInt();
+
+  PosixClient plainClient;
+#ifdef TELEGRAM_HAS_OPENSSL
+  OpenSSLClient secureClient;
+  Client &client = tls ? (Client &)secureClient : (Client &)plainClient;
+#else
+  if (tls) {
+    fprintf(stderr, "Built without OpenSSL, set TELEGRAM_API_TLS=0\n");
+    return 1;
+  }
+  Client &client = plainClient;
+#endif
+
+  String recordPath = env("TELEGRAM_RECORD", "");
+  RecordingClient recorder(client, recordPath.isEmpty() ? "/dev/null" : recordPath.c_str(), token);
+  if (!recordPath.isEmpty() && !recorder.ok()) {
+    perror(recordPath.c_str());
+    return 1;
+  }
+
+  UniversalTelegramBot bot(token, recordPath.isEmpty() ? client : (Client &)recorder);
+  bot.setServer(host, port, tls);
+  bot.longPoll = 30;
+  bot.polling.adaptive = true;
+
+  String offsetPath = env("TELEGRAM_OFFSET_FILE", "");
+  TelegramFileOffsetStore offsetStore(offsetPath.c_str());
+  if (!offsetPath.isEmpty()) bot.setOffsetStore(&offsetStore);
+
+  if (bot.getMe()) {
+    Serial.print(F("Running as @"));
+    Serial.println(bot.userName);
+  }
+
+  for (;;) {
+    int numNewMessages = bot.getUpdates(bot.last_message_received + 1);
+    for (int i = 0; i < numNewMessages; i++) {
+      bot.sendMessage(bot.messages[i].chat_id, bot.messages[i].text, "");
+    }
+    recorder.sync(); // keep the recording usable if the bot is killed
+    Serial.flush();
+    delay(bot.polling.untilNextPoll());
+  }
+}
@@ -0,0 +1,88 @@
+/*******************************************************************
+    Echo bots for several tokens at once, all on one thread with
+    EpollBotEngine.
+
+    TELEGRAM_BOT_TOKENS  comma separated bot tokens (required)
+    TELEGRAM_API_HOST    Bot API server, defaults to api.telegram.org
+    TELEGRAM_API_PORT    port of that server, defaults to 443
+    TELEGRAM_API_TLS     set to 0 for a plain-HTTP local server
+ *******************************************************************/
+
+#include <stdio.h>
+#include <stdlib.h>
+
+#include <vector>
+
+#include <EpollBotEngine.h>
+#include <PosixClient.h>
+#include <UniversalTelegramBot.h>
+#ifdef TELEGRAM_HAS_OPENSSL
+#include <OpenSSLClient.h>
+#endif
+
+static String env(const char *name, const char *fallback) {
+  const char *value = getenv(name);
+  return value && *value ? String(value) : String(fallback);
+}
+
+static PosixClient *newClient(bool tls) {
+#ifdef TELEGRAM_HAS_OPENSSL
+  if (tls) return new OpenSSLClient();
+#else
+  (void)tls;
+#endif
+  return new PosixClient();
+}
+
+static void echo(UniversalTelegramBot &bot, telegramMessage &message) {
+  bot.sendMessageAsync(message.chat_id, message.text);
+}
+
+int main() {
+  String tokens = env("TELEGRAM_BOT_TOKENS", "");
+  if (tokens.isEmpty()) {
+    fprintf(stderr, "TELEGRAM_BOT_TOKENS is not set\n");
+    return 1;
+  }
+
+  String host = env("TELEGRAM_API_HOST", TELEGRAM_HOST);
+  bool tls = env("TELEGRAM_API_TLS", "1") != "0";
+  int port = env("TELEGRAM_API_PORT", tls ? "443" : "80").toInt();
+#ifndef TELEGRAM_HAS_OPENSSL
+  if (tls) {
+    fprintf(stderr, "Built without OpenSSL, set TELEGRAM_API_TLS=0\n");
+    return 1;
+  }
+#endif
+
+  // Bots and clients live as long as the engine, i.e. until exit
+  EpollBotEngine engine;
+  std::vector<UniversalTelegramBot *> bots;
+  int start = 0;
+  while (start < (int)tokens.length()) {
+    int end = tokens.indexOf(',', start);
+    if (end < 0) end = tokens.length();
+    String token = tokens.substring(start, end);
+    start = end + 1;
+    if (token.isEmpty()) continue;
+
+    // One connection for the long poll, one for the replies
+    UniversalTelegramBot *bot = new UniversalTelegramBot(token, *newClient(tls));
+    bot->addClient(*newClient(tls));
+    bot->setServer(host, port, tls);
+    bot->longPoll = 30;
+    if (!engine.add(*bot, echo)) {
+      fprintf(stderr, "Bot %u could not be started\n", (unsigned)bots.size() + 1);
+      return 1;
+    }
+    bots.push_back(bot);
+  }
+
+  Serial.print(F("Running "));
+  Serial.print((int)bots.size());
+  Serial.println(F(" bots"));
+  for (;;) {
+    engine.runOnce(1000);
+    Serial.flush();
+  }
+}
@@ -0,0 +1,112 @@
+/*******************************************************************
+    The echo bot run by several nodes sharing one token through
+    TelegramRelay. Start one process per node, e.g. three on this
+    machine against the mock server:
+
+      RELAY_NODE_ID=1 RELAY_PORT=4211 RELAY_PEERS=127.0.0.1:4212,127.0.0.1:4213 ./RelayBot
+      RELAY_NODE_ID=2 RELAY_PORT=4212 RELAY_PEERS=127.0.0.1:4211,127.0.0.1:4213 ./RelayBot
+      ...
+
+    Only the leader polls. Every node gets every message and the one
+    whose id matches the message's length modulo the number of nodes
+    answers it, through the leader. Stop the leader and the next node
+    takes over.
+
+    TELEGRAM_BOT_TOKEN   bot token from BotFather (required)
+    TELEGRAM_API_HOST    Bot API server, defaults to api.telegram.org
+    TELEGRAM_API_PORT    port of that server, defaults to 443
+    TELEGRAM_API_TLS     set to 0 for a plain-HTTP local server
+    RELAY_NODE_ID        this node, 1 and up (required)
+    RELAY_PORT           UDP port to listen on, defaults to 4210
+    RELAY_PEERS          comma separated host:port of the other nodes
+ *******************************************************************/
+
+#include <stdio.h>
+#include <stdlib.h>
+
+#include <PosixClient.h>
+#include <PosixUDP.h>
+#include <TelegramRelay.h>
+#include <UniversalTelegramBot.h>
+#ifdef TELEGRAM_HAS_OPENSSL
+#include <OpenSSLClient.h>
+#endif
+
+static String env(const char *name, const char *fallback) {
+  const char *value = getenv(name);
+  return value && *value ? String(value) : String(fallback);
+}
+
+int main() {
+  String token = env("TELEGRAM_BOT_TOKEN", "");
+  int nodeId = env("RELAY_NODE_ID", "0").toInt();
+  if (token.isEmpty() || nodeId <= 0) {
+    fprintf(stderr, "TELEGRAM_BOT_TOKEN and RELAY_NODE_ID must be set\n");
+    return 1;
+  }
+
+  String host = env("TELEGRAM_API_HOST", TELEGRAM_HOST);
+  bool tls = env("TELEGRAM_API_TLS", "1") != "0";
+  int port = env("TELEGRAM_API_PORT", tls ? "443" : "80").toInt();
+
+  PosixClient plainClient;
+#ifdef TELEGRAM_HAS_OPENSSL
+  OpenSSLClient secureClient;
+  Client &client = tls ? (Client &)secureClient : (Client &)plainClient;
+#else
+  if (tls) {
+    fprintf(stderr, "Built without OpenSSL, set TELEGRAM_API_TLS=0\n");
+    return 1;
+  }
+  Client &client = plainClient;
+#endif
+
+  UniversalTelegramBot bot(token, client);
+  bot.setServer(host, port, tls);
+  bot.longPoll = 1;
+
+  PosixUDP udp;
+  if (!udp.begin(env("RELAY_PORT", "4210").toInt())) {
+    perror("RELAY_PORT");
+    return 1;
+  }
+  TelegramRelay relay(bot, udp, nodeId);
+
+  String peers = env("RELAY_PEERS", "");
+  int start = 0;
+  while (start < (int)peers.length()) {
+    int end = peers.indexOf(',', start);
+    if (end < 0) end = peers.length();
+    String peer = peers.substring(start, end);
+    start = end + 1;
+
+    int colon = peer.indexOf(':');
+    unsigned a, b, c, d;
+    if (colon < 0 || sscanf(peer.substring(0, colon).c_str(), "%u.%u.%u.%u", &a, &b, &c, &d) != 4 ||
+        !relay.addPeer(IPAddress(a, b, c, d), peer.substring(colon + 1).toInt())) {
+      fprintf(stderr, "Bad peer %s\n", peer.c_str());
+      return 1;
+    }
+  }
+  int nodes = 1 + (int)(peers.length() > 0);
+  for (unsigned i = 0; i < peers.length(); i++) {
+    if (peers[i] == ',') nodes++;
+  }
+
+  uint16_t leader = 0;
+  for (;;) {
+    int n = relay.getUpdates();
+    for (int i = 0; i < n; i++) {
+      telegramMessage &message = bot.messages[i];
+      if ((int)message.text.length() % nodes == nodeId - 1) {
+        relay.sendMessage(message.chat_id, message.text);
+      }
+    }
+    if (relay.leader() != leader) {
+      leader = relay.leader();
+      printf("node %d: leader is now %u\n", nodeId, leader);
+    }
+    if (!relay.isLeader()) delay(10);
+    Serial.flush();
+  }
+}
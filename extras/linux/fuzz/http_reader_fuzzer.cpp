@@ -0,0 +1,40 @@
+/*
+   libFuzzer target for the response reader: TelegramHttpResponse's header /
+   body state machine, driven through UniversalTelegramBot::readHTTPAnswer.
+
+   Input layout: byte 0 is the largest fragment (0 = all at once), bytes 1-2
+   seed the fragment sizes and stalls, byte 3 picks maxMessageLength, the
+   rest is the raw response as it would come off the socket. Any difference
+   from the unfragmented reference or a broken framing invariant (see
+   reader_check.h) aborts.
+
+     cmake -S extras/linux -B build-fuzz -DUTB_FUZZ=ON -DCMAKE_CXX_COMPILER=clang++
+     cmake --build build-fuzz --target http_reader_fuzzer
+     ./build/reader_stress --iterations 2000 --write-corpus corpus
+     ./build-fuzz/http_reader_fuzzer corpus
+ */
+
+#include <stdint.h>
+#include <stdio.h>
+#include <stdlib.h>
+
+#include "reader_check.h"
+
+extern "C" int LLVMFuzzerTestOneInput(const uint8_t *data, size_t size) {
+  static FragmentingClient client;
+  static UniversalTelegramBot bot("123456:TOKEN", client);
+
+  if (size < 4) return 0;
+  client.maxFragment = data[0];
+  client.maxStall = data[1] & 3;
+  uint64_t seed = data[1] | (data[2] << 8);
+  // Small limits make truncation reachable with short inputs
+  bot.maxMessageLength = data[3] < 128 ? data[3] : 1500;
+
+  std::string error = checkReader(bot, client, data + 4, size - 4, seed);
+  if (!error.empty()) {
+    fprintf(stderr, "%s\n", error.c_str());
+    abort();
+  }
+  return 0;
+}
@@ -0,0 +1,106 @@
+/*
+   Differential check of UniversalTelegramBot::readHTTPAnswer, shared by the
+   stress harness and the fuzz target.
+
+   The same bytes are run through a TelegramHttpResponse in one go, which is
+   the reference, and through readHTTPAnswer over a FragmentingClient. How
+   the network splits a response must not change the outcome: both have to
+   agree on success, the body and where the response ended. On top of that
+   the framing invariants are checked:
+     - the body never exceeds maxMessageLength
+     - a Content-Length body that finished has exactly that many bytes
+     - nothing past the end of the response is consumed
+ */
+
+#ifndef reader_check_h
+#define reader_check_h
+
+#include <stdio.h>
+#include <string.h>
+
+#include <string>
+
+#include <FragmentingClient.h>
+#include <UniversalTelegramBot.h>
+
+struct ReaderOutcome {
+  bool finished = false;
+  int status = 0;
+  std::string body;
+  size_t consumed = 0;  // bytes read up to and including the last one parsed
+  bool chunked = false;
+  long contentLength = -1;
+  long bodyLength = 0;
+};
+
+// The reference: every byte fed straight into the parser, with a close at
+// the end of the data
+static inline ReaderOutcome referenceParse(const uint8_t *data, size_t size, int maxBodyLength) {
+  String body;
+  TelegramHttpResponse response;
+  response.begin(&body, maxBodyLength);
+
+  ReaderOutcome outcome;
+  size_t i = 0;
+  while (i < size && !response.feed((char)data[i])) i++;
+  outcome.consumed = i < size ? i + 1 : size;
+  if (!response.finished()) response.closed();
+
+  outcome.finished = response.finished();
+  outcome.status = response.status;
+  outcome.body.assign(body.c_str(), body.length());
+  outcome.chunked = response.chunked;
+  outcome.contentLength = response.contentLength;
+  outcome.bodyLength = response.bodyLength;
+  return outcome;
+}
+
+// Returns an empty string when the fragmented read agrees with the
+// reference, otherwise what went wrong
+static inline std::string checkReader(UniversalTelegramBot &bot, FragmentingClient &client,
+                                      const uint8_t *data, size_t size, uint64_t seed,
+                                      ReaderOutcome *out = nullptr) {
+  ReaderOutcome expected = referenceParse(data, size, bot.maxMessageLength);
+
+  client.load(data, size, seed);
+  String body;
+  bool finished = bot.readHTTPAnswer(body);
+  if (out) {
+    out->finished = finished;
+    out->body.assign(body.c_str(), body.length());
+    out->consumed = client.position();
+  }
+
+  char message[160];
+  if (finished != expected.finished) {
+    snprintf(message, sizeof(message), "finished %d, reference %d", finished,
+             expected.finished);
+    return message;
+  }
+  if (body.length() != expected.body.size() ||
+      memcmp(body.c_str(), expected.body.data(), body.length()) != 0) {
+    snprintf(message, sizeof(message), "body of %u bytes differs from reference (%zu bytes)",
+             body.length(), expected.body.size());
+    return message;
+  }
+  if ((int)body.length() > bot.maxMessageLength) {
+    snprintf(message, sizeof(message), "body of %u bytes exceeds maxMessageLength %d",
+             body.length(), bot.maxMessageLength);
+    return message;
+  }
+  if (finished && client.position() != expected.consumed) {
+    snprintf(message, sizeof(message), "read %zu bytes, response ends after %zu",
+             client.position(), expected.consumed);
+    return message;
+  }
+
+  if (expected.finished && !expected.chunked && expected.contentLength >= 0 &&
+      expected.bodyLength != expected.contentLength) {
+    snprintf(message, sizeof(message), "Content-Length %ld but %ld body bytes",
+             expected.contentLength, expected.bodyLength);
+    return message;
+  }
+  return std::string();
+}
+
+#endif
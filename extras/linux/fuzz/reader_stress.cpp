@@ -0,0 +1,292 @@
+/*
+   Stress harness for UniversalTelegramBot::readHTTPAnswer. Recorded and
+   generated responses are fed through a FragmentingClient with random
+   fragment sizes and stalls, and every read is checked against the
+   unfragmented reference (see reader_check.h) and against the body the
+   response was built from.
+
+     reader_stress [--iterations N] [--seed S] [--max-fragment B]
+                   [--max-delay MS] [--write-corpus DIR]
+
+   Generated responses cover Content-Length, chunked bodies with random
+   chunk sizes, extensions and trailers, bodies delimited by the connection
+   closing, 100 Continue, oddly cased and overlong headers, bodies over
+   maxMessageLength, a second response pipelined behind the first, and
+   connections dropped mid-body. At the end the reader's throughput is
+   reported for whole and for fragmented delivery.
+
+   --write-corpus stores every generated case in the input format of
+   http_reader_fuzzer, as a seed corpus for it.
+ */
+
+#include <ctype.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include <chrono>
+#include <string>
+#include <vector>
+
+#include <ScriptedClient.h>
+
+#include "../bench/corpus.h"
+#include "reader_check.h"
+
+static uint64_t rngState = 1;
+
+static uint64_t nextRandom() {
+  rngState ^= rngState >> 12;
+  rngState ^= rngState << 25;
+  rngState ^= rngState >> 27;
+  return rngState * 2685821657736338717ULL;
+}
+
+static size_t randomBelow(size_t n) {
+  return n ? (size_t)(nextRandom() % n) : 0;
+}
+
+struct GeneratedCase {
+  std::string kind;
+  std::string response;
+  std::string body;      // what readHTTPAnswer should return, before truncation
+  bool complete = true;  // readHTTPAnswer should report success
+  size_t trailing = 0;   // bytes after the response that must stay unread
+};
+
+static std::string randomBody() {
+  size_t pick = randomBelow(4);
+  if (pick < 2) {
+    size_t n = sizeof(updateCorpus) / sizeof(updateCorpus[0]);
+    return updateCorpus[randomBelow(n)].body;
+  }
+  if (pick == 2) return emptyUpdatesBody;
+
+  // Arbitrary bytes, including CR, LF and NUL, which the body must carry
+  // through untouched
+  std::string body(randomBelow(3000), '\0');
+  for (size_t i = 0; i < body.size(); i++) body[i] = (char)nextRandom();
+  return body;
+}
+
+static std::string header(const char *name, const std::string &value) {
+  std::string line = name;
+  // Header names are case-insensitive, servers differ
+  if (randomBelow(3) == 0) {
+    for (size_t i = 0; i < line.size(); i++) line[i] = (char)tolower(line[i]);
+  } else if (randomBelow(3) == 0) {
+    for (size_t i = 0; i < line.size(); i++) line[i] = (char)toupper(line[i]);
+  }
+  return line + ":" + (randomBelow(2) ? " " : "") + value + "\r\n";
+}
+
+static std::string statusAndHeaders() {
+  std::string out;
+  if (randomBelow(8) == 0) out += "HTTP/1.1 100 Continue\r\n\r\n";
+  out += "HTTP/1.1 200 OK\r\n";
+  out += header("Server", "nginx/1.18.0");
+  out += header("Date", "Mon, 01 Jan 2024 00:00:00 GMT");
+  if (randomBelow(2)) {
+    // Longer than the parser's line buffer, must be skipped cleanly
+    out += header("Access-Control-Expose-Headers",
+                  "Content-Length,Content-Type,Date,Server,Connection,X-Content-Length: 7");
+  }
+  out += header("Content-Type", "application/json");
+  return out;
+}
+
+static std::string chunkedBody(const std::string &body) {
+  std::string out;
+  char line[64];
+  for (size_t i = 0; i < body.size();) {
+    size_t n = 1 + randomBelow(randomBelow(2) ? 16 : 1024);
+    if (n > body.size() - i) n = body.size() - i;
+    snprintf(line, sizeof(line), randomBelow(2) ? "%zx" : "%zX", n);
+    out += line;
+    if (randomBelow(6) == 0) out += ";name=value";
+    out += "\r\n";
+    out.append(body, i, n);
+    out += "\r\n";
+    i += n;
+  }
+  out += "0\r\n";
+  if (randomBelow(4) == 0) out += "X-Trailer: 1\r\n";
+  return out + "\r\n";
+}
+
+static GeneratedCase generate() {
+  GeneratedCase c;
+  c.body = randomBody();
+  std::string head = statusAndHeaders();
+
+  switch (randomBelow(5)) {
+    case 0:
+      c.kind = "length";
+      c.response = head + header("Content-Length", std::to_string(c.body.size())) + "\r\n" +
+                   c.body;
+      break;
+    case 1:
+      c.kind = "chunked";
+      c.response = head + header("Transfer-Encoding", "chunked") + "\r\n" + chunkedBody(c.body);
+      break;
+    case 2:
+      c.kind = "close";
+      c.response = head + header("Connection", "close") + "\r\n" + c.body;
+      break;
+    case 3: {
+      // Another response follows on the same connection; only the first is
+      // ours and the rest must stay in the client
+      c.kind = "pipelined";
+      c.response = head + header("Content-Length", std::to_string(c.body.size())) + "\r\n" +
+                   c.body;
+      std::string next = telegramHttpResponse(emptyUpdatesBody);
+      c.response += next;
+      c.trailing = next.size();
+      break;
+    }
+    default: {
+      // Connection dropped partway through the body
+      c.kind = "dropped";
+      if (c.body.empty()) c.body = emptyUpdatesBody;
+      c.response = head + header("Content-Length", std::to_string(c.body.size())) + "\r\n";
+      c.response.append(c.body, 0, randomBelow(c.body.size()));
+      c.complete = false;
+      break;
+    }
+  }
+  return c;
+}
+
+static unsigned long failures = 0;
+
+static void fail(const GeneratedCase &c, uint64_t seed, const std::string &what) {
+  failures++;
+  if (failures <= 10) {
+    fprintf(stderr, "%s (%zu bytes, fragment seed %llu): %s\n", c.kind.c_str(),
+            c.response.size(), (unsigned long long)seed, what.c_str());
+  }
+}
+
+static void writeCorpusFile(const char *dir, unsigned long index, const std::string &response,
+                            uint8_t maxFragment, uint64_t seed) {
+  char path[4096];
+  snprintf(path, sizeof(path), "%s/generated-%06lu", dir, index);
+  FILE *f = fopen(path, "wb");
+  if (!f) {
+    perror(path);
+    exit(1);
+  }
+  // http_reader_fuzzer input: fragment size, two seed bytes, and 255 for
+  // the default maxMessageLength
+  uint8_t prefix[4] = {maxFragment, (uint8_t)seed, (uint8_t)(seed >> 8), 255};
+  fwrite(prefix, 1, sizeof(prefix), f);
+  fwrite(response.data(), 1, response.size(), f);
+  fclose(f);
+}
+
+// Time spent in readHTTPAnswer for the same response set, delivered whole
+// and in fragments
+static void throughput(const std::vector<GeneratedCase> &cases, size_t maxFragment) {
+  FragmentingClient client;
+  UniversalTelegramBot bot("123456:TOKEN", client, 1 << 20);
+  client.maxStall = 0;
+
+  typedef std::chrono::steady_clock clock;
+  const size_t fragments[] = {0, maxFragment, 1};
+  const char *names[] = {"whole", "fragmented", "byte-by-byte"};
+  for (size_t f = 0; f < 3; f++) {
+    client.maxFragment = fragments[f];
+    unsigned long long bytes = 0;
+    unsigned long responses = 0;
+    clock::time_point start = clock::now();
+    double seconds;
+    do {
+      for (size_t i = 0; i < cases.size(); i++) {
+        client.load(cases[i].response, i + 1);
+        String body;
+        bot.readHTTPAnswer(body);
+        bytes += client.position();
+        responses++;
+      }
+      seconds = std::chrono::duration<double>(clock::now() - start).count();
+    } while (seconds < 0.5);
+
+    printf("%-14s %10.1f MB/s %12.0f responses/s\n", names[f], bytes / seconds / 1e6,
+           responses / seconds);
+  }
+}
+
+int main(int argc, char **argv) {
+  unsigned long iterations = 20000;
+  uint64_t seed = 1;
+  size_t maxFragment = 32;
+  int maxDelayMs = 0;
+  const char *corpusDir = nullptr;
+
+  for (int i = 1; i < argc; i++) {
+    if (!strcmp(argv[i], "--iterations") && i + 1 < argc) {
+      iterations = strtoul(argv[++i], nullptr, 10);
+    } else if (!strcmp(argv[i], "--seed") && i + 1 < argc) {
+      seed = strtoull(argv[++i], nullptr, 10);
+    } else if (!strcmp(argv[i], "--max-fragment") && i + 1 < argc) {
+      maxFragment = strtoul(argv[++i], nullptr, 10);
+    } else if (!strcmp(argv[i], "--max-delay") && i + 1 < argc) {
+      maxDelayMs = atoi(argv[++i]);
+    } else if (!strcmp(argv[i], "--write-corpus") && i + 1 < argc) {
+      corpusDir = argv[++i];
+    } else {
+      fprintf(stderr,
+              "usage: %s [--iterations N] [--seed S] [--max-fragment B] [--max-delay MS]"
+              " [--write-corpus DIR]\n",
+              argv[0]);
+      return 2;
+    }
+  }
+  rngState = seed ? seed : 1;
+
+  FragmentingClient client;
+  client.maxDelayMs = maxDelayMs;
+  UniversalTelegramBot bot("123456:TOKEN", client);
+  // Delays are only there to shake out timing assumptions, not to time out
+  bot.waitForResponse = 1500 + 100 * maxDelayMs;
+
+  std::vector<GeneratedCase> kept;
+  for (unsigned long i = 0; i < iterations; i++) {
+    GeneratedCase c = generate();
+    uint64_t fragmentSeed = nextRandom();
+    client.maxFragment = 1 + randomBelow(maxFragment);
+    client.maxStall = (int)randomBelow(4);
+    // Sometimes well below the body size, to exercise truncation
+    bot.maxMessageLength = randomBelow(4) == 0 ? (int)randomBelow(c.body.size() + 1) : 1 << 20;
+
+    const uint8_t *data = (const uint8_t *)c.response.data();
+    ReaderOutcome got;
+    std::string error = checkReader(bot, client, data, c.response.size(), fragmentSeed, &got);
+    if (!error.empty()) {
+      fail(c, fragmentSeed, error);
+      continue;
+    }
+
+    // And against what the generator meant
+    std::string expected = c.body.substr(0, bot.maxMessageLength);
+    if (got.finished != c.complete) {
+      fail(c, fragmentSeed, got.finished ? "finished a broken response" : "did not finish");
+    } else if (c.complete && got.body != expected) {
+      fail(c, fragmentSeed, "body differs from the one sent");
+    } else if (c.complete && client.remaining() != c.trailing) {
+      fail(c, fragmentSeed, "response boundary off, " + std::to_string(client.remaining()) +
+                                " bytes left instead of " + std::to_string(c.trailing));
+    }
+
+    if (corpusDir) {
+      writeCorpusFile(corpusDir, i, c.response, (uint8_t)client.maxFragment, fragmentSeed);
+    }
+    if (c.complete && kept.size() < 256) kept.push_back(c);
+  }
+
+  printf("%lu responses, %lu failures\n", iterations, failures);
+  if (failures) return 1;
+
+  throughput(kept, maxFragment);
+  return 0;
+}
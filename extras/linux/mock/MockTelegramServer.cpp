@@ -0,0 +1,898 @@
+/*
+   Mock Telegram Bot API server for deterministic load and latency tests.
+ */
+
+#include "MockTelegramServer.h"
+
+#include <errno.h>
+#include <fcntl.h>
+#include <netinet/in.h>
+#include <netinet/tcp.h>
+#include <poll.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <sys/eventfd.h>
+#include <sys/socket.h>
+#include <time.h>
+#include <unistd.h>
+
+#include <algorithm>
+#include <vector>
+
+#include <ArduinoJson.h>
+
+// Fixed epoch for message dates so runs are reproducible
+#define MOCK_DATE_BASE 1700000000L
+#define MOCK_BOT_ID 1000000001LL
+
+static uint64_t nowMs() {
+  struct timespec ts;
+  clock_gettime(CLOCK_MONOTONIC, &ts);
+  return (uint64_t)ts.tv_sec * 1000 + ts.tv_nsec / 1000000;
+}
+
+static std::string jsonEscape(const std::string &s) {
+  std::string out;
+  out.reserve(s.size() + 2);
+  out += '"';
+  for (unsigned char c : s) {
+    switch (c) {
+      case '"': out += "\\\""; break;
+      case '\\': out += "\\\\"; break;
+      case '\n': out += "\\n"; break;
+      case '\r': out += "\\r"; break;
+      case '\t': out += "\\t"; break;
+      default:
+        if (c < 0x20) {
+          char buf[8];
+          snprintf(buf, sizeof(buf), "\\u%04x", c);
+          out += buf;
+        } else {
+          out += (char)c;
+        }
+    }
+  }
+  out += '"';
+  return out;
+}
+
+static std::string urlDecode(const std::string &s) {
+  std::string out;
+  for (size_t i = 0; i < s.size(); i++) {
+    if (s[i] == '+') {
+      out += ' ';
+    } else if (s[i] == '%' && i + 2 < s.size()) {
+      out += (char)strtol(s.substr(i + 1, 2).c_str(), nullptr, 16);
+      i += 2;
+    } else {
+      out += s[i];
+    }
+  }
+  return out;
+}
+
+static std::string lower(std::string s) {
+  for (char &c : s) {
+    if (c >= 'A' && c <= 'Z') c += 'a' - 'A';
+  }
+  return s;
+}
+
+static void parseForm(const std::string &s, std::map<std::string, std::string> &params) {
+  size_t pos = 0;
+  while (pos < s.size()) {
+    size_t amp = s.find('&', pos);
+    if (amp == std::string::npos) amp = s.size();
+    std::string pair = s.substr(pos, amp - pos);
+    size_t eq = pair.find('=');
+    if (eq != std::string::npos) {
+      params[urlDecode(pair.substr(0, eq))] = urlDecode(pair.substr(eq + 1));
+    } else if (!pair.empty()) {
+      params[urlDecode(pair)] = "";
+    }
+    pos = amp + 1;
+  }
+}
+
+// Decodes a complete chunked body starting at in[start]. Returns false while
+// more data is needed; on success consumed is the offset just past it.
+static bool decodeChunked(const std::string &in, size_t start, std::string &out, size_t &consumed) {
+  std::string body;
+  size_t pos = start;
+  for (;;) {
+    size_t eol = in.find("\r\n", pos);
+    if (eol == std::string::npos) return false;
+    size_t size = strtoul(in.substr(pos, eol - pos).c_str(), nullptr, 16);
+    pos = eol + 2;
+    if (size == 0) {
+      // Skip trailers up to the blank line
+      for (;;) {
+        eol = in.find("\r\n", pos);
+        if (eol == std::string::npos) return false;
+        bool blank = eol == pos;
+        pos = eol + 2;
+        if (blank) break;
+      }
+      out.swap(body);
+      consumed = pos;
+      return true;
+    }
+    if (in.size() < pos + size + 2) return false;
+    body.append(in, pos, size);
+    pos += size + 2;
+  }
+}
+
+struct MockTelegramServer::Connection {
+  int fd = -1;
+  std::string in;
+  std::string out;
+  size_t outPos = 0;
+  size_t dropAt = std::string::npos;
+  uint64_t nextWriteMs = 0;
+  bool closeAfterWrite = false;
+
+  // Current request
+  std::string verb;
+  std::string path;
+  std::map<std::string, std::string> headers;
+  std::map<std::string, std::string> params;
+  std::string uploadName;
+  size_t uploadSize = 0;
+
+  // Parked getUpdates long poll
+  bool parked = false;
+  uint64_t deadlineMs = 0;
+  long offset = 0;
+  int limit = 100;
+};
+
+MockTelegramServer::MockTelegramServer(const MockServerOptions &options)
+    : _options(options), _port(options.port), _listenFd(-1), _wakeFd(-1), _running(false),
+      _nextUpdateId(100000), _nextMessageId(1), _nextFileId(1), _rng(options.seed ? options.seed : 1) {}
+
+MockTelegramServer::~MockTelegramServer() {
+  stop();
+}
+
+bool MockTelegramServer::bind() {
+  _listenFd = socket(AF_INET, SOCK_STREAM | SOCK_NONBLOCK | SOCK_CLOEXEC, 0);
+  if (_listenFd < 0) return false;
+  int one = 1;
+  setsockopt(_listenFd, SOL_SOCKET, SO_REUSEADDR, &one, sizeof(one));
+
+  struct sockaddr_in addr;
+  memset(&addr, 0, sizeof(addr));
+  addr.sin_family = AF_INET;
+  addr.sin_addr.s_addr = htonl(INADDR_LOOPBACK);
+  addr.sin_port = htons(_options.port);
+  if (::bind(_listenFd, (struct sockaddr *)&addr, sizeof(addr)) != 0 || listen(_listenFd, 128) != 0) {
+    close(_listenFd);
+    _listenFd = -1;
+    return false;
+  }
+
+  socklen_t len = sizeof(addr);
+  getsockname(_listenFd, (struct sockaddr *)&addr, &len);
+  _port = ntohs(addr.sin_port);
+
+  _wakeFd = eventfd(0, EFD_NONBLOCK | EFD_CLOEXEC);
+  return _wakeFd >= 0;
+}
+
+bool MockTelegramServer::start() {
+  if (_running) return true;
+  if (!bind()) return false;
+  _running = true;
+  _thread = std::thread(&MockTelegramServer::loop, this);
+  return true;
+}
+
+bool MockTelegramServer::run() {
+  if (!bind()) return false;
+  _running = true;
+  loop();
+  return true;
+}
+
+void MockTelegramServer::stop() {
+  if (!_running) return;
+  _running = false;
+  wake();
+  if (_thread.joinable()) _thread.join();
+}
+
+void MockTelegramServer::wake() {
+  if (_wakeFd >= 0) {
+    uint64_t one = 1;
+    ssize_t rc = write(_wakeFd, &one, sizeof(one));
+    (void)rc;
+  }
+}
+
+bool MockTelegramServer::chance(double probability) {
+  if (probability <= 0) return false;
+  // xorshift64*, deterministic for a given seed
+  _rng ^= _rng >> 12;
+  _rng ^= _rng << 25;
+  _rng ^= _rng >> 27;
+  uint64_t r = _rng * 2685821657736338717ULL;
+  return (double)(r >> 11) / (double)(1ULL << 53) < probability;
+}
+
+/*********************************************/
+/*  Event loop                               */
+/*********************************************/
+
+void MockTelegramServer::loop() {
+  std::vector<struct pollfd> fds;
+  std::vector<Connection *> order;
+
+  while (_running) {
+    uint64_t now = nowMs();
+    int timeout = 100;
+
+    fds.clear();
+    order.clear();
+    fds.push_back({_listenFd, POLLIN, 0});
+    fds.push_back({_wakeFd, POLLIN, 0});
+    for (auto &entry : _connections) {
+      Connection *c = entry.second;
+      short events = POLLIN;
+      if (c->outPos < c->out.size()) {
+        if (c->nextWriteMs <= now) {
+          events |= POLLOUT;
+        } else if ((int)(c->nextWriteMs - now) < timeout) {
+          timeout = (int)(c->nextWriteMs - now);
+        }
+      }
+      if (c->parked && c->deadlineMs > now && (int)(c->deadlineMs - now) < timeout) {
+        timeout = (int)(c->deadlineMs - now);
+      }
+      fds.push_back({c->fd, events, 0});
+      order.push_back(c);
+    }
+
+    if (poll(fds.data(), fds.size(), timeout) < 0 && errno != EINTR) break;
+
+    if (fds[1].revents & POLLIN) {
+      uint64_t value;
+      ssize_t rc = read(_wakeFd, &value, sizeof(value));
+      (void)rc;
+    }
+    if (fds[0].revents & POLLIN) accept();
+
+    for (size_t i = 0; i < order.size(); i++) {
+      Connection *c = order[i];
+      short revents = fds[i + 2].revents;
+      if (revents & (POLLIN | POLLHUP | POLLERR)) readFrom(*c);
+      if (c->fd >= 0 && (revents & POLLOUT)) writeTo(*c);
+    }
+
+    // New updates or expired deadlines complete parked long polls
+    expireLongPolls();
+
+    for (auto it = _connections.begin(); it != _connections.end();) {
+      if (it->second->fd < 0) {
+        delete it->second;
+        it = _connections.erase(it);
+      } else {
+        ++it;
+      }
+    }
+  }
+
+  for (auto &entry : _connections) {
+    close(entry.second->fd);
+    delete entry.second;
+  }
+  _connections.clear();
+  close(_listenFd);
+  close(_wakeFd);
+  _listenFd = _wakeFd = -1;
+}
+
+void MockTelegramServer::accept() {
+  for (;;) {
+    int fd = accept4(_listenFd, nullptr, nullptr, SOCK_NONBLOCK | SOCK_CLOEXEC);
+    if (fd < 0) return;
+    int one = 1;
+    setsockopt(fd, IPPROTO_TCP, TCP_NODELAY, &one, sizeof(one));
+    Connection *c = new Connection();
+    c->fd = fd;
+    _connections[fd] = c;
+    std::lock_guard<std::mutex> guard(_lock);
+    _stats.connections++;
+  }
+}
+
+static void closeConnection(int &fd) {
+  if (fd >= 0) {
+    close(fd);
+    fd = -1;
+  }
+}
+
+void MockTelegramServer::readFrom(Connection &c) {
+  char buf[16384];
+  for (;;) {
+    ssize_t n = recv(c.fd, buf, sizeof(buf), 0);
+    if (n > 0) {
+      c.in.append(buf, n);
+      std::lock_guard<std::mutex> guard(_lock);
+      _stats.bytesIn += n;
+      continue;
+    }
+    if (n == 0 || (errno != EAGAIN && errno != EWOULDBLOCK && errno != EINTR)) {
+      closeConnection(c.fd);
+      return;
+    }
+    break;
+  }
+
+  // One request at a time per connection, like the library sends them
+  while (c.fd >= 0 && !c.parked && c.outPos >= c.out.size() && parseRequest(c)) {
+    handle(c);
+    if (c.fd >= 0 && c.outPos < c.out.size()) writeTo(c);
+  }
+}
+
+void MockTelegramServer::writeTo(Connection &c) {
+  uint64_t now = nowMs();
+  while (c.fd >= 0 && c.outPos < c.out.size() && c.nextWriteMs <= now) {
+    size_t end = c.out.size();
+    if (c.dropAt < end) end = c.dropAt;
+    size_t n = end - c.outPos;
+    if (_options.slowBytes > 0 && n > _options.slowBytes) n = _options.slowBytes;
+
+    if (n > 0) {
+      ssize_t sent = send(c.fd, c.out.data() + c.outPos, n, MSG_NOSIGNAL);
+      if (sent < 0) {
+        if (errno == EAGAIN || errno == EWOULDBLOCK) return;
+        closeConnection(c.fd);
+        return;
+      }
+      c.outPos += sent;
+      std::lock_guard<std::mutex> guard(_lock);
+      _stats.bytesOut += sent;
+    }
+
+    if (c.outPos >= c.dropAt) {
+      closeConnection(c.fd);
+      return;
+    }
+    if (_options.slowBytes > 0 && _options.slowDelayMs > 0) {
+      c.nextWriteMs = now + _options.slowDelayMs;
+    }
+  }
+
+  if (c.fd >= 0 && c.outPos >= c.out.size()) {
+    c.out.clear();
+    c.outPos = 0;
+    if (c.closeAfterWrite) {
+      closeConnection(c.fd);
+    } else if (!c.in.empty()) {
+      // A pipelined request may be waiting behind the one just answered
+      while (c.fd >= 0 && !c.parked && c.out.empty() && parseRequest(c)) {
+        handle(c);
+      }
+    }
+  }
+}
+
+/*********************************************/
+/*  HTTP                                     */
+/*********************************************/
+
+bool MockTelegramServer::parseRequest(Connection &c) {
+  // Empty lines before a request line are ignored (RFC 7230, 3.5); clients
+  // that end a body with an extra CRLF rely on it
+  size_t start = c.in.find_first_not_of("\r\n");
+  c.in.erase(0, start == std::string::npos ? c.in.size() : start);
+
+  size_t headerEnd = c.in.find("\r\n\r\n");
+  if (headerEnd == std::string::npos) return false;
+
+  std::map<std::string, std::string> headers;
+  size_t lineEnd = c.in.find("\r\n");
+  std::string requestLine = c.in.substr(0, lineEnd);
+  size_t pos = lineEnd + 2;
+  while (pos < headerEnd) {
+    size_t eol = c.in.find("\r\n", pos);
+    std::string line = c.in.substr(pos, eol - pos);
+    size_t colon = line.find(':');
+    if (colon != std::string::npos) {
+      size_t v = colon + 1;
+      while (v < line.size() && line[v] == ' ') v++;
+      headers[lower(line.substr(0, colon))] = line.substr(v);
+    }
+    pos = eol + 2;
+  }
+
+  std::string body;
+  size_t consumed;
+  size_t bodyStart = headerEnd + 4;
+  if (lower(headers["transfer-encoding"]).find("chunked") != std::string::npos) {
+    if (!decodeChunked(c.in, bodyStart, body, consumed)) return false;
+  } else {
+    size_t length = strtoul(headers["content-length"].c_str(), nullptr, 10);
+    if (c.in.size() < bodyStart + length) return false;
+    body = c.in.substr(bodyStart, length);
+    consumed = bodyStart + length;
+  }
+  c.in.erase(0, consumed);
+
+  size_t sp1 = requestLine.find(' ');
+  size_t sp2 = requestLine.find(' ', sp1 + 1);
+  c.verb = requestLine.substr(0, sp1);
+  std::string target = requestLine.substr(sp1 + 1, sp2 - sp1 - 1);
+  c.headers.swap(headers);
+  c.params.clear();
+  c.uploadName.clear();
+  c.uploadSize = 0;
+
+  size_t q = target.find('?');
+  c.path = target.substr(0, q);
+  if (q != std::string::npos) parseForm(target.substr(q + 1), c.params);
+
+  std::string contentType = lower(c.headers["content-type"]);
+  if (contentType.find("application/json") != std::string::npos) {
+    JsonDocument doc;
+    if (!deserializeJson(doc, body)) {
+      for (JsonPair kv : doc.as<JsonObject>()) {
+        std::string value;
+        if (kv.value().is<const char *>()) value = kv.value().as<const char *>();
+        else serializeJson(kv.value(), value);
+        c.params[kv.key().c_str()] = value;
+      }
+    }
+  } else if (contentType.find("multipart/form-data") != std::string::npos) {
+    size_t b = c.headers["content-type"].find("boundary=");
+    std::string delimiter = "--" + c.headers["content-type"].substr(b + 9);
+    size_t part = body.find(delimiter);
+    while (part != std::string::npos) {
+      size_t partHeaders = part + delimiter.size() + 2;
+      size_t partBody = body.find("\r\n\r\n", partHeaders);
+      size_t next = body.find(delimiter, partHeaders);
+      if (partBody == std::string::npos || next == std::string::npos) break;
+      std::string disposition = body.substr(partHeaders, partBody - partHeaders);
+      size_t n = disposition.find("name=\"");
+      std::string name = n == std::string::npos ? "" : disposition.substr(n + 6, disposition.find('"', n + 6) - n - 6);
+      size_t valueLength = next - 2 - (partBody + 4); // part body ends with CRLF
+      if (disposition.find("filename=") != std::string::npos) {
+        c.uploadName = name;
+        c.uploadSize = valueLength;
+      } else {
+        c.params[name] = body.substr(partBody + 4, valueLength);
+      }
+      part = next;
+    }
+  } else if (contentType.find("x-www-form-urlencoded") != std::string::npos) {
+    parseForm(body, c.params);
+  }
+
+  c.closeAfterWrite = lower(c.headers["connection"]) == "close";
+  return true;
+}
+
+void MockTelegramServer::respond(Connection &c, int status, const std::string &body) {
+  const char *reason = status == 200 ? "OK"
+                       : status == 400 ? "Bad Request"
+                       : status == 401 ? "Unauthorized"
+                       : status == 404 ? "Not Found"
+                       : status == 429 ? "Too Many Requests"
+                                       : "Error";
+  char head[256];
+  std::string out;
+  if (_options.chunked) {
+    snprintf(head, sizeof(head),
+             "HTTP/1.1 %d %s\r\nServer: mock-telegram\r\nContent-Type: application/json\r\n"
+             "Transfer-Encoding: chunked\r\n\r\n",
+             status, reason);
+    out = head;
+    size_t step = _options.chunkSize ? _options.chunkSize : body.size();
+    for (size_t pos = 0; pos < body.size(); pos += step) {
+      size_t n = std::min(step, body.size() - pos);
+      snprintf(head, sizeof(head), "%zx\r\n", n);
+      out += head;
+      out.append(body, pos, n);
+      out += "\r\n";
+    }
+    out += "0\r\n\r\n";
+  } else {
+    snprintf(head, sizeof(head),
+             "HTTP/1.1 %d %s\r\nServer: mock-telegram\r\nContent-Type: application/json\r\n"
+             "Content-Length: %zu\r\n\r\n",
+             status, reason, body.size());
+    out = head;
+    out += body;
+  }
+
+  c.out = out;
+  c.outPos = 0;
+  c.nextWriteMs = 0;
+  c.dropAt = std::string::npos;
+  if (_options.dropMidBody) {
+    std::lock_guard<std::mutex> guard(_lock);
+    bool drop = (_options.dropEvery > 0 && _stats.requests % _options.dropEvery == 0) ||
+                chance(_options.dropProbability);
+    if (drop) {
+      c.dropAt = out.size() - body.size() / 2 - 1;
+      _stats.dropped++;
+    }
+  }
+}
+
+/*********************************************/
+/*  Bot API                                  */
+/*********************************************/
+
+std::string MockTelegramServer::param(Connection &c, const std::string &name) {
+  auto it = c.params.find(name);
+  return it == c.params.end() ? std::string() : it->second;
+}
+
+std::string MockTelegramServer::messageJson(long long chatId, const std::string &extra) {
+  char buf[256];
+  int id;
+  {
+    std::lock_guard<std::mutex> guard(_lock);
+    id = _nextMessageId++;
+  }
+  snprintf(buf, sizeof(buf),
+           "{\"message_id\":%d,\"from\":{\"id\":%lld,\"is_bot\":true,\"first_name\":\"Mock\","
+           "\"username\":\"mock_bot\"},\"chat\":{\"id\":%lld,\"type\":\"private\"},\"date\":%ld",
+           id, MOCK_BOT_ID, chatId, MOCK_DATE_BASE + id);
+  std::string json = buf;
+  if (!extra.empty()) {
+    json += ',';
+    json += extra;
+  }
+  json += '}';
+  return json;
+}
+
+void MockTelegramServer::handle(Connection &c) {
+  bool rateLimit, drop;
+  {
+    std::lock_guard<std::mutex> guard(_lock);
+    _stats.requests++;
+    rateLimit = (_options.rateLimitEvery > 0 && _stats.requests % _options.rateLimitEvery == 0) ||
+                chance(_options.rateLimitProbability);
+    drop = !_options.dropMidBody &&
+           ((_options.dropEvery > 0 && _stats.requests % _options.dropEvery == 0) ||
+            chance(_options.dropProbability));
+    if (drop) _stats.dropped++;
+  }
+
+  if (drop) {
+    // Swallow the request and hang up without answering
+    closeConnection(c.fd);
+    return;
+  }
+
+  // File downloads: /file/bot<token>/<file_path>
+  if (c.path.compare(0, 9, "/file/bot") == 0) {
+    size_t slash = c.path.find('/', 9);
+    std::string filePath = slash == std::string::npos ? "" : c.path.substr(slash + 1);
+    long size = -1;
+    {
+      std::lock_guard<std::mutex> guard(_lock);
+      for (auto &f : _files) {
+        if ("documents/" + f.first + ".bin" == filePath) size = f.second;
+      }
+    }
+    if (size < 0) {
+      respond(c, 404, "{\"ok\":false,\"error_code\":404,\"description\":\"Not Found\"}");
+    } else {
+      respond(c, 200, std::string((size_t)size, 'x'));
+    }
+    return;
+  }
+
+  if (c.path.compare(0, 4, "/bot") != 0) {
+    respond(c, 404, "{\"ok\":false,\"error_code\":404,\"description\":\"Not Found\"}");
+    return;
+  }
+  size_t slash = c.path.find('/', 4);
+  std::string token = c.path.substr(4, slash == std::string::npos ? std::string::npos : slash - 4);
+  std::string name = slash == std::string::npos ? "" : c.path.substr(slash + 1);
+
+  {
+    std::lock_guard<std::mutex> guard(_lock);
+    _stats.methods[name]++;
+  }
+
+  if (!_options.token.empty() && token != _options.token) {
+    respond(c, 401, "{\"ok\":false,\"error_code\":401,\"description\":\"Unauthorized\"}");
+    return;
+  }
+
+  if (rateLimit) {
+    char body[160];
+    snprintf(body, sizeof(body),
+             "{\"ok\":false,\"error_code\":429,\"description\":\"Too Many Requests: retry after %d\","
+             "\"parameters\":{\"retry_after\":%d}}",
+             _options.retryAfter, _options.retryAfter);
+    {
+      std::lock_guard<std::mutex> guard(_lock);
+      _stats.rateLimited++;
+    }
+    respond(c, 429, body);
+    return;
+  }
+
+  std::string result = method(c, name);
+  if (result.empty()) {
+    respond(c, 404, "{\"ok\":false,\"error_code\":404,\"description\":\"Not Found\"}");
+  } else if (result[0] == '!') {
+    respond(c, 400, "{\"ok\":false,\"error_code\":400,\"description\":" + jsonEscape(result.substr(1)) + "}");
+  } else if (result != "parked") {
+    respond(c, 200, "{\"ok\":true,\"result\":" + result + "}");
+  }
+}
+
+// Returns the JSON "result" of a call, "!reason" for a 400, "parked" for a
+// long poll that will be answered later, or "" for an unknown method
+std::string MockTelegramServer::method(Connection &c, const std::string &name) {
+  if (name == "getMe") {
+    char buf[160];
+    snprintf(buf, sizeof(buf),
+             "{\"id\":%lld,\"is_bot\":true,\"first_name\":\"Mock\",\"username\":\"mock_bot\"}", MOCK_BOT_ID);
+    return buf;
+  }
+
+  if (name == "getUpdates") {
+    std::string offset = param(c, "offset");
+    std::string limit = param(c, "limit");
+    c.offset = offset.empty() ? 0 : atol(offset.c_str());
+    c.limit = limit.empty() ? 100 : atoi(limit.c_str());
+    if (c.limit < 1 || c.limit > 100) c.limit = 100;
+    int timeout = atoi(param(c, "timeout").c_str());
+    if (timeout > _options.maxLongPoll) timeout = _options.maxLongPoll;
+
+    {
+      std::lock_guard<std::mutex> guard(_lock);
+      // Offset confirms every update below it, a negative one keeps the last N
+      if (c.offset > 0) {
+        while (!_updates.empty() && _updates.front().id < c.offset) _updates.pop_front();
+      } else if (c.offset < 0) {
+        while ((long)_updates.size() > -c.offset) _updates.pop_front();
+      }
+      bool empty = true;
+      for (auto &u : _updates) {
+        if (u.id >= c.offset) {
+          empty = false;
+          break;
+        }
+      }
+      if (empty && timeout > 0) {
+        c.parked = true;
+        c.deadlineMs = nowMs() + (uint64_t)timeout * 1000;
+        _stats.longPollsParked++;
+        return "parked";
+      }
+    }
+    answerUpdates(c);
+    return "parked";
+  }
+
+  if (name == "sendMessage" || name == "editMessageText") {
+    std::string chatId = param(c, "chat_id");
+    std::string text = param(c, "text");
+    if (chatId.empty()) return "!Bad Request: chat_id is empty";
+    if (text.empty()) return "!Bad Request: message text is empty";
+    {
+      std::lock_guard<std::mutex> guard(_lock);
+      _stats.messagesSent++;
+    }
+    return messageJson(atoll(chatId.c_str()), "\"text\":" + jsonEscape(text));
+  }
+
+  if (name == "sendPhoto") {
+    std::string chatId = param(c, "chat_id");
+    if (chatId.empty()) return "!Bad Request: chat_id is empty";
+    size_t size = c.uploadSize;
+    if (c.uploadName.empty() && param(c, "photo").empty()) return "!Bad Request: there is no photo in the request";
+    int fileId;
+    {
+      std::lock_guard<std::mutex> guard(_lock);
+      _stats.photosSent++;
+      _stats.uploadBytes += size;
+      fileId = _nextFileId++;
+    }
+    char photo[200];
+    snprintf(photo, sizeof(photo),
+             "\"photo\":[{\"file_id\":\"photo_%d\",\"file_unique_id\":\"uphoto_%d\",\"file_size\":%zu,"
+             "\"width\":640,\"height\":480}]",
+             fileId, fileId, size);
+    return messageJson(atoll(chatId.c_str()), photo);
+  }
+
+  if (name == "getFile") {
+    std::string fileId = param(c, "file_id");
+    std::lock_guard<std::mutex> guard(_lock);
+    auto it = _files.find(fileId);
+    if (it == _files.end()) return "!Bad Request: invalid file_id";
+    char buf[200];
+    snprintf(buf, sizeof(buf),
+             "{\"file_id\":%s,\"file_unique_id\":\"u%s\",\"file_size\":%ld,\"file_path\":\"documents/%s.bin\"}",
+             jsonEscape(fileId).c_str(), fileId.c_str(), it->second, fileId.c_str());
+    return buf;
+  }
+
+  if (name == "answerCallbackQuery") {
+    if (param(c, "callback_query_id").empty()) return "!Bad Request: query is too old or query ID is invalid";
+    return "true";
+  }
+
+  if (name == "deleteMessage" || name == "sendChatAction" || name == "setMyCommands") {
+    return "true";
+  }
+
+  return "";
+}
+
+void MockTelegramServer::answerUpdates(Connection &c) {
+  std::string result = "[";
+  int count = 0;
+  {
+    std::lock_guard<std::mutex> guard(_lock);
+    for (auto &u : _updates) {
+      if (u.id < c.offset) continue;
+      if (count == c.limit) break;
+      if (count++) result += ',';
+      result += u.json;
+    }
+    _stats.updatesDelivered += count;
+  }
+  result += ']';
+  c.parked = false;
+  respond(c, 200, "{\"ok\":true,\"result\":" + result + "}");
+}
+
+void MockTelegramServer::expireLongPolls() {
+  uint64_t now = nowMs();
+  for (auto &entry : _connections) {
+    Connection *c = entry.second;
+    if (!c->parked || c->fd < 0) continue;
+
+    bool ready;
+    {
+      std::lock_guard<std::mutex> guard(_lock);
+      ready = !_updates.empty() && _updates.back().id >= c->offset;
+      if (!ready && now >= c->deadlineMs) _stats.longPollsTimedOut++;
+    }
+    if (ready || now >= c->deadlineMs) {
+      answerUpdates(*c);
+      writeTo(*c);
+    }
+  }
+}
+
+/*********************************************/
+/*  Update injection                         */
+/*********************************************/
+
+long MockTelegramServer::queueUpdate(const std::string &fields) {
+  long id;
+  {
+    std::lock_guard<std::mutex> guard(_lock);
+    id = _nextUpdateId++;
+    char head[48];
+    snprintf(head, sizeof(head), "{\"update_id\":%ld,", id);
+    _updates.push_back({id, head + fields + "}"});
+  }
+  wake();
+  return id;
+}
+
+static std::string userMessage(int messageId, long long chatId, const std::string &extra) {
+  char buf[256];
+  snprintf(buf, sizeof(buf),
+           "{\"message_id\":%d,\"from\":{\"id\":%lld,\"is_bot\":false,\"first_name\":\"User\"},"
+           "\"chat\":{\"id\":%lld,\"first_name\":\"User\",\"type\":\"private\"},\"date\":%ld,",
+           messageId, chatId, chatId, MOCK_DATE_BASE + messageId);
+  return buf + extra + "}";
+}
+
+long MockTelegramServer::pushRawUpdate(const std::string &fields) {
+  return queueUpdate(fields);
+}
+
+long MockTelegramServer::pushMessage(long long chatId, const std::string &text) {
+  int id;
+  {
+    std::lock_guard<std::mutex> guard(_lock);
+    id = _nextMessageId++;
+  }
+  return queueUpdate("\"message\":" + userMessage(id, chatId, "\"text\":" + jsonEscape(text)));
+}
+
+long MockTelegramServer::pushEditedMessage(long long chatId, const std::string &text, int messageId) {
+  return queueUpdate("\"edited_message\":" + userMessage(messageId, chatId, "\"text\":" + jsonEscape(text)));
+}
+
+long MockTelegramServer::pushChannelPost(long long chatId, const std::string &text) {
+  int id;
+  {
+    std::lock_guard<std::mutex> guard(_lock);
+    id = _nextMessageId++;
+  }
+  char buf[200];
+  snprintf(buf, sizeof(buf),
+           "\"channel_post\":{\"message_id\":%d,\"chat\":{\"id\":%lld,\"title\":\"Mock channel\","
+           "\"type\":\"channel\"},\"date\":%ld,\"text\":",
+           id, chatId, MOCK_DATE_BASE + id);
+  return queueUpdate(buf + jsonEscape(text) + "}");
+}
+
+long MockTelegramServer::pushCallbackQuery(long long chatId, const std::string &data, int messageId) {
+  long queryId;
+  {
+    std::lock_guard<std::mutex> guard(_lock);
+    queryId = _nextUpdateId;
+  }
+  char buf[96];
+  snprintf(buf, sizeof(buf), "\"callback_query\":{\"id\":\"%ld\",\"from\":{\"id\":%lld,\"is_bot\":false,", queryId,
+           chatId);
+  std::string fields = buf;
+  fields += "\"first_name\":\"User\"},\"message\":" + messageJson(chatId, "\"text\":\"menu\"");
+  // messageJson allocated a fresh id, use the one the caller referred to
+  if (messageId > 0) {
+    size_t p = fields.find("\"message_id\":");
+    size_t e = fields.find(',', p);
+    fields.replace(p, e - p, "\"message_id\":" + std::to_string(messageId));
+  }
+  fields += ",\"chat_instance\":\"1\",\"data\":" + jsonEscape(data) + "}";
+  return queueUpdate(fields);
+}
+
+long MockTelegramServer::pushDocument(long long chatId, const std::string &fileName, long fileSize,
+                                      const std::string &caption) {
+  std::string fileId;
+  int id;
+  {
+    std::lock_guard<std::mutex> guard(_lock);
+    fileId = "file_" + std::to_string(_nextFileId++);
+    _files[fileId] = fileSize;
+    id = _nextMessageId++;
+  }
+  std::string extra = "\"document\":{\"file_name\":" + jsonEscape(fileName) + ",\"file_id\":" + jsonEscape(fileId) +
+                      ",\"file_unique_id\":\"u" + fileId + "\",\"file_size\":" + std::to_string(fileSize) + "}";
+  if (!caption.empty()) extra += ",\"caption\":" + jsonEscape(caption);
+  return queueUpdate("\"message\":" + userMessage(id, chatId, extra));
+}
+
+long MockTelegramServer::pushLocation(long long chatId, float latitude, float longitude) {
+  int id;
+  {
+    std::lock_guard<std::mutex> guard(_lock);
+    id = _nextMessageId++;
+  }
+  char buf[96];
+  snprintf(buf, sizeof(buf), "\"location\":{\"latitude\":%.6f,\"longitude\":%.6f}", latitude, longitude);
+  return queueUpdate("\"message\":" + userMessage(id, chatId, buf));
+}
+
+long MockTelegramServer::pushContact(long long chatId, const std::string &phone, const std::string &firstName) {
+  int id;
+  {
+    std::lock_guard<std::mutex> guard(_lock);
+    id = _nextMessageId++;
+  }
+  std::string extra = "\"contact\":{\"phone_number\":" + jsonEscape(phone) +
+                      ",\"first_name\":" + jsonEscape(firstName) + ",\"user_id\":" + std::to_string(chatId) + "}";
+  return queueUpdate("\"message\":" + userMessage(id, chatId, extra));
+}
+
+size_t MockTelegramServer::pendingUpdates() {
+  std::lock_guard<std::mutex> guard(_lock);
+  return _updates.size();
+}
+
+MockServerStats MockTelegramServer::stats() {
+  std::lock_guard<std::mutex> guard(_lock);
+  return _stats;
+}
@@ -0,0 +1,142 @@
+/*
+   Mock Telegram Bot API server for deterministic load and latency tests.
+
+   Speaks plain HTTP/1.1 with keep-alive and implements enough of the Bot API
+   for the library: getMe, getUpdates (with long-poll timeouts), sendMessage,
+   editMessageText, sendPhoto (JSON and multipart, Content-Length or chunked
+   uploads), getFile, answerCallbackQuery and a generic "ok" for the rest.
+   Faults can be injected deterministically: 429 Too Many Requests with
+   retry_after, slow bodies, chunked responses and dropped connections.
+
+   Point a bot at it with
+     PosixClient client;
+     UniversalTelegramBot bot(token, client);
+     bot.setServer("127.0.0.1", server.port(), false);
+ */
+
+#ifndef MockTelegramServer_h
+#define MockTelegramServer_h
+
+#include <stdint.h>
+
+#include <atomic>
+#include <deque>
+#include <map>
+#include <mutex>
+#include <string>
+#include <thread>
+
+struct MockServerOptions {
+  uint16_t port = 8081;        // 0 picks a free port, see port()
+  std::string token;           // accept any token when empty
+  uint32_t seed = 1;           // drives every random fault decision
+  int maxLongPoll = 50;        // seconds, upper bound for getUpdates timeout
+
+  // 429 Too Many Requests, either every Nth request or with a probability
+  int rateLimitEvery = 0;
+  double rateLimitProbability = 0;
+  int retryAfter = 1;
+
+  // Slow bodies: the response is written slowBytes at a time with
+  // slowDelayMs between pieces
+  size_t slowBytes = 0;
+  int slowDelayMs = 0;
+
+  // Answer with Transfer-Encoding: chunked, chunkSize bytes per chunk
+  bool chunked = false;
+  size_t chunkSize = 256;
+
+  // Dropped connections, either every Nth request or with a probability.
+  // dropMidBody closes halfway through the response instead of before it.
+  int dropEvery = 0;
+  double dropProbability = 0;
+  bool dropMidBody = false;
+};
+
+struct MockServerStats {
+  unsigned long requests = 0;
+  unsigned long connections = 0;
+  unsigned long rateLimited = 0;
+  unsigned long dropped = 0;
+  unsigned long longPollsParked = 0;
+  unsigned long longPollsTimedOut = 0;
+  unsigned long updatesDelivered = 0;
+  unsigned long messagesSent = 0;
+  unsigned long photosSent = 0;
+  unsigned long long bytesIn = 0;
+  unsigned long long bytesOut = 0;
+  unsigned long long uploadBytes = 0;
+  std::map<std::string, unsigned long> methods;
+};
+
+class MockTelegramServer {
+public:
+  explicit MockTelegramServer(const MockServerOptions &options = MockServerOptions());
+  ~MockTelegramServer();
+
+  // Binds and starts serving on a background thread
+  bool start();
+  void stop();
+  // Serves on the calling thread until stop() is called from elsewhere
+  bool run();
+
+  uint16_t port() const { return _port; }
+
+  // Queue updates for getUpdates. Each returns the update_id it was given.
+  long pushMessage(long long chatId, const std::string &text);
+  long pushCallbackQuery(long long chatId, const std::string &data, int messageId);
+  long pushDocument(long long chatId, const std::string &fileName, long fileSize,
+                    const std::string &caption = "");
+  long pushChannelPost(long long chatId, const std::string &text);
+  long pushEditedMessage(long long chatId, const std::string &text, int messageId);
+  long pushLocation(long long chatId, float latitude, float longitude);
+  long pushContact(long long chatId, const std::string &phone, const std::string &firstName);
+  // Any update body, e.g. "\"message\":{...}"; the update_id is added
+  long pushRawUpdate(const std::string &fields);
+
+  size_t pendingUpdates();
+  MockServerStats stats();
+
+private:
+  struct Connection;
+  struct Update {
+    long id;
+    std::string json;
+  };
+
+  bool bind();
+  void loop();
+  void wake();
+  void accept();
+  void readFrom(Connection &c);
+  void writeTo(Connection &c);
+  bool parseRequest(Connection &c);
+  void handle(Connection &c);
+  void respond(Connection &c, int status, const std::string &body);
+  void answerUpdates(Connection &c);
+  void expireLongPolls();
+  std::string method(Connection &c, const std::string &name);
+  std::string param(Connection &c, const std::string &name);
+  std::string messageJson(long long chatId, const std::string &extra);
+  long queueUpdate(const std::string &fields);
+  bool chance(double probability);
+
+  MockServerOptions _options;
+  uint16_t _port;
+  int _listenFd;
+  int _wakeFd;
+  std::atomic<bool> _running;
+  std::thread _thread;
+  std::map<int, Connection *> _connections;
+
+  std::mutex _lock; // guards everything below
+  std::deque<Update> _updates;
+  long _nextUpdateId;
+  int _nextMessageId;
+  int _nextFileId;
+  std::map<std::string, long> _files;
+  MockServerStats _stats;
+  uint64_t _rng;
+};
+
+#endif
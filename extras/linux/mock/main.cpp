@@ -0,0 +1,153 @@
+/*
+   Command line front end for MockTelegramServer.
+
+     mock_telegram_server --port 8081 --updates-per-second 50 --rate-limit-every 20
+
+   Runs until interrupted, printing request statistics every few seconds.
+ */
+
+#include <getopt.h>
+#include <signal.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <unistd.h>
+
+#include <atomic>
+#include <chrono>
+#include <thread>
+
+#include "MockTelegramServer.h"
+
+static std::atomic<bool> interrupted(false);
+
+static void onSignal(int) {
+  interrupted = true;
+}
+
+static void usage(const char *argv0) {
+  fprintf(stderr,
+          "usage: %s [options]\n"
+          "  --port N                 listen port (default 8081, 0 = any)\n"
+          "  --token T                only accept this bot token\n"
+          "  --seed N                 seed for random fault injection\n"
+          "  --max-long-poll S        cap for getUpdates timeout (default 50)\n"
+          "  --updates-per-second R   generate text updates at this rate\n"
+          "  --chats N                spread generated updates over N chats\n"
+          "  --rate-limit-every N     answer every Nth request with 429\n"
+          "  --rate-limit-chance P    answer with 429 with probability P\n"
+          "  --retry-after S          retry_after sent with 429 (default 1)\n"
+          "  --slow BYTES:MS          write responses BYTES at a time, MS apart\n"
+          "  --chunked SIZE           send responses chunked, SIZE bytes per chunk\n"
+          "  --drop-every N           drop the connection on every Nth request\n"
+          "  --drop-chance P          drop the connection with probability P\n"
+          "  --drop-mid-body          drop halfway through the response instead\n"
+          "  --stats-interval S       print statistics every S seconds (default 5)\n",
+          argv0);
+}
+
+static void printStats(MockTelegramServer &server) {
+  MockServerStats s = server.stats();
+  printf("requests=%lu connections=%lu 429=%lu dropped=%lu parked=%lu timeouts=%lu "
+         "delivered=%lu sent=%lu photos=%lu in=%llu out=%llu pending=%zu\n",
+         s.requests, s.connections, s.rateLimited, s.dropped, s.longPollsParked, s.longPollsTimedOut,
+         s.updatesDelivered, s.messagesSent, s.photosSent, s.bytesIn, s.bytesOut, server.pendingUpdates());
+  fflush(stdout);
+}
+
+int main(int argc, char **argv) {
+  MockServerOptions options;
+  double updatesPerSecond = 0;
+  int chats = 1;
+  int statsInterval = 5;
+
+  static const struct option longOptions[] = {
+      {"port", required_argument, nullptr, 'p'},
+      {"token", required_argument, nullptr, 't'},
+      {"seed", required_argument, nullptr, 's'},
+      {"max-long-poll", required_argument, nullptr, 'l'},
+      {"updates-per-second", required_argument, nullptr, 'u'},
+      {"chats", required_argument, nullptr, 'c'},
+      {"rate-limit-every", required_argument, nullptr, 'r'},
+      {"rate-limit-chance", required_argument, nullptr, 'R'},
+      {"retry-after", required_argument, nullptr, 'a'},
+      {"slow", required_argument, nullptr, 'w'},
+      {"chunked", required_argument, nullptr, 'k'},
+      {"drop-every", required_argument, nullptr, 'd'},
+      {"drop-chance", required_argument, nullptr, 'D'},
+      {"drop-mid-body", no_argument, nullptr, 'm'},
+      {"stats-interval", required_argument, nullptr, 'i'},
+      {"help", no_argument, nullptr, 'h'},
+      {nullptr, 0, nullptr, 0}};
+
+  int opt;
+  while ((opt = getopt_long(argc, argv, "h", longOptions, nullptr)) != -1) {
+    switch (opt) {
+      case 'p': options.port = (uint16_t)atoi(optarg); break;
+      case 't': options.token = optarg; break;
+      case 's': options.seed = (uint32_t)strtoul(optarg, nullptr, 10); break;
+      case 'l': options.maxLongPoll = atoi(optarg); break;
+      case 'u': updatesPerSecond = atof(optarg); break;
+      case 'c': chats = atoi(optarg) > 0 ? atoi(optarg) : 1; break;
+      case 'r': options.rateLimitEvery = atoi(optarg); break;
+      case 'R': options.rateLimitProbability = atof(optarg); break;
+      case 'a': options.retryAfter = atoi(optarg); break;
+      case 'w': {
+        unsigned long bytes = 0, ms = 0;
+        if (sscanf(optarg, "%lu:%lu", &bytes, &ms) != 2) {
+          usage(argv[0]);
+          return 2;
+        }
+        options.slowBytes = bytes;
+        options.slowDelayMs = (int)ms;
+        break;
+      }
+      case 'k':
+        options.chunked = true;
+        options.chunkSize = strtoul(optarg, nullptr, 10);
+        break;
+      case 'd': options.dropEvery = atoi(optarg); break;
+      case 'D': options.dropProbability = atof(optarg); break;
+      case 'm': options.dropMidBody = true; break;
+      case 'i': statsInterval = atoi(optarg); break;
+      default:
+        usage(argv[0]);
+        return opt == 'h' ? 0 : 2;
+    }
+  }
+
+  signal(SIGINT, onSignal);
+  signal(SIGTERM, onSignal);
+
+  MockTelegramServer server(options);
+  if (!server.start()) {
+    perror("mock_telegram_server: cannot listen");
+    return 1;
+  }
+  printf("mock Telegram Bot API listening on 127.0.0.1:%u\n", server.port());
+  fflush(stdout);
+
+  using Clock = std::chrono::steady_clock;
+  Clock::time_point nextStats = Clock::now() + std::chrono::seconds(statsInterval);
+  Clock::time_point nextUpdate = Clock::now();
+  long generated = 0;
+
+  while (!interrupted) {
+    Clock::time_point now = Clock::now();
+    if (updatesPerSecond > 0) {
+      while (nextUpdate <= now) {
+        server.pushMessage(1000 + generated % chats, "/status " + std::to_string(generated));
+        generated++;
+        nextUpdate += std::chrono::microseconds((long)(1e6 / updatesPerSecond));
+      }
+    }
+    if (statsInterval > 0 && now >= nextStats) {
+      printStats(server);
+      nextStats += std::chrono::seconds(statsInterval);
+    }
+    std::this_thread::sleep_for(std::chrono::milliseconds(updatesPerSecond > 0 ? 1 : 50));
+  }
+
+  server.stop();
+  printStats(server);
+  return 0;
+}
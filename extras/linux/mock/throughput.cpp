@@ -0,0 +1,82 @@
+/*
+   End-to-end throughput run: the real library, over a PosixClient, against
+   an in-process MockTelegramServer.
+
+     mock_throughput [updates] [chunk size, 0 = Content-Length] [429 every N]
+
+   Queues the updates, then echoes each one back with sendMessage the way
+   the EchoBot example does, and reports calls per second.
+ */
+
+#include <stdio.h>
+#include <stdlib.h>
+
+#include <PosixClient.h>
+#include <UniversalTelegramBot.h>
+
+#include "MockTelegramServer.h"
+
+int main(int argc, char **argv) {
+  long updates = argc > 1 ? atol(argv[1]) : 1000;
+
+  MockServerOptions options;
+  options.port = 0;
+  if (argc > 2 && atoi(argv[2]) > 0) {
+    options.chunked = true;
+    options.chunkSize = atoi(argv[2]);
+  }
+  if (argc > 3) options.rateLimitEvery = atoi(argv[3]);
+
+  MockTelegramServer server(options);
+  if (!server.start()) {
+    perror("cannot start mock server");
+    return 1;
+  }
+  for (long i = 0; i < updates; i++) {
+    server.pushMessage(1000 + i % 16, "/status " + std::to_string(i));
+  }
+
+  PosixClient client;
+  UniversalTelegramBot bot("123:TOKEN", client);
+  bot.setServer("127.0.0.1", server.port(), false);
+
+  unsigned long start = micros();
+  long received = 0, sent = 0, polls = 0;
+  while (received < updates) {
+    int n = bot.getUpdates(bot.last_message_received + 1);
+    polls++;
+    for (int i = 0; i < n; i++) {
+      received++;
+      if (bot.sendMessage(bot.messages[i].chat_id, bot.messages[i].text, "")) sent++;
+    }
+    if (n == 0 && polls > updates * 4) break; // server stopped handing out updates
+  }
+  unsigned long elapsed = micros() - start;
+
+  MockServerStats s = server.stats();
+  server.stop();
+
+  double seconds = elapsed / 1e6;
+  printf("updates received  %ld / %ld\n", received, updates);
+  printf("messages sent     %ld\n", sent);
+  printf("getUpdates calls  %ld\n", polls);
+  printf("HTTP requests     %lu (%lu answered 429)\n", s.requests, s.rateLimited);
+  printf("connections       %lu\n", s.connections);
+  printf("elapsed           %.3f s\n", seconds);
+  printf("requests/s        %.0f\n", s.requests / seconds);
+  printf("mean request      %.1f us\n", s.requests ? elapsed / (double)s.requests : 0.0);
+  printf("\nbot.stats %s\n", bot.stats.toJson().c_str());
+#if TELEGRAM_TRACE_LEVEL > 0
+  printf("\nlast trace events:\n");
+  bot.trace.dump(Serial);
+#endif
+#ifdef TELEGRAM_HEAP_TRACKING
+  printf("\n");
+  bot.heap.printTo(Serial);
+#endif
+#ifdef TELEGRAM_LATENCY_STATS
+  printf("\n");
+  bot.latency.printTo(Serial);
+#endif
+  return received == updates ? 0 : 1;
+}
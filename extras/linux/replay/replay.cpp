@@ -0,0 +1,129 @@
+/*
+   Replays a session recorded with RecordingClient (for example by running
+   EchoBot with TELEGRAM_RECORD set) against this build of the library, and
+   reports how long the calls took and how much memory they needed.
+
+     telegram_replay session.utbrec [--speed X] [--repeat N]
+
+   The bot runs the EchoBot loop: getMe, then getUpdates with every message
+   echoed back by sendMessage, until the recording is used up. --speed
+   scales the recorded pauses (2 plays them twice as fast, 0 leaves them
+   out and measures library time only). Run the same recording through two
+   builds and compare the reports.
+ */
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include <AllocStats.h>
+#include <ReplayClient.h>
+#include <UniversalTelegramBot.h>
+
+struct CallTimes {
+  const char *name;
+  unsigned long calls = 0;
+  unsigned long long totalUs = 0;
+  unsigned long maxUs = 0;
+
+  void add(unsigned long us) {
+    calls++;
+    totalUs += us;
+    if (us > maxUs) maxUs = us;
+  }
+
+  void print() const {
+    printf("%-12s %8lu calls %10.1f us mean %10lu us max\n", name, calls,
+           calls ? (double)totalUs / calls : 0.0, maxUs);
+  }
+};
+
+int main(int argc, char **argv) {
+  const char *path = nullptr;
+  double speed = 1.0;
+  int repeat = 1;
+  for (int i = 1; i < argc; i++) {
+    if (!strcmp(argv[i], "--speed") && i + 1 < argc) {
+      speed = atof(argv[++i]);
+    } else if (!strcmp(argv[i], "--repeat") && i + 1 < argc) {
+      repeat = atoi(argv[++i]);
+    } else if (argv[i][0] != '-' && !path) {
+      path = argv[i];
+    } else {
+      path = nullptr;
+      break;
+    }
+  }
+  if (!path) {
+    fprintf(stderr, "usage: %s RECORDING [--speed X] [--repeat N]\n", argv[0]);
+    return 2;
+  }
+
+  ReplayClient client;
+  if (!client.open(path)) {
+    fprintf(stderr, "%s is not a readable recording\n", path);
+    return 1;
+  }
+  client.speed = speed;
+
+  CallTimes getMe, getUpdates, sendMessage;
+  getMe.name = "getMe";
+  getUpdates.name = "getUpdates";
+  sendMessage.name = "sendMessage";
+  unsigned long long waitedUs = 0;
+  unsigned long divergences = 0;
+  long updates = 0;
+
+  UniversalTelegramBot bot("1:replay", client);
+  AllocStats::resetPeak();
+  AllocStats before = AllocStats::snapshot();
+  unsigned long start = micros();
+
+  for (int run = 0; run < repeat; run++) {
+    client.rewind();
+    bot.last_message_received = 0;
+
+    unsigned long t = micros();
+    bot.getMe();
+    getMe.add(micros() - t);
+
+    while (!client.finished()) {
+      t = micros();
+      int n = bot.getUpdates(bot.last_message_received + 1);
+      getUpdates.add(micros() - t);
+      updates += n;
+      for (int i = 0; i < n; i++) {
+        t = micros();
+        bot.sendMessage(bot.messages[i].chat_id, bot.messages[i].text, "");
+        sendMessage.add(micros() - t);
+      }
+    }
+    waitedUs += client.waitedUs;
+    divergences += client.divergences;
+  }
+
+  unsigned long elapsed = micros() - start;
+  AllocStats used = AllocStats::snapshot() - before;
+
+  printf("updates           %ld\n", updates);
+  printf("elapsed           %.3f s, of which %.3f s replayed server time\n", elapsed / 1e6,
+         waitedUs / 1e6);
+  printf("library time      %.3f s\n", (elapsed - (double)waitedUs) / 1e6);
+  printf("divergences       %lu\n", divergences);
+  printf("allocations       %llu (%llu bytes)\n", used.allocations, used.bytesAllocated);
+  printf("peak heap growth  %lld bytes\n\n", used.peakBytes - before.liveBytes);
+  getMe.print();
+  getUpdates.print();
+  sendMessage.print();
+  printf("\nbot.stats %s\n", bot.stats.toJson().c_str());
+#ifdef TELEGRAM_HEAP_TRACKING
+  printf("\n");
+  bot.heap.printTo(Serial);
+#endif
+#ifdef TELEGRAM_LATENCY_STATS
+  printf("\n");
+  bot.latency.printTo(Serial);
+#endif
+  Serial.flush();
+  return 0;
+}
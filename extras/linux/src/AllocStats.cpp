@@ -0,0 +1,138 @@
+/*
+   malloc interposition behind AllocStats. The real allocator is reached
+   through glibc's __libc_* entry points, which avoids dlsym and the
+   allocation it makes on first use.
+ */
+
+#include "AllocStats.h"
+
+#include <atomic>
+
+#include <TelegramHeap.h>
+
+#ifdef __GLIBC__
+#include <malloc.h>
+
+extern "C" {
+void *__libc_malloc(size_t size);
+void *__libc_calloc(size_t count, size_t size);
+void *__libc_realloc(void *ptr, size_t size);
+void __libc_free(void *ptr);
+}
+
+static std::atomic<unsigned long long> allocCount(0);
+static std::atomic<unsigned long long> freeCount(0);
+static std::atomic<unsigned long long> allocBytes(0);
+static std::atomic<long long> live(0);
+static std::atomic<long long> peak(0);
+
+static void grow(long long delta) {
+  long long now = live.fetch_add(delta, std::memory_order_relaxed) + delta;
+  long long high = peak.load(std::memory_order_relaxed);
+  while (now > high &&
+         !peak.compare_exchange_weak(high, now, std::memory_order_relaxed)) {
+  }
+}
+
+static void *recordAllocation(void *ptr, size_t requested) {
+  if (ptr) {
+    allocCount.fetch_add(1, std::memory_order_relaxed);
+    allocBytes.fetch_add(requested, std::memory_order_relaxed);
+    grow((long long)malloc_usable_size(ptr));
+  }
+  return ptr;
+}
+
+extern "C" {
+
+void *malloc(size_t size) {
+  return recordAllocation(__libc_malloc(size), size);
+}
+
+void *calloc(size_t count, size_t size) {
+  return recordAllocation(__libc_calloc(count, size), count * size);
+}
+
+void *realloc(void *ptr, size_t size) {
+  if (!ptr) return malloc(size);
+  if (size == 0) {
+    free(ptr);
+    return nullptr;
+  }
+  long long before = (long long)malloc_usable_size(ptr);
+  void *moved = __libc_realloc(ptr, size);
+  if (moved) {
+    // Counted as a free of the old block and an allocation of the new one
+    freeCount.fetch_add(1, std::memory_order_relaxed);
+    grow(-before);
+    recordAllocation(moved, size);
+  }
+  return moved;
+}
+
+void free(void *ptr) {
+  if (!ptr) return;
+  freeCount.fetch_add(1, std::memory_order_relaxed);
+  grow(-(long long)malloc_usable_size(ptr));
+  __libc_free(ptr);
+}
+
+}
+
+bool AllocStats::available() {
+  return true;
+}
+
+AllocStats AllocStats::snapshot() {
+  AllocStats s;
+  s.allocations = allocCount.load(std::memory_order_relaxed);
+  s.frees = freeCount.load(std::memory_order_relaxed);
+  s.bytesAllocated = allocBytes.load(std::memory_order_relaxed);
+  s.liveBytes = live.load(std::memory_order_relaxed);
+  s.peakBytes = peak.load(std::memory_order_relaxed);
+  return s;
+}
+
+void AllocStats::resetPeak() {
+  peak.store(live.load(std::memory_order_relaxed), std::memory_order_relaxed);
+}
+
+// Heap figures for TelegramHeapTracker and bot.stats: free heap is what is
+// left of a notional TELEGRAM_HOST_HEAP_SIZE once the live bytes are taken
+// out. There is no fragmentation model, the largest block is all of it.
+static bool allocHeapProbe(TelegramHeapSample &sample) {
+  long long used = live.load(std::memory_order_relaxed);
+  long long left = (long long)TELEGRAM_HOST_HEAP_SIZE - used;
+  sample.freeHeap = left > 0 ? (uint32_t)left : 0;
+  sample.largestBlock = sample.freeHeap;
+  return true;
+}
+
+static struct HeapProbeInstaller {
+  HeapProbeInstaller() { telegramSetHeapProbe(allocHeapProbe); }
+} heapProbeInstaller;
+
+#else
+
+bool AllocStats::available() {
+  return false;
+}
+
+AllocStats AllocStats::snapshot() {
+  return AllocStats();
+}
+
+void AllocStats::resetPeak() {
+}
+
+#endif
+
+AllocStats AllocStats::operator-(const AllocStats &rhs) const {
+  AllocStats d;
+  d.allocations = allocations - rhs.allocations;
+  d.frees = frees - rhs.frees;
+  d.bytesAllocated = bytesAllocated - rhs.bytesAllocated;
+  d.liveBytes = liveBytes - rhs.liveBytes;
+  d.peakBytes = peakBytes;
+  return d;
+}
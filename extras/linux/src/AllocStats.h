@@ -0,0 +1,47 @@
+/*
+   Process-wide allocation counters for the host build of UniversalTelegramBot.
+
+   Linking AllocStats.cpp into a program interposes malloc, calloc, realloc
+   and free (glibc only), which covers String, ArduinoJson's default
+   allocator and operator new alike. Take a snapshot before and after the code
+   being measured and subtract:
+
+     AllocStats before = AllocStats::snapshot();
+     bot.getUpdates(offset);
+     AllocStats used = AllocStats::snapshot() - before;
+
+   On other C libraries available() is false and every counter stays 0.
+
+   With glibc, linking it also installs a heap probe so bot.stats and
+   TELEGRAM_HEAP_TRACKING see the live allocation size as heap use, against
+   a notional heap of TELEGRAM_HOST_HEAP_SIZE bytes. Deltas are exact, the
+   absolute free heap only means something relative to that size.
+ */
+
+#ifndef AllocStats_h
+#define AllocStats_h
+
+#include <stddef.h>
+
+#ifndef TELEGRAM_HOST_HEAP_SIZE
+#define TELEGRAM_HOST_HEAP_SIZE (256ul * 1024 * 1024)
+#endif
+
+struct AllocStats {
+  unsigned long long allocations = 0; // malloc, calloc and realloc calls
+  unsigned long long frees = 0;
+  unsigned long long bytesAllocated = 0; // total requested, frees not subtracted
+  long long liveBytes = 0;               // currently allocated, usable size
+  long long peakBytes = 0;               // high-water mark of liveBytes
+
+  static bool available();
+  static AllocStats snapshot();
+  // Starts a new high-water mark at the current live size
+  static void resetPeak();
+
+  // Differences of the counters; liveBytes becomes the net growth and
+  // peakBytes is kept from the left-hand side
+  AllocStats operator-(const AllocStats &rhs) const;
+};
+
+#endif
@@ -0,0 +1,203 @@
+#include "EpollBotEngine.h"
+
+#include <errno.h>
+#include <sys/epoll.h>
+#include <unistd.h>
+
+#include "PosixClient.h"
+
+#define EPOLL_BOT_ENGINE_EVENTS 64
+
+EpollBotEngine::Entry *EpollBotEngine::_ticking = nullptr;
+
+EpollBotEngine::EpollBotEngine()
+    : sweepMs(250), retryMs(1000), ticks(0), polls(0), pollFailures(0), updates(0),
+      _epoll(epoll_create1(EPOLL_CLOEXEC)), _lastSweep(millis()) {
+}
+
+EpollBotEngine::~EpollBotEngine() {
+  if (_epoll >= 0) close(_epoll);
+}
+
+EpollBotEngine::Entry *EpollBotEngine::find(UniversalTelegramBot &bot) {
+  for (size_t i = 0; i < _entries.size(); i++) {
+    if (_entries[i]->bot == &bot) return _entries[i].get();
+  }
+  return nullptr;
+}
+
+bool EpollBotEngine::add(UniversalTelegramBot &bot, MessageHandler onMessage) {
+  if (_epoll < 0 || find(bot)) return false;
+
+  std::unique_ptr<Entry> entry(new Entry());
+  entry->engine = this;
+  entry->bot = &bot;
+  entry->onMessage = onMessage;
+  entry->offset = 0;
+  entry->pollLater = false;
+  entry->pollAt = 0;
+  entry->ready = false;
+  entry->woken = true;
+  for (int i = 0; i < TELEGRAM_MAX_CLIENTS; i++) entry->fds[i] = -1;
+  entry->connects = bot.stats.connects;
+
+  // The engine waits on the sockets, so they must never wait themselves
+  for (int i = 0; i < bot.pool.size(); i++) {
+    PosixClient *client = dynamic_cast<PosixClient *>(bot.pool.client(i));
+    if (client) client->setReadWait(0);
+  }
+  // A blocking reconnect for every poll would hold up all the other bots
+  bot.pool.keepPollOpen = true;
+
+  if (!poll(*entry)) return false;
+  watch(*entry);
+  _entries.push_back(std::move(entry));
+  return true;
+}
+
+void EpollBotEngine::wake(UniversalTelegramBot &bot) {
+  Entry *entry = find(bot);
+  if (entry) entry->woken = true;
+}
+
+bool EpollBotEngine::poll(Entry &entry) {
+  entry.offset = entry.bot->last_message_received + 1;
+  if (!entry.bot->getUpdatesAsync(entry.offset, pollDone)) return false;
+  polls++;
+  return true;
+}
+
+/***************************************************************
+ * PollDone - hands the updates of a finished poll to the      *
+ * bot's handler and asks for the next ones                    *
+ ***************************************************************/
+void EpollBotEngine::pollDone(TelegramAsyncHandle, const TelegramResult &result,
+                              const String &body) {
+  Entry *entry = _ticking;
+  if (!entry) return;
+  EpollBotEngine &engine = *entry->engine;
+  UniversalTelegramBot &bot = *entry->bot;
+
+  int count = 0;
+  if (result.ok) {
+    count = bot.parseUpdates(body, entry->offset);
+    engine.updates += count;
+    for (int i = 0; i < count; i++) {
+      if (entry->onMessage) entry->onMessage(bot, bot.messages[i]);
+    }
+  } else {
+    engine.pollFailures++;
+  }
+
+  // Requests queued from here, the next poll and the handler's replies,
+  // start on the next tick
+  entry->woken = true;
+  if (bot.polling.adaptive && !bot.polling.due()) {
+    // The bot's scheduler has worked out when to poll next, failed or not
+    entry->pollLater = true;
+    entry->pollAt = bot.polling.nextPollAt();
+  } else if (!bot.polling.adaptive && (!result.ok || (count == 0 && bot.longPoll == 0))) {
+    // Neither hammer a server that is failing nor one answering short
+    // polls at once
+    entry->pollLater = true;
+    entry->pollAt = millis() + engine.retryMs;
+  } else if (!engine.poll(*entry)) {
+    // The replies filled the queue; polled again once one is done
+    entry->pollLater = true;
+    entry->pollAt = millis();
+  }
+}
+
+/***************************************************************
+ * Watch - registers the bot's sockets with epoll after a tick *
+ * that may have opened or replaced them                       *
+ ***************************************************************/
+void EpollBotEngine::watch(Entry &entry) {
+  UniversalTelegramBot &bot = *entry.bot;
+  // A socket closed and opened again within the tick can get its old
+  // number back, but it is out of the epoll set all the same
+  bool reconnected = bot.stats.connects != entry.connects;
+  entry.connects = bot.stats.connects;
+
+  for (int i = 0; i < bot.pool.size(); i++) {
+    PosixClient *client = dynamic_cast<PosixClient *>(bot.pool.client(i));
+    int fd = client ? client->fd() : -1;
+    if (fd == entry.fds[i] && !reconnected) continue;
+
+    // A closed socket leaves the set by itself; removing its number here
+    // could remove another bot's socket that has been given it since
+    entry.fds[i] = fd;
+    if (fd < 0) continue;
+
+    // Edge triggered: the library reads until the socket runs dry, and an
+    // idle keep-alive connection the server hangs up on is reported once
+    // instead of on every wait
+    struct epoll_event event = {};
+    event.events = EPOLLIN | EPOLLRDHUP | EPOLLET;
+    event.data.ptr = &entry;
+    if (epoll_ctl(_epoll, EPOLL_CTL_ADD, fd, &event) < 0 && errno == EEXIST) {
+      epoll_ctl(_epoll, EPOLL_CTL_MOD, fd, &event);
+    }
+  }
+}
+
+void EpollBotEngine::service(Entry &entry) {
+  entry.ready = false;
+  entry.woken = false;
+  if (entry.pollLater && (long)(millis() - entry.pollAt) >= 0) {
+    if (poll(entry)) {
+      entry.pollLater = false;
+    } else {
+      entry.pollAt = millis() + sweepMs;
+    }
+  }
+
+  _ticking = &entry;
+  entry.bot->tick();
+  _ticking = nullptr;
+  ticks++;
+  // An upload going out or a call a connection came free for during the
+  // tick gets no readiness event of its own, so the bot is ticked again
+  if (entry.bot->sending()) entry.woken = true;
+  watch(entry);
+}
+
+/***************************************************************
+ * RunOnce - waits up to timeoutMs for a socket to become      *
+ * ready and ticks every bot that has something to do: data    *
+ * arrived, calls were queued, a retry is due or, every        *
+ * sweepMs, a timeout may have run out                         *
+ ***************************************************************/
+void EpollBotEngine::runOnce(int timeoutMs) {
+  unsigned long now = millis();
+  long wait = timeoutMs;
+  long untilSweep = (long)(_lastSweep + sweepMs - now);
+  if (untilSweep < wait) wait = untilSweep;
+  for (size_t i = 0; i < _entries.size() && wait > 0; i++) {
+    const Entry &entry = *_entries[i];
+    if (entry.woken || entry.ready) wait = 0;
+    if (entry.pollLater && (long)(entry.pollAt - now) < wait) wait = (long)(entry.pollAt - now);
+  }
+  if (wait < 0) wait = 0;
+
+  struct epoll_event events[EPOLL_BOT_ENGINE_EVENTS];
+  int n = epoll_wait(_epoll, events, EPOLL_BOT_ENGINE_EVENTS, (int)wait);
+  for (int i = 0; i < n; i++) {
+    ((Entry *)events[i].data.ptr)->ready = true;
+  }
+
+  now = millis();
+  bool sweep = (long)(now - _lastSweep) >= sweepMs;
+  if (sweep) _lastSweep = now;
+  for (size_t i = 0; i < _entries.size(); i++) {
+    Entry &entry = *_entries[i];
+    if (sweep || entry.ready || entry.woken ||
+        (entry.pollLater && (long)(now - entry.pollAt) >= 0)) {
+      service(entry);
+    }
+  }
+}
+
+void EpollBotEngine::run() {
+  for (;;) runOnce(sweepMs);
+}
@@ -0,0 +1,102 @@
+/*
+   Runs many bots on one thread for the host build. Each bot keeps a long
+   poll open through getUpdatesAsync, and a single epoll set over all their
+   sockets decides which bot's tick() has something to do, so a gateway with
+   hundreds of tokens neither needs a thread per bot nor spins over idle
+   ones.
+
+     PosixClient pollClient[N], sendClient[N];   // or OpenSSLClient
+     UniversalTelegramBot *bots[N];
+     EpollBotEngine engine;
+     for (int i = 0; i < N; i++) {
+       bots[i] = new UniversalTelegramBot(tokens[i], pollClient[i]);
+       bots[i]->addClient(sendClient[i]);
+       bots[i]->longPoll = 25;
+       engine.add(*bots[i], onMessage);
+     }
+     engine.run();
+
+     void onMessage(UniversalTelegramBot &bot, telegramMessage &message) {
+       bot.sendMessageAsync(message.chat_id, message.text);
+     }
+
+   Requests are built, written and parsed by the library itself; the engine
+   only waits for readiness, ticks the bots that have some and hands every
+   parsed update to the handler, then asks for the next batch. Handlers
+   should answer with the *Async calls, a blocking call holds up every bot
+   on the thread. Connects and TLS handshakes are still blocking, which is
+   why add() keeps the long-poll connection open between polls. A bot with
+   an upload going out, or with a queued call a connection has come free
+   for, is ticked on every round until it is written, as no readiness
+   event would report it.
+
+   With bot.polling.adaptive set, the bot's own TelegramPollScheduler
+   decides when each bot polls next and retryMs is not used.
+
+   Only PosixClient and OpenSSLClient sockets are watched. Bots on other
+   clients still run, from the sweep every sweepMs.
+ */
+
+#ifndef EpollBotEngine_h
+#define EpollBotEngine_h
+
+#include <memory>
+#include <vector>
+
+#include <UniversalTelegramBot.h>
+
+class EpollBotEngine {
+public:
+  typedef void (*MessageHandler)(UniversalTelegramBot &bot, telegramMessage &message);
+
+  EpollBotEngine();
+  ~EpollBotEngine();
+
+  // Starts polling for a bot; false if it is already added or its first
+  // poll cannot be queued
+  bool add(UniversalTelegramBot &bot, MessageHandler onMessage);
+  // Has a bot ticked on the next round, e.g. after queueing calls from
+  // outside a handler
+  void wake(UniversalTelegramBot &bot);
+
+  // Waits up to timeoutMs for something to do and does it
+  void runOnce(int timeoutMs);
+  void run();
+
+  int sweepMs;          // every bot is ticked at least this often, for timeouts
+  int retryMs;          // pause before polling again after a failed poll
+
+  unsigned long ticks;
+  unsigned long polls;
+  unsigned long pollFailures;
+  unsigned long updates;
+
+private:
+  struct Entry {
+    EpollBotEngine *engine;
+    UniversalTelegramBot *bot;
+    MessageHandler onMessage;
+    long offset;                 // of the poll in flight
+    bool pollLater;              // the next poll waits for pollAt
+    unsigned long pollAt;
+    bool ready;                  // one of its sockets became ready
+    bool woken;
+    int fds[TELEGRAM_MAX_CLIENTS];  // as registered with epoll
+    uint32_t connects;              // bot.stats.connects when they were
+  };
+
+  bool poll(Entry &entry);
+  void service(Entry &entry);
+  void watch(Entry &entry);
+  Entry *find(UniversalTelegramBot &bot);
+
+  static void pollDone(TelegramAsyncHandle handle, const TelegramResult &result,
+                       const String &body);
+  static Entry *_ticking;
+
+  int _epoll;
+  unsigned long _lastSweep;
+  std::vector<std::unique_ptr<Entry>> _entries;
+};
+
+#endif
@@ -0,0 +1,106 @@
+#include "FragmentingClient.h"
+
+#include <string.h>
+
+FragmentingClient::FragmentingClient()
+    : maxFragment(16), maxStall(2), maxDelayMs(0), closeAtEnd(true), fragments(0), stalls(0),
+      _pos(0), _readable(0), _stall(0), _readyAt(0), _connected(false), _rng(1) {
+}
+
+void FragmentingClient::load(const std::string &response, uint64_t seed) {
+  load((const uint8_t *)response.data(), response.size(), seed);
+}
+
+void FragmentingClient::load(const uint8_t *data, size_t size, uint64_t seed) {
+  _data.assign((const char *)data, size);
+  _pos = 0;
+  _readable = 0;
+  _stall = 0;
+  _readyAt = 0;
+  _connected = true;
+  _rng = seed ? seed : 1;
+  fragments = 0;
+  stalls = 0;
+  nextFragment();
+}
+
+uint64_t FragmentingClient::next() {
+  _rng ^= _rng >> 12;
+  _rng ^= _rng << 25;
+  _rng ^= _rng >> 27;
+  return _rng * 2685821657736338717ULL;
+}
+
+void FragmentingClient::nextFragment() {
+  if (_readable >= _data.size()) return;
+
+  size_t size = maxFragment ? 1 + next() % maxFragment : _data.size();
+  _readable = _pos + size < _data.size() ? _pos + size : _data.size();
+  fragments++;
+
+  // The first fragment is there right away, later ones after a stall
+  if (_pos == 0) return;
+  _stall = maxStall > 0 ? (int)(next() % (maxStall + 1)) : 0;
+  if (maxDelayMs > 0) _readyAt = millis() + next() % (maxDelayMs + 1);
+}
+
+int FragmentingClient::connect(IPAddress, uint16_t) {
+  _connected = true;
+  return 1;
+}
+
+int FragmentingClient::connect(const char *, uint16_t) {
+  _connected = true;
+  return 1;
+}
+
+size_t FragmentingClient::write(uint8_t b) {
+  return write(&b, 1);
+}
+
+size_t FragmentingClient::write(const uint8_t *, size_t size) {
+  // Requests are not looked at, the response is whatever was loaded
+  return _connected ? size : 0;
+}
+
+int FragmentingClient::available() {
+  if (!_connected) return 0;
+  if (_pos == _readable) nextFragment();
+  if (_stall > 0) {
+    _stall--;
+    stalls++;
+    return 0;
+  }
+  if (_readyAt != 0) {
+    if ((long)(millis() - _readyAt) < 0) return 0;
+    _readyAt = 0;
+  }
+  return (int)(_readable - _pos);
+}
+
+int FragmentingClient::read() {
+  if (!available()) return -1;
+  return (uint8_t)_data[_pos++];
+}
+
+int FragmentingClient::read(uint8_t *buf, size_t size) {
+  size_t n = available();
+  if (n > size) n = size;
+  memcpy(buf, _data.data() + _pos, n);
+  _pos += n;
+  return (int)n;
+}
+
+int FragmentingClient::peek() {
+  if (!available()) return -1;
+  return (uint8_t)_data[_pos];
+}
+
+void FragmentingClient::stop() {
+  _connected = false;
+}
+
+uint8_t FragmentingClient::connected() {
+  if (closeAtEnd && _pos >= _data.size()) return 0;
+  return _connected;
+}
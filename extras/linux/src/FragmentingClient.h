@@ -0,0 +1,76 @@
+/*
+   In-memory Arduino Client that hands out a response in randomly sized
+   fragments, the way a TLS record layer or a congested link delivers it, for
+   stress tests of the HTTP reader.
+
+     FragmentingClient client;
+     client.maxFragment = 7;        // 1..7 bytes become readable at a time
+     client.maxStall = 3;           // 0..3 empty polls between fragments
+     client.load(response, seed);
+     bot.readHTTPAnswer(body);
+
+   Fragment sizes and stalls come from a generator seeded by load(), so a
+   failing case repeats exactly. A stall is a number of available() calls
+   that report no data, optionally plus a real delay of up to maxDelayMs.
+   With closeAtEnd the connection reads as closed once everything has been
+   read, which is how a server ends a body sent without a length.
+ */
+
+#ifndef FragmentingClient_h
+#define FragmentingClient_h
+
+#include <stdint.h>
+
+#include <string>
+
+#include <Arduino.h>
+#include <Client.h>
+
+class FragmentingClient : public Client {
+public:
+  FragmentingClient();
+
+  void load(const std::string &response, uint64_t seed = 1);
+  void load(const uint8_t *data, size_t size, uint64_t seed = 1);
+
+  size_t maxFragment;  // largest fragment, 0 makes everything readable at once
+  int maxStall;        // most empty available() calls between fragments
+  int maxDelayMs;      // most real delay between fragments
+  bool closeAtEnd;     // connected() turns false once all data is read
+
+  int connect(IPAddress ip, uint16_t port) override;
+  int connect(const char *host, uint16_t port) override;
+  size_t write(uint8_t b) override;
+  size_t write(const uint8_t *buf, size_t size) override;
+  int available() override;
+  int read() override;
+  int read(uint8_t *buf, size_t size) override;
+  int peek() override;
+  void flush() override {}
+  void stop() override;
+  uint8_t connected() override;
+  operator bool() override { return connected(); }
+
+  using Print::write;
+
+  // Bytes not read yet, i.e. what follows the response the reader stopped at
+  size_t remaining() const { return _data.size() - _pos; }
+  size_t position() const { return _pos; }
+
+  unsigned long fragments;
+  unsigned long stalls;
+
+private:
+  uint64_t next();
+  void nextFragment();
+
+  std::string _data;
+  size_t _pos;
+  size_t _readable;    // end of the current fragment
+  int _stall;
+  unsigned long _readyAt;
+  bool _connected;
+  uint64_t _rng;
+};
+
+#endif
@@ -0,0 +1,136 @@
+/*
+   TLS Client for the host build of UniversalTelegramBot.
+ */
+
+#include "OpenSSLClient.h"
+
+#include <errno.h>
+#include <poll.h>
+
+#include <openssl/err.h>
+#include <openssl/pem.h>
+#include <openssl/ssl.h>
+#include <openssl/x509v3.h>
+
+OpenSSLClient::OpenSSLClient() : _ctx(nullptr), _ssl(nullptr), _rootCA(nullptr), _insecure(false) {}
+
+OpenSSLClient::~OpenSSLClient() {
+  stop();
+  if (_ctx) SSL_CTX_free(_ctx);
+}
+
+void OpenSSLClient::setCACert(const char *rootCA) {
+  _rootCA = rootCA;
+  _insecure = false;
+  if (_ctx) {
+    SSL_CTX_free(_ctx);
+    _ctx = nullptr;
+  }
+}
+
+void OpenSSLClient::setInsecure() {
+  _insecure = true;
+  if (_ctx) {
+    SSL_CTX_free(_ctx);
+    _ctx = nullptr;
+  }
+}
+
+bool OpenSSLClient::ensureContext() {
+  if (_ctx) return true;
+
+  _ctx = SSL_CTX_new(TLS_client_method());
+  if (!_ctx) return false;
+  SSL_CTX_set_min_proto_version(_ctx, TLS1_2_VERSION);
+  SSL_CTX_set_mode(_ctx, SSL_MODE_ENABLE_PARTIAL_WRITE | SSL_MODE_ACCEPT_MOVING_WRITE_BUFFER);
+
+  if (_insecure) {
+    SSL_CTX_set_verify(_ctx, SSL_VERIFY_NONE, nullptr);
+    return true;
+  }
+
+  SSL_CTX_set_verify(_ctx, SSL_VERIFY_PEER, nullptr);
+  if (_rootCA) {
+    BIO *bio = BIO_new_mem_buf(_rootCA, -1);
+    X509_STORE *store = SSL_CTX_get_cert_store(_ctx);
+    X509 *cert;
+    bool loaded = false;
+    while ((cert = PEM_read_bio_X509(bio, nullptr, nullptr, nullptr)) != nullptr) {
+      loaded = X509_STORE_add_cert(store, cert) == 1 || loaded;
+      X509_free(cert);
+    }
+    BIO_free(bio);
+    ERR_clear_error();
+    return loaded;
+  }
+  return SSL_CTX_set_default_verify_paths(_ctx) == 1;
+}
+
+bool OpenSSLClient::handshake(const char *host) {
+  if (!ensureContext()) return false;
+
+  _ssl = SSL_new(_ctx);
+  if (!_ssl) return false;
+  SSL_set_fd(_ssl, _fd);
+  SSL_set_tlsext_host_name(_ssl, host);
+  if (!_insecure) SSL_set1_host(_ssl, host);
+
+  // The socket is non-blocking, drive the handshake until it settles
+  for (;;) {
+    int rc = SSL_connect(_ssl);
+    if (rc == 1) return true;
+    int err = SSL_get_error(_ssl, rc);
+    short events;
+    if (err == SSL_ERROR_WANT_READ) events = POLLIN;
+    else if (err == SSL_ERROR_WANT_WRITE) events = POLLOUT;
+    else break;
+    if (!waitFor(events, (int)_connectTimeout)) break;
+  }
+
+  ERR_clear_error();
+  return false;
+}
+
+ssize_t OpenSSLClient::transportRead(uint8_t *buf, size_t size) {
+  if (!_ssl) return 0;
+  int n = SSL_read(_ssl, buf, (int)size);
+  if (n > 0) return n;
+
+  int err = SSL_get_error(_ssl, n);
+  if (err == SSL_ERROR_WANT_READ || err == SSL_ERROR_WANT_WRITE) {
+    // Only part of a record has arrived so far
+    errno = EAGAIN;
+    return -1;
+  }
+  ERR_clear_error();
+  if (err == SSL_ERROR_ZERO_RETURN) return 0;
+  errno = ECONNRESET;
+  return -1;
+}
+
+ssize_t OpenSSLClient::transportWrite(const uint8_t *buf, size_t size) {
+  if (!_ssl) return -1;
+  int n = SSL_write(_ssl, buf, (int)size);
+  if (n > 0) return n;
+
+  int err = SSL_get_error(_ssl, n);
+  if (err == SSL_ERROR_WANT_READ || err == SSL_ERROR_WANT_WRITE) {
+    errno = EAGAIN;
+    return -1;
+  }
+  ERR_clear_error();
+  errno = EPIPE;
+  return -1;
+}
+
+size_t OpenSSLClient::transportPending() {
+  return _ssl ? (size_t)SSL_pending(_ssl) : 0;
+}
+
+void OpenSSLClient::transportClose() {
+  if (_ssl) {
+    SSL_shutdown(_ssl);
+    SSL_free(_ssl);
+    _ssl = nullptr;
+  }
+}
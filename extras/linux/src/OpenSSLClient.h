@@ -0,0 +1,41 @@
+/*
+   TLS Client for the host build of UniversalTelegramBot, the Linux
+   counterpart of WiFiClientSecure. Certificates are checked against the
+   system trust store unless a CA is given with setCACert() (for example
+   TELEGRAM_CERTIFICATE_ROOT) or verification is turned off with
+   setInsecure().
+ */
+
+#ifndef OpenSSLClient_h
+#define OpenSSLClient_h
+
+#include "PosixClient.h"
+
+typedef struct ssl_ctx_st SSL_CTX;
+typedef struct ssl_st SSL;
+
+class OpenSSLClient : public PosixClient {
+public:
+  OpenSSLClient();
+  ~OpenSSLClient();
+
+  void setCACert(const char *rootCA);
+  void setInsecure();
+
+protected:
+  bool handshake(const char *host) override;
+  ssize_t transportRead(uint8_t *buf, size_t size) override;
+  ssize_t transportWrite(const uint8_t *buf, size_t size) override;
+  size_t transportPending() override;
+  void transportClose() override;
+
+private:
+  bool ensureContext();
+
+  SSL_CTX *_ctx;
+  SSL *_ssl;
+  const char *_rootCA;
+  bool _insecure;
+};
+
+#endif
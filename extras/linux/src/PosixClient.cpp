@@ -0,0 +1,183 @@
+/*
+   Arduino Client over a plain POSIX TCP socket.
+ */
+
+#include "PosixClient.h"
+
+#include <errno.h>
+#include <fcntl.h>
+#include <netdb.h>
+#include <netinet/in.h>
+#include <netinet/tcp.h>
+#include <poll.h>
+#include <stdio.h>
+#include <string.h>
+#include <sys/socket.h>
+#include <unistd.h>
+
+#include <Arduino.h>
+
+PosixClient::PosixClient()
+    : _fd(-1), _peerClosed(false), _connectTimeout(10000), _readWait(1), _head(0), _tail(0) {}
+
+PosixClient::~PosixClient() {
+  stop();
+}
+
+int PosixClient::connect(IPAddress ip, uint16_t port) {
+  return connect(ip.toString().c_str(), port);
+}
+
+int PosixClient::connect(const char *host, uint16_t port) {
+  stop();
+
+  struct addrinfo hints;
+  memset(&hints, 0, sizeof(hints));
+  hints.ai_family = AF_UNSPEC;
+  hints.ai_socktype = SOCK_STREAM;
+
+  char service[8];
+  snprintf(service, sizeof(service), "%u", (unsigned)port);
+
+  struct addrinfo *result = nullptr;
+  if (getaddrinfo(host, service, &hints, &result) != 0) return 0;
+
+  for (struct addrinfo *ai = result; ai != nullptr && _fd < 0; ai = ai->ai_next) {
+    int fd = socket(ai->ai_family, ai->ai_socktype | SOCK_NONBLOCK | SOCK_CLOEXEC, ai->ai_protocol);
+    if (fd < 0) continue;
+
+    int rc = ::connect(fd, ai->ai_addr, ai->ai_addrlen);
+    if (rc != 0 && errno == EINPROGRESS) {
+      struct pollfd pfd = {fd, POLLOUT, 0};
+      int err = 0;
+      socklen_t len = sizeof(err);
+      if (poll(&pfd, 1, (int)_connectTimeout) == 1 &&
+          getsockopt(fd, SOL_SOCKET, SO_ERROR, &err, &len) == 0 && err == 0) {
+        rc = 0;
+      }
+    }
+
+    if (rc == 0) {
+      _fd = fd;
+    } else {
+      ::close(fd);
+    }
+  }
+  freeaddrinfo(result);
+  if (_fd < 0) return 0;
+
+  // Requests are written in several small pieces; don't let Nagle hold them
+  int one = 1;
+  setsockopt(_fd, IPPROTO_TCP, TCP_NODELAY, &one, sizeof(one));
+
+  _peerClosed = false;
+  _head = _tail = 0;
+  if (!handshake(host)) {
+    stop();
+    return 0;
+  }
+  return 1;
+}
+
+bool PosixClient::handshake(const char *host) {
+  (void)host;
+  return true;
+}
+
+ssize_t PosixClient::transportRead(uint8_t *buf, size_t size) {
+  return recv(_fd, buf, size, 0);
+}
+
+ssize_t PosixClient::transportWrite(const uint8_t *buf, size_t size) {
+  return send(_fd, buf, size, MSG_NOSIGNAL);
+}
+
+bool PosixClient::waitFor(short events, int waitMs) {
+  struct pollfd pfd = {_fd, events, 0};
+  return poll(&pfd, 1, waitMs) > 0;
+}
+
+bool PosixClient::fill(int waitMs) {
+  if (_head < _tail) return true;
+  if (_fd < 0 || _peerClosed) return false;
+  _head = _tail = 0;
+
+  if (transportPending() == 0 && waitMs > 0 && !waitFor(POLLIN, waitMs)) return false;
+
+  ssize_t n = transportRead(_buffer, sizeof(_buffer));
+  if (n > 0) {
+    _tail = (size_t)n;
+    return true;
+  }
+  if (n == 0 || (errno != EAGAIN && errno != EWOULDBLOCK && errno != EINTR)) {
+    _peerClosed = true;
+  }
+  return false;
+}
+
+size_t PosixClient::write(uint8_t b) {
+  return write(&b, 1);
+}
+
+size_t PosixClient::write(const uint8_t *buf, size_t size) {
+  size_t written = 0;
+  while (_fd >= 0 && written < size) {
+    ssize_t n = transportWrite(buf + written, size - written);
+    if (n > 0) {
+      written += (size_t)n;
+    } else if (n < 0 && (errno == EAGAIN || errno == EWOULDBLOCK || errno == EINTR)) {
+      if (!waitFor(POLLOUT, (int)_connectTimeout)) break;
+    } else {
+      _peerClosed = true;
+      break;
+    }
+  }
+  return written;
+}
+
+int PosixClient::available() {
+  fill(_readWait);
+  return (int)(_tail - _head);
+}
+
+int PosixClient::read() {
+  if (!fill(0)) return -1;
+  return _buffer[_head++];
+}
+
+int PosixClient::read(uint8_t *buf, size_t size) {
+  if (!fill(0)) return -1;
+  size_t n = _tail - _head;
+  if (n > size) n = size;
+  memcpy(buf, _buffer + _head, n);
+  _head += n;
+  return (int)n;
+}
+
+int PosixClient::peek() {
+  if (!fill(0)) return -1;
+  return _buffer[_head];
+}
+
+void PosixClient::flush() {
+}
+
+void PosixClient::stop() {
+  if (_fd >= 0) {
+    transportClose();
+    ::close(_fd);
+    _fd = -1;
+  }
+  _peerClosed = false;
+  _head = _tail = 0;
+}
+
+uint8_t PosixClient::connected() {
+  if (_head < _tail) return 1;
+  if (_fd < 0) return 0;
+  if (!_peerClosed) {
+    // Notice an orderly shutdown without consuming data
+    fill(0);
+  }
+  return _head < _tail || !_peerClosed;
+}
@@ -0,0 +1,68 @@
+/*
+   Arduino Client over a plain POSIX TCP socket, for the host build of
+   UniversalTelegramBot. Use it on its own for plain-HTTP servers (a local
+   telegram-bot-api instance, the mock server) or through OpenSSLClient for
+   api.telegram.org.
+ */
+
+#ifndef PosixClient_h
+#define PosixClient_h
+
+#include <sys/types.h>
+
+#include <Client.h>
+
+#define POSIX_CLIENT_BUFFER_SIZE 4096
+
+class PosixClient : public Client {
+public:
+  PosixClient();
+  virtual ~PosixClient();
+
+  int connect(IPAddress ip, uint16_t port) override;
+  int connect(const char *host, uint16_t port) override;
+  size_t write(uint8_t b) override;
+  size_t write(const uint8_t *buf, size_t size) override;
+  int available() override;
+  int read() override;
+  int read(uint8_t *buf, size_t size) override;
+  int peek() override;
+  void flush() override;
+  void stop() override;
+  uint8_t connected() override;
+  operator bool() override { return _fd >= 0; }
+
+  using Print::write;
+
+  // Connect timeout in milliseconds
+  void setConnectTimeout(unsigned long ms) { _connectTimeout = ms; }
+  // How long available() may wait for data when nothing is buffered. The
+  // library polls available() in a tight loop while waiting for a response,
+  // a short wait here keeps that loop from spinning a core. 0 never blocks.
+  void setReadWait(int ms) { _readWait = ms; }
+
+  int fd() const { return _fd; }
+
+protected:
+  // Transport hooks, overridden by OpenSSLClient. Same contract as
+  // recv/send on a non-blocking socket: >0 bytes, 0 peer closed,
+  // -1 with errno EAGAIN when nothing can be done right now.
+  virtual bool handshake(const char *host);
+  virtual ssize_t transportRead(uint8_t *buf, size_t size);
+  virtual ssize_t transportWrite(const uint8_t *buf, size_t size);
+  virtual size_t transportPending() { return 0; }
+  virtual void transportClose() {}
+
+  bool fill(int waitMs);
+  bool waitFor(short events, int waitMs);
+
+  int _fd;
+  bool _peerClosed;
+  unsigned long _connectTimeout;
+  int _readWait;
+  uint8_t _buffer[POSIX_CLIENT_BUFFER_SIZE];
+  size_t _head;
+  size_t _tail;
+};
+
+#endif
@@ -0,0 +1,138 @@
+#include "PosixUDP.h"
+
+#include <arpa/inet.h>
+#include <fcntl.h>
+#include <netdb.h>
+#include <netinet/in.h>
+#include <string.h>
+#include <sys/socket.h>
+#include <unistd.h>
+
+#define POSIX_UDP_MAX_DATAGRAM 65535
+
+PosixUDP::PosixUDP() : _fd(-1), _destPort(0), _inPos(0), _remotePort(0) {
+}
+
+PosixUDP::~PosixUDP() {
+  stop();
+}
+
+bool PosixUDP::open() {
+  if (_fd >= 0) return true;
+  _fd = socket(AF_INET, SOCK_DGRAM | SOCK_NONBLOCK | SOCK_CLOEXEC, 0);
+  return _fd >= 0;
+}
+
+uint8_t PosixUDP::begin(uint16_t port) {
+  stop();
+  if (!open()) return 0;
+
+  int on = 1;
+  setsockopt(_fd, SOL_SOCKET, SO_REUSEADDR, &on, sizeof(on));
+  setsockopt(_fd, SOL_SOCKET, SO_BROADCAST, &on, sizeof(on));
+  struct sockaddr_in addr = {};
+  addr.sin_family = AF_INET;
+  addr.sin_addr.s_addr = htonl(INADDR_ANY);
+  addr.sin_port = htons(port);
+  if (bind(_fd, (struct sockaddr *)&addr, sizeof(addr)) < 0) {
+    stop();
+    return 0;
+  }
+  return 1;
+}
+
+void PosixUDP::stop() {
+  if (_fd >= 0) close(_fd);
+  _fd = -1;
+  _in.clear();
+  _inPos = 0;
+}
+
+int PosixUDP::beginPacket(IPAddress ip, uint16_t port) {
+  if (!open()) return 0;
+  _destIP = ip;
+  _destPort = port;
+  _out.clear();
+  return 1;
+}
+
+int PosixUDP::beginPacket(const char *host, uint16_t port) {
+  struct addrinfo hints = {};
+  hints.ai_family = AF_INET;
+  hints.ai_socktype = SOCK_DGRAM;
+  struct addrinfo *result = nullptr;
+  if (getaddrinfo(host, nullptr, &hints, &result) != 0 || !result) return 0;
+
+  uint32_t address = ntohl(((struct sockaddr_in *)result->ai_addr)->sin_addr.s_addr);
+  freeaddrinfo(result);
+  return beginPacket(IPAddress(address >> 24, address >> 16, address >> 8, address), port);
+}
+
+int PosixUDP::endPacket() {
+  if (_fd < 0 || _destPort == 0) return 0;
+
+  struct sockaddr_in addr = {};
+  addr.sin_family = AF_INET;
+  addr.sin_addr.s_addr =
+      htonl((uint32_t)_destIP[0] << 24 | _destIP[1] << 16 | _destIP[2] << 8 | _destIP[3]);
+  addr.sin_port = htons(_destPort);
+  ssize_t sent = sendto(_fd, _out.data(), _out.size(), 0, (struct sockaddr *)&addr, sizeof(addr));
+  _out.clear();
+  return sent >= 0 ? 1 : 0;
+}
+
+size_t PosixUDP::write(uint8_t b) {
+  return write(&b, 1);
+}
+
+size_t PosixUDP::write(const uint8_t *buffer, size_t size) {
+  if (_out.size() + size > POSIX_UDP_MAX_DATAGRAM) size = POSIX_UDP_MAX_DATAGRAM - _out.size();
+  _out.insert(_out.end(), buffer, buffer + size);
+  return size;
+}
+
+int PosixUDP::parsePacket() {
+  _in.clear();
+  _inPos = 0;
+  if (_fd < 0) return 0;
+
+  _in.resize(POSIX_UDP_MAX_DATAGRAM);
+  struct sockaddr_in addr = {};
+  socklen_t length = sizeof(addr);
+  ssize_t n = recvfrom(_fd, _in.data(), _in.size(), 0, (struct sockaddr *)&addr, &length);
+  if (n <= 0) {
+    _in.clear();
+    return 0;
+  }
+  _in.resize(n);
+
+  uint32_t address = ntohl(addr.sin_addr.s_addr);
+  _remoteIP = IPAddress(address >> 24, address >> 16, address >> 8, address);
+  _remotePort = ntohs(addr.sin_port);
+  return (int)n;
+}
+
+int PosixUDP::available() {
+  return (int)(_in.size() - _inPos);
+}
+
+int PosixUDP::read() {
+  return _inPos < _in.size() ? _in[_inPos++] : -1;
+}
+
+int PosixUDP::read(unsigned char *buffer, size_t len) {
+  size_t n = _in.size() - _inPos;
+  if (n == 0) return -1;
+  if (n > len) n = len;
+  memcpy(buffer, _in.data() + _inPos, n);
+  _inPos += n;
+  return (int)n;
+}
+
+int PosixUDP::read(char *buffer, size_t len) {
+  return read((unsigned char *)buffer, len);
+}
+
+int PosixUDP::peek() {
+  return _inPos < _in.size() ? _in[_inPos] : -1;
+}
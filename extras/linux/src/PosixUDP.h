@@ -0,0 +1,55 @@
+/*
+   Arduino UDP over a POSIX datagram socket, the host counterpart of
+   WiFiUDP. Never blocks: parsePacket() returns 0 when nothing has arrived.
+ */
+
+#ifndef PosixUDP_h
+#define PosixUDP_h
+
+#include <vector>
+
+#include <Udp.h>
+
+class PosixUDP : public UDP {
+public:
+  PosixUDP();
+  ~PosixUDP();
+
+  uint8_t begin(uint16_t port) override;
+  void stop() override;
+
+  int beginPacket(IPAddress ip, uint16_t port) override;
+  int beginPacket(const char *host, uint16_t port) override;
+  int endPacket() override;
+  size_t write(uint8_t b) override;
+  size_t write(const uint8_t *buffer, size_t size) override;
+
+  int parsePacket() override;
+  int available() override;
+  int read() override;
+  int read(unsigned char *buffer, size_t len) override;
+  int read(char *buffer, size_t len) override;
+  int peek() override;
+  void flush() override {}
+
+  IPAddress remoteIP() override { return _remoteIP; }
+  uint16_t remotePort() override { return _remotePort; }
+
+  using Print::write;
+
+  int fd() const { return _fd; }
+
+private:
+  bool open();
+
+  int _fd;
+  IPAddress _destIP;
+  uint16_t _destPort;
+  std::vector<uint8_t> _out;
+  std::vector<uint8_t> _in;
+  size_t _inPos;
+  IPAddress _remoteIP;
+  uint16_t _remotePort;
+};
+
+#endif
@@ -0,0 +1,174 @@
+#include "RecordingClient.h"
+
+#include <string.h>
+
+RecordingClient::RecordingClient(Client &inner, const char *path, const String &token)
+    : granularityUs(1000), _inner(inner), _file(fopen(path, "wb")), _token(token.c_str()),
+      _start(micros()), _open(false), _type(0), _first(0), _last(0),
+      _heldAt(0), _carried(0) {
+  if (_file) fprintf(_file, RECORDING_MAGIC "\n");
+}
+
+RecordingClient::~RecordingClient() {
+  sync();
+  if (_file) fclose(_file);
+}
+
+uint64_t RecordingClient::now() const {
+  return (uint64_t)(micros() - _start);
+}
+
+void RecordingClient::sync() {
+  writeRecord();
+  writeHeld();
+  if (_file) fflush(_file);
+}
+
+void RecordingClient::emit(char type, uint64_t first, uint64_t last, const std::string &data) {
+  if (!_file) return;
+  fprintf(_file, "%c %llu %llu %zu\n", type, (unsigned long long)first,
+          (unsigned long long)last, data.size());
+  fwrite(data.data(), 1, data.size(), _file);
+  fputc('\n', _file);
+}
+
+void RecordingClient::writeRecord() {
+  if (_type == 0) return;
+  size_t carried = _carried;
+  _carried = 0;
+
+  size_t found = std::string::npos;
+  if (!_token.empty()) {
+    found = _data.find(_token);
+    for (size_t at = found; at != std::string::npos;
+         at = _data.find(_token, at + strlen(REDACTED_TOKEN))) {
+      _data.replace(at, _token.size(), REDACTED_TOKEN);
+    }
+  }
+
+  if (_type == 'W' && !_token.empty()) {
+    // A write that paused in the middle of the token would leave its two
+    // halves in different records; a tail that may be its start waits for
+    // the next write to tell
+    size_t keep = _token.size() - 1;
+    if (keep > _data.size()) keep = _data.size();
+    for (; keep > 0; keep--) {
+      if (_data.compare(_data.size() - keep, keep, _token, 0, keep) == 0) break;
+    }
+    if (keep > 0) {
+      _held.assign(_data, _data.size() - keep, keep);
+      _heldAt = _last;
+      _data.resize(_data.size() - keep);
+    }
+
+    // The start carried over from the last write did not turn into the
+    // token here, yet it is the beginning of it all the same
+    if (carried > _data.size()) carried = _data.size();
+    if (carried > 0 && (found == std::string::npos || found >= carried)) {
+      _data.replace(0, carried, REDACTED_TOKEN);
+    }
+  }
+
+  if (!_data.empty() || _type != 'W') emit(_type, _first, _last, _data);
+  _type = 0;
+  _data.clear();
+}
+
+/***************************************************************
+ * WriteHeld - writes out a held back start of the token that  *
+ * no further write completed, redacted like the token itself  *
+ ***************************************************************/
+void RecordingClient::writeHeld() {
+  if (_held.empty()) return;
+  emit('W', _heldAt, _heldAt, REDACTED_TOKEN);
+  _held.clear();
+}
+
+void RecordingClient::append(char type, const uint8_t *data, size_t size) {
+  uint64_t t = now();
+  if (_type != type || t - _last > granularityUs) {
+    writeRecord();
+    _type = type;
+    _first = t;
+    if (type == 'W' && !_held.empty()) {
+      // Carried over into this record, where the token can be found whole
+      _data.swap(_held);
+      _carried = _data.size();
+      _first = _heldAt;
+    } else {
+      writeHeld();
+    }
+  }
+  _last = t;
+  _data.append((const char *)data, size);
+}
+
+void RecordingClient::event(char type, const std::string &payload) {
+  writeRecord();
+  writeHeld();
+  _type = type;
+  _first = _last = now();
+  _data = payload;
+  writeRecord();
+}
+
+int RecordingClient::connect(IPAddress ip, uint16_t port) {
+  int result = _inner.connect(ip, port);
+  char target[32];
+  snprintf(target, sizeof(target), "%u.%u.%u.%u:%u", ip[0], ip[1], ip[2], ip[3], port);
+  event(result ? 'C' : 'F', target);
+  _open = result != 0;
+  return result;
+}
+
+int RecordingClient::connect(const char *host, uint16_t port) {
+  int result = _inner.connect(host, port);
+  event(result ? 'C' : 'F', std::string(host) + ":" + std::to_string(port));
+  _open = result != 0;
+  return result;
+}
+
+size_t RecordingClient::write(uint8_t b) {
+  return write(&b, 1);
+}
+
+size_t RecordingClient::write(const uint8_t *buf, size_t size) {
+  size_t written = _inner.write(buf, size);
+  if (written > 0) append('W', buf, written);
+  return written;
+}
+
+int RecordingClient::available() {
+  return _inner.available();
+}
+
+int RecordingClient::read() {
+  int c = _inner.read();
+  if (c >= 0) {
+    uint8_t b = (uint8_t)c;
+    append('R', &b, 1);
+  }
+  return c;
+}
+
+int RecordingClient::read(uint8_t *buf, size_t size) {
+  int n = _inner.read(buf, size);
+  if (n > 0) append('R', buf, n);
+  return n;
+}
+
+void RecordingClient::stop() {
+  _inner.stop();
+  if (_open) event('S');
+  _open = false;
+}
+
+uint8_t RecordingClient::connected() {
+  uint8_t result = _inner.connected();
+  if (!result && _open) {
+    // The server hung up; the library finds out here
+    event('E');
+    _open = false;
+  }
+  return result;
+}
@@ -0,0 +1,92 @@
+/*
+   Arduino Client decorator that records a session's byte stream to a file,
+   for replaying it later with ReplayClient.
+
+     OpenSSLClient tls;
+     RecordingClient client(tls, "incident.utbrec", token);
+     UniversalTelegramBot bot(token, client);
+
+   Every connect, write, read, stop and server-side close is stored with its
+   start and end time in microseconds since the recording began. Consecutive
+   reads (or writes) are merged into one record until the direction changes
+   or the stream pauses for longer than granularityUs, so the records follow
+   how the data arrived off the network. Occurrences of the token are
+   replaced by REDACTED_TOKEN before anything reaches the file, also when
+   a pause splits one over two writes: the end of a write that could be
+   the start of the token is held back for the next one, and written as
+   REDACTED_TOKEN as well if that does not complete it.
+
+   File format, after the line "UTBREC 1":
+
+     <type> <start us> <end us> <length>\n<length bytes>\n
+
+   with type C (connected, payload host:port), F (connect failed), W (bytes
+   written), R (bytes read), E (server closed the connection) or S (stopped
+   by the library).
+ */
+
+#ifndef RecordingClient_h
+#define RecordingClient_h
+
+#include <stdint.h>
+#include <stdio.h>
+
+#include <string>
+
+#include <Arduino.h>
+#include <Client.h>
+
+#define RECORDING_MAGIC "UTBREC 1"
+#define REDACTED_TOKEN "<redacted>"
+
+class RecordingClient : public Client {
+public:
+  RecordingClient(Client &inner, const char *path, const String &token = String());
+  ~RecordingClient();
+
+  bool ok() const { return _file != nullptr; }
+  // Writes out the pending record and flushes the file
+  void sync();
+
+  unsigned long granularityUs;
+
+  int connect(IPAddress ip, uint16_t port) override;
+  int connect(const char *host, uint16_t port) override;
+  size_t write(uint8_t b) override;
+  size_t write(const uint8_t *buf, size_t size) override;
+  int available() override;
+  int read() override;
+  int read(uint8_t *buf, size_t size) override;
+  int peek() override { return _inner.peek(); }
+  void flush() override { _inner.flush(); }
+  void stop() override;
+  uint8_t connected() override;
+  operator bool() override { return (bool)_inner; }
+
+  using Print::write;
+
+private:
+  void append(char type, const uint8_t *data, size_t size);
+  void event(char type, const std::string &payload = std::string());
+  void writeRecord();
+  void writeHeld();
+  void emit(char type, uint64_t first, uint64_t last, const std::string &data);
+  uint64_t now() const;
+
+  Client &_inner;
+  FILE *_file;
+  std::string _token;
+  uint64_t _start;
+  bool _open;          // last connect succeeded and no close was recorded yet
+
+  char _type;          // pending record, 0 when none
+  uint64_t _first;
+  uint64_t _last;
+  std::string _data;
+
+  std::string _held;   // end of the last W record, maybe part of the token
+  uint64_t _heldAt;
+  size_t _carried;     // bytes of _data that were held back
+};
+
+#endif
@@ -0,0 +1,182 @@
+#include "ReplayClient.h"
+
+#include <stdio.h>
+#include <string.h>
+
+#include "RecordingClient.h"
+
+ReplayClient::ReplayClient()
+    : speed(1.0), divergences(0), bytesWritten(0), bytesRead(0), waitedUs(0), _cursor(0),
+      _offset(0), _mark(0), _connected(false), _serverClosed(false) {
+}
+
+bool ReplayClient::open(const char *path) {
+  FILE *f = fopen(path, "rb");
+  if (!f) return false;
+
+  _records.clear();
+  char line[128];
+  bool ok = fgets(line, sizeof(line), f) &&
+            strncmp(line, RECORDING_MAGIC, strlen(RECORDING_MAGIC)) == 0;
+  while (ok && fgets(line, sizeof(line), f)) {
+    Record record;
+    unsigned long long start, end;
+    size_t length;
+    if (sscanf(line, "%c %llu %llu %zu", &record.type, &start, &end, &length) != 4) {
+      ok = false;
+      break;
+    }
+    record.start = start;
+    record.end = end;
+    record.data.resize(length);
+    if (fread(&record.data[0], 1, length, f) != length || fgetc(f) != '\n') {
+      ok = false;
+      break;
+    }
+    _records.push_back(record);
+  }
+  fclose(f);
+
+  rewind();
+  return ok;
+}
+
+void ReplayClient::rewind() {
+  _cursor = 0;
+  _offset = 0;
+  _mark = micros();
+  _connected = false;
+  _serverClosed = false;
+  divergences = 0;
+  bytesWritten = 0;
+  bytesRead = 0;
+  waitedUs = 0;
+}
+
+void ReplayClient::advance() {
+  _cursor++;
+  _offset = 0;
+  _mark = micros();
+}
+
+void ReplayClient::skipEvents() {
+  // A server close takes effect as soon as playback reaches it; data read
+  // after it was already buffered and stays readable
+  while (current() && current()->type == 'E') {
+    _serverClosed = true;
+    advance();
+  }
+}
+
+unsigned long ReplayClient::pauseUs() const {
+  if (speed <= 0) return 0;
+
+  const Record &record = _records[_cursor];
+  uint64_t previousEnd = _cursor > 0 ? _records[_cursor - 1].end : record.start;
+  uint64_t gap = record.start > previousEnd ? record.start - previousEnd : 0;
+  return (unsigned long)(gap / speed);
+}
+
+bool ReplayClient::ready() {
+  return _offset > 0 || micros() - _mark >= pauseUs();
+}
+
+int ReplayClient::connect(IPAddress, uint16_t port) {
+  return connect("", port);
+}
+
+int ReplayClient::connect(const char *, uint16_t) {
+  // The recorded library had stopped or been dropped before connecting
+  while (current() && (current()->type == 'E' || current()->type == 'S')) advance();
+
+  const Record *record = current();
+  if (!record) return 0;
+  if (record->type == 'F') {
+    advance();
+    return 0;
+  }
+
+  if (record->type == 'C') {
+    advance();
+  } else {
+    divergences++; // the recorded session kept its connection here
+  }
+  _connected = true;
+  _serverClosed = false;
+  return 1;
+}
+
+size_t ReplayClient::write(uint8_t b) {
+  return write(&b, 1);
+}
+
+size_t ReplayClient::write(const uint8_t *, size_t size) {
+  if (!_connected || _serverClosed) return 0;
+  bytesWritten += size;
+
+  skipEvents();
+  bool consumed = false;
+  while (current() && current()->type == 'W') {
+    advance();
+    consumed = true;
+  }
+  if (consumed) return size;
+
+  const Record *record = current();
+  if (record && record->type == 'R' && _offset == 0) {
+    // More of the same request; the answer's delay counts from here
+    _mark = micros();
+  } else {
+    divergences++;
+  }
+  return size;
+}
+
+int ReplayClient::available() {
+  if (!_connected) return 0;
+  skipEvents();
+  const Record *record = current();
+  if (!record || record->type != 'R' || !ready()) return 0;
+  return (int)(record->data.size() - _offset);
+}
+
+int ReplayClient::read() {
+  uint8_t b;
+  return read(&b, 1) == 1 ? b : -1;
+}
+
+int ReplayClient::read(uint8_t *buf, size_t size) {
+  size_t n = available();
+  if (n == 0) return -1;
+  if (n > size) n = size;
+
+  const Record &record = _records[_cursor];
+  if (_offset == 0) waitedUs += pauseUs();
+  memcpy(buf, record.data.data() + _offset, n);
+  _offset += n;
+  bytesRead += n;
+  if (_offset == record.data.size()) advance();
+  return (int)n;
+}
+
+int ReplayClient::peek() {
+  if (!available()) return -1;
+  return (uint8_t)_records[_cursor].data[_offset];
+}
+
+void ReplayClient::stop() {
+  _connected = false;
+  skipEvents();
+  if (current() && current()->type == 'S') {
+    advance();
+  } else if (current() && current()->type == 'R') {
+    // The recorded library read on where this one gives up
+    divergences++;
+    while (current() && current()->type == 'R') advance();
+  }
+}
+
+uint8_t ReplayClient::connected() {
+  skipEvents();
+  return _connected && !_serverClosed && !finished();
+}
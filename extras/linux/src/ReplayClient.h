@@ -0,0 +1,93 @@
+/*
+   Arduino Client that plays back a session recorded by RecordingClient, so
+   a captured incident (a burst of updates, a slow TLS link) can be run
+   again against a newer library build and compared.
+
+     ReplayClient client;
+     client.open("incident.utbrec");
+     client.speed = 1.0;              // original timing, 2 = twice as fast, 0 = no waits
+     UniversalTelegramBot bot("1:x", client);
+     while (!client.finished()) bot.getUpdates(bot.last_message_received + 1);
+
+   The server side is replayed: what the library writes is taken as the
+   request without comparing it, and the recorded reads become readable
+   with the recorded pauses. Each pause is measured from the end of the
+   record before it, so the gap between a request and its answer (server
+   and network latency) and between the fragments of an answer keep their
+   length however fast or slow the library under test is. A recorded server
+   close turns connected() false and a recorded connect failure is returned
+   from connect().
+
+   A library that takes a different path than the recorded one (reconnects
+   where the old one kept the connection, writes in the middle of an
+   answer) is carried along as well as possible and counted in divergences.
+ */
+
+#ifndef ReplayClient_h
+#define ReplayClient_h
+
+#include <stdint.h>
+
+#include <string>
+#include <vector>
+
+#include <Arduino.h>
+#include <Client.h>
+
+class ReplayClient : public Client {
+public:
+  ReplayClient();
+
+  // Loads a recording; false if it cannot be read or is not one
+  bool open(const char *path);
+  // Starts the playback over
+  void rewind();
+
+  double speed;  // timing scale, 1 = as recorded, 0 = no waits at all
+
+  // Everything recorded has been played back
+  bool finished() const { return _cursor >= _records.size(); }
+
+  int connect(IPAddress ip, uint16_t port) override;
+  int connect(const char *host, uint16_t port) override;
+  size_t write(uint8_t b) override;
+  size_t write(const uint8_t *buf, size_t size) override;
+  int available() override;
+  int read() override;
+  int read(uint8_t *buf, size_t size) override;
+  int peek() override;
+  void flush() override {}
+  void stop() override;
+  uint8_t connected() override;
+  operator bool() override { return _connected; }
+
+  using Print::write;
+
+  unsigned long divergences;
+  unsigned long long bytesWritten;
+  unsigned long long bytesRead;
+  unsigned long long waitedUs;  // recorded pauses played back, server and network time
+
+private:
+  struct Record {
+    char type;
+    uint64_t start;
+    uint64_t end;
+    std::string data;
+  };
+
+  const Record *current() const { return finished() ? nullptr : &_records[_cursor]; }
+  void advance();
+  void skipEvents();
+  unsigned long pauseUs() const;  // pause before the current read record
+  bool ready();
+
+  std::vector<Record> _records;
+  size_t _cursor;
+  size_t _offset;         // bytes of the current R record already read
+  unsigned long _mark;    // micros() when the previous record was played
+  bool _connected;
+  bool _serverClosed;
+};
+
+#endif
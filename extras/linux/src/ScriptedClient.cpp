@@ -0,0 +1,125 @@
+#include "ScriptedClient.h"
+
+#include <stdio.h>
+#include <string.h>
+
+ScriptedClient::ScriptedClient()
+    : connects(0), requests(0), bytesWritten(0), bytesRead(0), _pos(0), _connected(false) {
+}
+
+void ScriptedClient::respond(const std::string &pattern, const std::string &response) {
+  _script.push_back(std::make_pair(pattern, response));
+}
+
+void ScriptedClient::load(const std::string &response) {
+  _response = response;
+  _pos = 0;
+  _connected = true;
+}
+
+int ScriptedClient::connect(IPAddress, uint16_t) {
+  connects++;
+  _connected = true;
+  return 1;
+}
+
+int ScriptedClient::connect(const char *, uint16_t) {
+  connects++;
+  _connected = true;
+  return 1;
+}
+
+size_t ScriptedClient::write(uint8_t b) {
+  return write(&b, 1);
+}
+
+size_t ScriptedClient::write(const uint8_t *buf, size_t size) {
+  if (!_connected) return 0;
+  _request.append((const char *)buf, size);
+  bytesWritten += size;
+  return size;
+}
+
+void ScriptedClient::answer() {
+  if (_pos < _response.size() || _request.empty()) return;
+
+  std::string line = _request.substr(0, _request.find("\r\n"));
+  _lastRequest.swap(_request);
+  _request.clear();
+  requests++;
+
+  for (size_t i = 0; i < _script.size(); i++) {
+    if (line.find(_script[i].first) != std::string::npos) {
+      _response = _script[i].second;
+      _pos = 0;
+      return;
+    }
+  }
+  _response = telegramHttpResponse("{\"ok\":false,\"error_code\":404,\"description\":\"Not Found\"}", 404);
+  _pos = 0;
+}
+
+int ScriptedClient::available() {
+  if (!_connected) return 0;
+  answer();
+  return (int)(_response.size() - _pos);
+}
+
+int ScriptedClient::read() {
+  if (!available()) return -1;
+  bytesRead++;
+  return (uint8_t)_response[_pos++];
+}
+
+int ScriptedClient::read(uint8_t *buf, size_t size) {
+  size_t n = available();
+  if (n > size) n = size;
+  memcpy(buf, _response.data() + _pos, n);
+  _pos += n;
+  bytesRead += n;
+  return (int)n;
+}
+
+int ScriptedClient::peek() {
+  if (!available()) return -1;
+  return (uint8_t)_response[_pos];
+}
+
+void ScriptedClient::stop() {
+  _connected = false;
+  _request.clear();
+  _response.clear();
+  _pos = 0;
+}
+
+std::string telegramHttpResponse(const std::string &body, int status, size_t chunkSize) {
+  char line[64];
+  snprintf(line, sizeof(line), "HTTP/1.1 %d %s\r\n", status,
+           status == 200 ? "OK" : status == 429 ? "Too Many Requests" : "Not Found");
+
+  std::string out = line;
+  out += "Server: nginx/1.18.0\r\n"
+         "Date: Mon, 01 Jan 2024 00:00:00 GMT\r\n"
+         "Content-Type: application/json\r\n";
+  if (chunkSize > 0) {
+    out += "Transfer-Encoding: chunked\r\n";
+  } else {
+    out += "Content-Length: " + std::to_string(body.size()) + "\r\n";
+  }
+  out += "Connection: keep-alive\r\n"
+         "Strict-Transport-Security: max-age=31536000; includeSubDomains; preload\r\n"
+         "Access-Control-Allow-Origin: *\r\n"
+         "Access-Control-Expose-Headers: Content-Length,Content-Type,Date,Server,Connection\r\n"
+         "\r\n";
+
+  if (chunkSize == 0) return out + body;
+
+  for (size_t i = 0; i < body.size(); i += chunkSize) {
+    size_t n = body.size() - i < chunkSize ? body.size() - i : chunkSize;
+    snprintf(line, sizeof(line), "%zx\r\n", n);
+    out += line;
+    out.append(body, i, n);
+    out += "\r\n";
+  }
+  return out + "0\r\n\r\n";
+}
@@ -0,0 +1,75 @@
+/*
+   In-memory Arduino Client that answers requests from a script instead of
+   the network, for benchmarks and tests of the host build.
+
+     ScriptedClient client;
+     client.respond("/getUpdates", httpResponse);
+     client.respond("/sendMessage", okResponse);
+     UniversalTelegramBot bot("1:x", client);
+
+   Whatever the library writes is collected as the pending request. The first
+   time it then looks for data, the request line is matched against the
+   script (first rule whose pattern is contained in it wins) and the canned
+   response becomes readable. Unmatched requests get a 404.
+ */
+
+#ifndef ScriptedClient_h
+#define ScriptedClient_h
+
+#include <string>
+#include <utility>
+#include <vector>
+
+#include <Client.h>
+
+class ScriptedClient : public Client {
+public:
+  ScriptedClient();
+
+  // Canned response, status line and headers included, for requests whose
+  // request line contains pattern
+  void respond(const std::string &pattern, const std::string &response);
+  void clearScript() { _script.clear(); }
+  // Makes response readable right away, without a request
+  void load(const std::string &response);
+
+  int connect(IPAddress ip, uint16_t port) override;
+  int connect(const char *host, uint16_t port) override;
+  size_t write(uint8_t b) override;
+  size_t write(const uint8_t *buf, size_t size) override;
+  int available() override;
+  int read() override;
+  int read(uint8_t *buf, size_t size) override;
+  int peek() override;
+  void flush() override {}
+  void stop() override;
+  uint8_t connected() override { return _connected; }
+  operator bool() override { return _connected; }
+
+  using Print::write;
+
+  // The last complete request as written by the library
+  const std::string &lastRequest() const { return _lastRequest; }
+
+  unsigned long connects;
+  unsigned long requests;
+  unsigned long long bytesWritten;
+  unsigned long long bytesRead;
+
+private:
+  void answer();
+
+  std::vector<std::pair<std::string, std::string> > _script;
+  std::string _request;
+  std::string _lastRequest;
+  std::string _response;
+  size_t _pos;
+  bool _connected;
+};
+
+// Wraps a body into a response the way api.telegram.org sends it. A
+// chunkSize above 0 switches to Transfer-Encoding: chunked.
+std::string telegramHttpResponse(const std::string &body, int status = 200,
+                                 size_t chunkSize = 0);
+
+#endif
@@ -0,0 +1,150 @@
+/*
+   Checks command routing (TelegramCommands.h) through bot.on() and
+   bot.dispatch(): the perfect hash finds every registered command,
+   "/cmd@Bot" is stripped or left alone by bot name, ignoring case,
+   arguments are split and message.text is restored after the handler, or
+   left as the handler set it after args.release().
+
+     commands_test
+
+   Exits with 1 and names the failed checks if any.
+ */
+
+#include <stdio.h>
+#include <string.h>
+
+#include <string>
+#include <vector>
+
+#include <ScriptedClient.h>
+#include <UniversalTelegramBot.h>
+
+static unsigned long failures = 0;
+
+static void check(bool ok, const char *what) {
+  if (ok) return;
+  printf("FAILED: %s\n", what);
+  failures++;
+}
+
+// What the last handler saw
+static const char *called = nullptr;
+static std::vector<std::string> seenArgs;
+
+static void record(const char *name, TelegramCommandArgs &args) {
+  called = name;
+  seenArgs.clear();
+  for (int i = 0; i < args.count(); i++) seenArgs.push_back(args[i]);
+}
+
+static void onStatus(UniversalTelegramBot &, telegramMessage &, TelegramCommandArgs &args) {
+  record("status", args);
+}
+
+static void onSay(UniversalTelegramBot &, telegramMessage &, TelegramCommandArgs &args) {
+  record("say", args);
+}
+
+// Replaces the text with one of the same length, which reuses its buffer
+static void onLed(UniversalTelegramBot &, telegramMessage &message, TelegramCommandArgs &args) {
+  record("led", args);
+  args.release();
+  message.text = "done    ";
+}
+
+static bool dispatch(UniversalTelegramBot &bot, const char *text, telegramMessage &message) {
+  called = nullptr;
+  message.text = text;
+  return bot.dispatch(message);
+}
+
+static void routing() {
+  ScriptedClient client;
+  UniversalTelegramBot bot("123456:TOKEN", client);
+  telegramMessage message;
+
+  check(bot.on("/status", onStatus), "register /status");
+  check(bot.on("say", onSay), "register say without its '/'");
+  check(bot.on("/led", onLed), "register /led");
+
+  check(dispatch(bot, "/status", message) && called && !strcmp(called, "status"), "/status");
+  check(dispatch(bot, "/say hi", message) && called && !strcmp(called, "say"), "/say");
+  check(!dispatch(bot, "/stat", message) && !called, "a prefix of a command is no command");
+  check(!dispatch(bot, "/statusx", message) && !called, "a longer name is no command");
+  check(!dispatch(bot, "status", message), "text without '/'");
+  check(!dispatch(bot, "", message), "empty text");
+
+  // Before getMe() there is no name to compare against
+  check(dispatch(bot, "/status@AnyBot", message), "any bot name before getMe()");
+
+  bot.userName = "KitchenBot";
+  check(dispatch(bot, "/status@KitchenBot", message), "/status@KitchenBot");
+  check(dispatch(bot, "/status@kitchenbot", message), "bot name ignoring case");
+  check(dispatch(bot, "/say@KITCHENBOT  hi there", message) && seenArgs.size() == 2 &&
+            seenArgs[0] == "hi" && seenArgs[1] == "there",
+        "arguments after the bot name");
+  check(!dispatch(bot, "/status@GarageBot", message) && !called, "command for another bot");
+  check(!dispatch(bot, "/status@KitchenBot2", message), "bot name with more after it");
+  check(message.text == "/status@KitchenBot2", "text of an undispatched command is untouched");
+}
+
+static void arguments() {
+  ScriptedClient client;
+  UniversalTelegramBot bot("123456:TOKEN", client);
+  bot.on("/say", onSay);
+  bot.on("/led", onLed);
+  telegramMessage message;
+
+  dispatch(bot, "/say", message);
+  check(seenArgs.empty(), "no arguments");
+
+  dispatch(bot, "/say  one \t two\nthree  ", message);
+  check(seenArgs.size() == 3 && seenArgs[0] == "one" && seenArgs[1] == "two" &&
+            seenArgs[2] == "three",
+        "arguments split at any whitespace, trailing blanks dropped");
+  check(message.text == "/say  one \t two\nthree  ", "text restored after the handler");
+
+  std::string many = "/say";
+  for (int i = 1; i <= TELEGRAM_MAX_COMMAND_ARGS + 2; i++) many += " a" + std::to_string(i);
+  dispatch(bot, many.c_str(), message);
+  std::string rest;
+  for (int i = TELEGRAM_MAX_COMMAND_ARGS; i <= TELEGRAM_MAX_COMMAND_ARGS + 2; i++) {
+    rest += (rest.empty() ? "a" : " a") + std::to_string(i);
+  }
+  check(seenArgs.size() == TELEGRAM_MAX_COMMAND_ARGS && seenArgs.back() == rest,
+        "the last argument keeps the rest of the text");
+  check(message.text == many.c_str(), "long text restored after the handler");
+
+  dispatch(bot, "/led on  ", message);
+  check(seenArgs.size() == 1 && seenArgs[0] == "on", "/led argument");
+  check(message.text == "done    ", "text the handler set after release() is kept");
+}
+
+static void manyCommands() {
+  ScriptedClient client;
+  UniversalTelegramBot bot("123456:TOKEN", client);
+  telegramMessage message;
+
+  static char names[TELEGRAM_MAX_COMMANDS + 1][16];
+  for (int i = 0; i <= TELEGRAM_MAX_COMMANDS; i++) {
+    snprintf(names[i], sizeof(names[i]), "/cmd%d", i);
+    bool added = bot.on(names[i], onStatus);
+    check(added == (i < TELEGRAM_MAX_COMMANDS), "TELEGRAM_MAX_COMMANDS commands register");
+  }
+  int found = 0;
+  for (int i = 0; i <= TELEGRAM_MAX_COMMANDS; i++) {
+    if (dispatch(bot, names[i], message)) found++;
+  }
+  check(found == TELEGRAM_MAX_COMMANDS, "every registered command is found");
+  check(bot.on("/cmd3", onSay), "replacing a handler when full");
+  check(dispatch(bot, "/cmd3", message) && called && !strcmp(called, "say"), "replaced handler");
+}
+
+int main() {
+  routing();
+  arguments();
+  manyCommands();
+
+  printf("%lu failures\n", failures);
+  return failures ? 1 : 0;
+}
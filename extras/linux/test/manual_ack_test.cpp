@@ -0,0 +1,113 @@
+/*
+   Checks manual acknowledgement (TelegramAck.h) against scripted getUpdates
+   answers: which offset a poll confirms, that outstanding updates are not
+   handed out twice, and that an answer too long for maxMessageLength
+   behind an outstanding update is not fetched again on every poll.
+
+     manual_ack_test
+
+   Exits with 1 and names the failed checks if any.
+ */
+
+#include <stdio.h>
+
+#include <string>
+
+#include <ScriptedClient.h>
+#include <UniversalTelegramBot.h>
+
+static unsigned long failures = 0;
+
+static void check(bool ok, const char *what) {
+  if (ok) return;
+  printf("FAILED: %s\n", what);
+  failures++;
+}
+
+// Laid out like the bench corpus, the update_id ending the first line
+// where getUpdateIdFromResponse looks for it
+static std::string update(long updateId, const std::string &text) {
+  return "{\"update_id\":" + std::to_string(updateId) +
+         ",\n\"message\":{\"message_id\":" + std::to_string(updateId) +
+         ",\"from\":{\"id\":100200300,\"is_bot\":false,\"first_name\":\"Alex\"}"
+         ",\"chat\":{\"id\":100200300,\"type\":\"private\"},\"date\":1704067200"
+         ",\"text\":\"" + text + "\"}}";
+}
+
+static std::string updates(const std::string &results) {
+  return telegramHttpResponse("{\"ok\":true,\"result\":[" + results + "]}");
+}
+
+// Answers hold no more updates than the poll's limit, as Telegram's do:
+// HANDLE_MESSAGES (1) new ones on top of those outstanding
+
+static void outstandingUpdates() {
+  ScriptedClient client;
+  UniversalTelegramBot bot("123456:TOKEN", client);
+  bot.setManualAck(true);
+
+  client.respond("/getUpdates?offset=1&", updates(update(5, "/led on")));
+  check(bot.getUpdates(1) == 1, "first poll hands out update 5");
+
+  // Asked for 6, the poll still confirms no further than the acks and
+  // fetches 5 again along with the next one
+  client.clearScript();
+  client.respond("/getUpdates?offset=1&", updates(update(5, "/led on") + "," + update(6, "hi")));
+  check(bot.getUpdates(6) == 1, "only update 6 is handed out");
+  check(bot.messages[0].update_id == 6, "update 5 is not handed out again");
+  check(bot.unacked() == 2, "both are outstanding");
+
+  // Nothing new behind them: not polled again until an ack
+  check(bot.getUpdates(7) == 0, "poll with nothing new");
+  unsigned long before = client.requests;
+  for (int i = 0; i < 5; i++) bot.getUpdates(7);
+  check(client.requests == before, "no polls while only outstanding updates come back");
+
+  check(bot.ack(6), "ack of an outstanding update");
+  check(!bot.ack(6), "second ack of the same update");
+  check(bot.unacked() == 2, "6 waits for 5 to be acknowledged");
+  check(bot.ack(5), "ack of update 5");
+  check(bot.unacked() == 0, "nothing outstanding after both acks");
+
+  client.clearScript();
+  client.respond("/getUpdates?offset=7&", updates(""));
+  bot.getUpdates(7);
+  check(client.lastRequest().find("offset=7&") != std::string::npos, "poll confirms acked updates");
+}
+
+static void oversizedBehindOutstanding() {
+  ScriptedClient client;
+  UniversalTelegramBot bot("123456:TOKEN", client);
+  bot.setManualAck(true);
+
+  client.respond("/getUpdates?offset=1&", updates(update(5, "/led on")));
+  check(bot.getUpdates(1) == 1, "first poll hands out update 5");
+
+  // Update 6 is too long to read, and the answer starts with the
+  // outstanding update 5
+  std::string huge(2 * bot.maxMessageLength, 'x');
+  client.clearScript();
+  client.respond("/getUpdates?offset=1&", updates(update(5, "/led on") + "," + update(6, huge)));
+  unsigned long before = client.requests;
+  for (int i = 0; i < 5; i++) check(bot.getUpdates(6) == 0, "nothing handed out while 5 is unacked");
+  check(client.requests - before == 1, "the too long answer is fetched once, not every poll");
+  check(bot.unacked() == 1, "update 5 is still outstanding");
+
+  // Once 5 is acknowledged, 6 leads the answer and is skipped
+  check(bot.ack(5), "ack of update 5");
+  client.clearScript();
+  client.respond("/getUpdates?offset=6&", updates(update(6, huge)));
+  client.respond("/getUpdates?offset=7&", updates(""));
+  bot.getUpdates(6);
+  check(bot.last_message_received == 6, "update 6 is skipped");
+  check(bot.unacked() == 0, "a skipped update needs no ack");
+  check(client.lastRequest().find("offset=7&") != std::string::npos, "polling goes on after 6");
+}
+
+int main() {
+  outstandingUpdates();
+  oversizedBehindOutstanding();
+
+  printf("%lu failures\n", failures);
+  return failures ? 1 : 0;
+}
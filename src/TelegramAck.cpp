@@ -0,0 +1,57 @@
+/*
+Copyright (c) 2018 Brian Lough. All right reserved.
+
+UniversalTelegramBot - Library to create your own Telegram Bot using
+ESP8266 or ESP32 on Arduino IDE.
+
+This library is free software; you can redistribute it and/or
+modify it under the terms of the GNU Lesser General Public
+License as published by the Free Software Foundation; either
+version 2.1 of the License, or (at your option) any later version.
+
+This library is distributed in the hope that it will be useful,
+but WITHOUT ANY WARRANTY; without even the implied warranty of
+MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the GNU
+Lesser General Public License for more details.
+
+You should have received a copy of the GNU Lesser General Public
+License along with this library; if not, write to the Free Software
+Foundation, Inc., 51 Franklin St, Fifth Floor, Boston, MA 02110-1301 USA
+*/
+
+#include "TelegramAck.h"
+
+void TelegramAckWindow::reset(long confirmed) {
+  _confirmed = confirmed;
+  _head = 0;
+  _count = 0;
+}
+
+bool TelegramAckWindow::push(long updateId) {
+  if (_count >= TELEGRAM_MAX_UNACKED) return false;
+  int slot = (_head + _count) % TELEGRAM_MAX_UNACKED;
+  _ids[slot] = updateId;
+  _acked[slot] = false;
+  _count++;
+  return true;
+}
+
+bool TelegramAckWindow::ack(long updateId) {
+  bool found = false;
+  for (int i = 0; i < _count && !found; i++) {
+    int slot = (_head + i) % TELEGRAM_MAX_UNACKED;
+    if (_ids[slot] == updateId && !_acked[slot]) {
+      _acked[slot] = true;
+      found = true;
+    }
+  }
+
+  // The acknowledged updates at the front are confirmed, the first one
+  // still open holds back those after it
+  while (_count > 0 && _acked[_head]) {
+    _confirmed = _ids[_head];
+    _head = (_head + 1) % TELEGRAM_MAX_UNACKED;
+    _count--;
+  }
+  return found;
+}
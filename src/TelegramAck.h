@@ -0,0 +1,90 @@
+/*
+Copyright (c) 2018 Brian Lough. All right reserved.
+
+UniversalTelegramBot - Library to create your own Telegram Bot using
+ESP8266 or ESP32 on Arduino IDE.
+
+This library is free software; you can redistribute it and/or
+modify it under the terms of the GNU Lesser General Public
+License as published by the Free Software Foundation; either
+version 2.1 of the License, or (at your option) any later version.
+
+This library is distributed in the hope that it will be useful,
+but WITHOUT ANY WARRANTY; without even the implied warranty of
+MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the GNU
+Lesser General Public License for more details.
+
+You should have received a copy of the GNU Lesser General Public
+License along with this library; if not, write to the Free Software
+Foundation, Inc., 51 Franklin St, Fifth Floor, Boston, MA 02110-1301 USA
+*/
+
+#ifndef TelegramAck_h
+#define TelegramAck_h
+
+#include <Arduino.h>
+
+// Updates handed out and not yet confirmed to Telegram. A poll fetches
+// these again (and skips them), so the response must have room for them.
+#ifndef TELEGRAM_MAX_UNACKED
+#define TELEGRAM_MAX_UNACKED 8
+#endif
+
+/*
+   At-least-once processing. Normally the next getUpdates confirms every
+   update it is past, finished or not, so an update whose handler crashes
+   or is still running is gone. With bot.setManualAck(true) an update
+   counts as handled only once the sketch says so:
+
+     bot.setManualAck(true);
+     ...
+     int n = bot.getUpdates(bot.last_message_received + 1);
+     for (int i = 0; i < n; i++) {
+       startJob(bot.messages[i]);   // may finish later, in any order
+     }
+     ...
+     void jobDone(long update_id) { bot.ack(update_id); }
+
+   A poll then confirms only up to the highest update acknowledged along
+   with everything before it, whatever offset it is given, so existing
+   loops need no change. Updates that are handed out but not acknowledged
+   are not handed out again; after a crash or reboot Telegram sends them
+   again, and with an offset store (TelegramOffsetStore.h) the saved offset
+   is the acknowledged one as well.
+
+   At most TELEGRAM_MAX_UNACKED updates are outstanding. With that many the
+   bot stops asking for new ones until some are acknowledged. It also stops
+   after a poll that brought back nothing but outstanding updates, or an
+   answer too long for maxMessageLength that starts with them, until an ack
+   confirms more. An offset below them is answered at once, so polling
+   again would only spin. Copy what a
+   handler needs from messages[], the next poll overwrites it. ack() may be
+   called from any task with TELEGRAM_THREAD_SAFE.
+ */
+class TelegramAckWindow {
+public:
+  TelegramAckWindow() { reset(0); }
+
+  // Starts over with every update up to confirmed handled
+  void reset(long confirmed);
+
+  // Every update up to this one is acknowledged
+  long confirmed() const { return _confirmed; }
+  // Handed out since confirmed(), acknowledged or not
+  int size() const { return _count; }
+  int free() const { return TELEGRAM_MAX_UNACKED - _count; }
+
+  // Notes an update as handed out; false when the window is full
+  bool push(long updateId);
+  // Notes an update as acknowledged; false if it is not outstanding
+  bool ack(long updateId);
+
+private:
+  long _confirmed;
+  long _ids[TELEGRAM_MAX_UNACKED];
+  bool _acked[TELEGRAM_MAX_UNACKED];
+  int _head;
+  int _count;
+};
+
+#endif
@@ -0,0 +1,120 @@
+/*
+Copyright (c) 2018 Brian Lough. All right reserved.
+
+UniversalTelegramBot - Library to create your own Telegram Bot using
+ESP8266 or ESP32 on Arduino IDE.
+
+This library is free software; you can redistribute it and/or
+modify it under the terms of the GNU Lesser General Public
+License as published by the Free Software Foundation; either
+version 2.1 of the License, or (at your option) any later version.
+
+This library is distributed in the hope that it will be useful,
+but WITHOUT ANY WARRANTY; without even the implied warranty of
+MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the GNU
+Lesser General Public License for more details.
+
+You should have received a copy of the GNU Lesser General Public
+License along with this library; if not, write to the Free Software
+Foundation, Inc., 51 Franklin St, Fifth Floor, Boston, MA 02110-1301 USA
+*/
+
+
+#ifndef TelegramAsync_h
+#define TelegramAsync_h
+
+#include <Arduino.h>
+#include <TelegramCall.h>
+#include <TelegramHttpResponse.h>
+#include <TelegramStats.h>
+
+// Asynchronous calls a bot can have queued or in flight at once. Each one
+// holds its request and, until its callback ran, the answer.
+#ifndef TELEGRAM_MAX_ASYNC
+#define TELEGRAM_MAX_ASYNC 4
+#endif
+
+/*
+   Asynchronous calls. The *Async methods only queue the request and return
+   a handle; bot.tick(), called from loop(), does the I/O a little at a time
+   and calls onDone with the parsed result once the answer is in:
+
+     void sent(TelegramAsyncHandle handle, const TelegramResult &result, const String &body) {
+       if (!result.ok) Serial.println(result.errorCode);
+     }
+     ...
+     bot.sendPhotoByBinaryAsync(chat_id, "image/jpeg", size, more, nullptr, nextBuffer, nextBufferLen, sent);
+     ...
+     void loop() {
+       bot.tick();
+       // answer callback queries while the upload is still going
+     }
+
+   A tick writes a queued request out, streams one buffer of an upload
+   (512 bytes when the data comes byte by byte) or reads what has arrived of
+   an answer, without waiting for the server. Connecting, TLS handshake
+   included, still blocks, so keep-alive connections from the pool (see
+   TelegramClientPool.h) make ticks short. Requests start oldest first as
+   connections free up; with a single client they queue behind each other
+   and behind getUpdates. A blocking call that needs a connection an async
+   request is using finishes that request first; its callback still runs
+   from the next tick(), which is the only place callbacks are called.
+
+   getUpdatesAsync(offset) polls the same way; hand the body it returns to
+   bot.parseUpdates(body, offset) to fill messages[]. A long poll holds its
+   connection until the server answers, so give outbound calls a client of
+   their own with addClient().
+
+   sendMessageAsync retries for up to 8 s like sendMessage does; the others
+   make a single attempt. A call that fails reaches onDone with result.ok
+   false (errorCode 0 when there was no answer at all).
+ */
+
+// 0 when a call could not be queued
+typedef uint16_t TelegramAsyncHandle;
+
+typedef void (*TelegramAsyncDone)(TelegramAsyncHandle handle, const TelegramResult &result,
+                                  const String &body);
+
+struct TelegramAsyncRequest {
+  TelegramAsyncRequest() : out(bytesOut) {}
+
+  enum State : uint8_t {
+    IDLE,
+    QUEUED,     // waiting for a connection
+    UPLOADING,  // request head written, streaming the upload
+    READING,    // request written, waiting for the answer
+    DONE        // answered, waiting for tick() to call onDone
+  };
+
+  State state = IDLE;
+  TelegramAsyncHandle handle = 0;
+  int method = 0;
+  bool retry = false;
+  TelegramAsyncDone onDone = nullptr;
+
+  String command;    // as built by buildCommand, with the query for a GET
+  String payload;    // JSON body of a POST, or the part in front of an upload
+  String tail;       // closing boundary of an upload
+
+  // Upload source, see sendMultipartFormDataToTelegram
+  int fileSize = 0;
+  bool (*moreDataAvailable)() = nullptr;
+  byte (*getNextByte)() = nullptr;
+  byte *(*getNextBuffer)() = nullptr;
+  int (*getNextBufferLen)() = nullptr;
+
+  int slot = -1;               // in bot.pool while in flight
+  unsigned long started = 0;   // first attempt, for the retry budget
+  unsigned long sentAt = 0;    // request written, for waitForResponse
+  unsigned long received = 0;
+  TelegramHttpResponse response;
+  String body;
+  TelegramResult result;
+  unsigned long long bytesOut = 0;  // added to bot.stats when done
+  TelegramCountingPrint out;
+
+  bool inFlight() const { return state == UPLOADING || state == READING; }
+};
+
+#endif
@@ -0,0 +1,120 @@
+/*
+Copyright (c) 2018 Brian Lough. All right reserved.
+
+UniversalTelegramBot - Library to create your own Telegram Bot using
+ESP8266 or ESP32 on Arduino IDE.
+
+This library is free software; you can redistribute it and/or
+modify it under the terms of the GNU Lesser General Public
+License as published by the Free Software Foundation; either
+version 2.1 of the License, or (at your option) any later version.
+
+This library is distributed in the hope that it will be useful,
+but WITHOUT ANY WARRANTY; without even the implied warranty of
+MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the GNU
+Lesser General Public License for more details.
+
+You should have received a copy of the GNU Lesser General Public
+License along with this library; if not, write to the Free Software
+Foundation, Inc., 51 Franklin St, Fifth Floor, Boston, MA 02110-1301 USA
+*/
+
+#include "TelegramBotGroup.h"
+
+TelegramBotGroup::TelegramBotGroup(UniversalTelegramBot &bot)
+    : bot(bot), _size(1), _current(0) {
+  _members[0].token = bot.getToken();
+  park(_members[0]);
+  // Polls for the next token follow at once, so the connection they share
+  // is worth keeping
+  bot.pool.keepPollOpen = true;
+}
+
+int TelegramBotGroup::add(const String &token) {
+  if (_size >= TELEGRAM_MAX_BOTS) return -1;
+  Member &member = _members[_size];
+  member.token = token;
+  member.lastMessageReceived = 0;
+  member.seen.reset();
+  member.name = "";
+  member.userName = "";
+  member.acks.reset(0);
+  member.refetchedAt = -1;
+  member.manualAck = false;
+  member.offsetStore = nullptr;
+  member.ackedOffset = member.savedOffset = 0;
+  return _size++;
+}
+
+void TelegramBotGroup::use(int index) {
+  if (index < 0 || index >= _size || index == _current) return;
+  park(_members[_current]);
+  _current = index;
+  bot.updateToken(_members[index].token);
+  restore(_members[index]);
+}
+
+bool TelegramBotGroup::ack(int index, long update_id) {
+  if (index < 0 || index >= _size) return false;
+  TELEGRAM_LOCK_SCOPE(bot._ackLock);
+  return index == _current ? bot._acks.ack(update_id) : _members[index].acks.ack(update_id);
+}
+
+/***************************************************************
+ * Park - keeps what the bot holds for the current token in    *
+ * its member while another token is in use                    *
+ ***************************************************************/
+void TelegramBotGroup::park(Member &member) {
+  member.lastMessageReceived = bot.last_message_received;
+  member.seen = bot._seen;
+  member.name = bot.name;
+  member.userName = bot.userName;
+  {
+    TELEGRAM_LOCK_SCOPE(bot._ackLock);
+    member.acks = bot._acks;
+    member.refetchedAt = bot._refetchedAt;
+    member.manualAck = bot._manualAck;
+  }
+  member.offsetStore = bot._offsetStore;
+  member.saveEveryUpdates = bot._saveEveryUpdates;
+  member.saveEveryMs = bot._saveEveryMs;
+  member.ackedOffset = bot._ackedOffset;
+  member.savedOffset = bot._savedOffset;
+  member.savedAt = bot._savedAt;
+}
+
+/***************************************************************
+ * Restore - hands the bot a token's state back. An ack window *
+ * parked before setManualAck() changed is started over, as    *
+ * setManualAck() does for the current token.                  *
+ ***************************************************************/
+void TelegramBotGroup::restore(const Member &member) {
+  bot.last_message_received = member.lastMessageReceived;
+  bot._seen = member.seen;
+  bot.name = member.name;
+  bot.userName = member.userName;
+  {
+    TELEGRAM_LOCK_SCOPE(bot._ackLock);
+    if (member.manualAck == bot._manualAck) {
+      bot._acks = member.acks;
+      bot._refetchedAt = member.refetchedAt;
+    } else {
+      bot._acks.reset(member.lastMessageReceived);
+      bot._refetchedAt = -1;
+    }
+  }
+  bot._offsetStore = member.offsetStore;
+  bot._saveEveryUpdates = member.saveEveryUpdates;
+  bot._saveEveryMs = member.saveEveryMs;
+  bot._ackedOffset = member.ackedOffset;
+  bot._savedOffset = member.savedOffset;
+  bot._savedAt = member.savedAt;
+}
+
+/***************************************************************
+ * GetUpdates - polls the tokens in turn, one per call         *
+ ***************************************************************/
+int TelegramBotGroup::getUpdates() {
+  use((_current + 1) % _size);
+  return bot.getUpdates(bot.last_message_received + 1);
+}
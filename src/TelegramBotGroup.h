@@ -0,0 +1,114 @@
+/*
+Copyright (c) 2018 Brian Lough. All right reserved.
+
+UniversalTelegramBot - Library to create your own Telegram Bot using
+ESP8266 or ESP32 on Arduino IDE.
+
+This library is free software; you can redistribute it and/or
+modify it under the terms of the GNU Lesser General Public
+License as published by the Free Software Foundation; either
+version 2.1 of the License, or (at your option) any later version.
+
+This library is distributed in the hope that it will be useful,
+but WITHOUT ANY WARRANTY; without even the implied warranty of
+MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the GNU
+Lesser General Public License for more details.
+
+You should have received a copy of the GNU Lesser General Public
+License along with this library; if not, write to the Free Software
+Foundation, Inc., 51 Franklin St, Fifth Floor, Boston, MA 02110-1301 USA
+*/
+
+#ifndef TelegramBotGroup_h
+#define TelegramBotGroup_h
+
+#include <UniversalTelegramBot.h>
+
+// Most tokens one group serves
+#ifndef TELEGRAM_MAX_BOTS
+#define TELEGRAM_MAX_BOTS 3
+#endif
+
+/*
+   Several bot tokens served by one UniversalTelegramBot, for a device that
+   runs e.g. an admin, an alerts and a public bot but can afford only one
+   TLS session. Requests for different tokens differ only in the
+   /bot<token>/ part of the path, so they all go over the same kept-alive
+   connection, and the response buffer, the parse and messages[] are shared
+   as well instead of paid for per bot.
+
+     UniversalTelegramBot bot(ADMIN_TOKEN, client);
+     TelegramBotGroup bots(bot);            // the bot's own token is 0
+     int alerts = bots.add(ALERTS_TOKEN);
+
+     void loop() {
+       int n = bots.getUpdates();           // the next token in turn
+       for (int i = 0; i < n; i++) {
+         if (bots.current() == alerts) ...  // whose messages these are
+         bot.sendMessage(bot.messages[i].chat_id, "ok");  // sent as that bot
+       }
+       bots.use(alerts);                    // switch for calls of your own
+       bot.sendMessage(ALERT_CHAT, "door open");
+     }
+
+   Each token keeps its own last_message_received and duplicate filter
+   (TelegramDedup.h), as its update ids are a sequence of their own, and its
+   own name and userName, so "/cmd@OtherBot" is only dispatched by the bot it
+   names. Call getMe() after use() once per added token to fill them in.
+   Manual acks and offset stores are per token too: acknowledge with
+   bots.ack(index, update_id), which reaches tokens not in use, and give
+   each token a store of its own with use() then bot.setOffsetStore().
+   Calls go out as the current token until getUpdates() or use() switches;
+   asynchronous calls keep the token they were queued with. A long poll
+   holds up the other tokens for its length, so keep bot.longPoll short (a
+   few seconds) or 0.
+
+   With TELEGRAM_THREAD_SAFE only the task that polls may switch tokens.
+ */
+class TelegramBotGroup {
+public:
+  explicit TelegramBotGroup(UniversalTelegramBot &bot);
+
+  // Adds a token, returns its index or -1 when TELEGRAM_MAX_BOTS are in use
+  int add(const String &token);
+  int size() const { return _size; }
+
+  // Switches to the next token and polls it; the new messages are in
+  // bot.messages and current() says whose they are
+  int getUpdates();
+  // Switches the bot to a token for the calls that follow
+  void use(int index);
+  int current() const { return _current; }
+  // Acknowledges an update of any token, see TelegramAck.h; bot.ack()
+  // only reaches the current one
+  bool ack(int index, long update_id);
+
+  UniversalTelegramBot &bot;
+
+private:
+  struct Member {
+    String token;
+    long lastMessageReceived;
+    TelegramUpdateFilter seen;
+    String name;
+    String userName;
+    TelegramAckWindow acks;
+    long refetchedAt;
+    bool manualAck;             // whether acks was kept with manual acks on
+    TelegramOffsetStore *offsetStore;
+    int saveEveryUpdates;
+    unsigned long saveEveryMs;
+    long ackedOffset;
+    long savedOffset;
+    unsigned long savedAt;
+  };
+
+  void park(Member &member);
+  void restore(const Member &member);
+
+  Member _members[TELEGRAM_MAX_BOTS];
+  int _size;
+  int _current;
+};
+
+#endif
@@ -0,0 +1,60 @@
+/*
+Copyright (c) 2018 Brian Lough. All right reserved.
+
+UniversalTelegramBot - Library to create your own Telegram Bot using
+ESP8266 or ESP32 on Arduino IDE.
+
+This library is free software; you can redistribute it and/or
+modify it under the terms of the GNU Lesser General Public
+License as published by the Free Software Foundation; either
+version 2.1 of the License, or (at your option) any later version.
+
+This library is distributed in the hope that it will be useful,
+but WITHOUT ANY WARRANTY; without even the implied warranty of
+MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the GNU
+Lesser General Public License for more details.
+
+You should have received a copy of the GNU Lesser General Public
+License along with this library; if not, write to the Free Software
+Foundation, Inc., 51 Franklin St, Fifth Floor, Boston, MA 02110-1301 USA
+*/
+
+
+#ifndef TelegramCall_h
+#define TelegramCall_h
+
+#include <Arduino.h>
+#include <Client.h>
+#include <TelegramStats.h>
+
+// Outcome of a public call as the server reported it, see bot.lastResult()
+struct TelegramResult {
+  bool ok = false;
+  int errorCode = 0;   // Bot API error_code, e.g. 429, 0 when ok
+  int messageId = 0;   // message_id of a sent or edited message, else 0
+};
+
+/*
+   State of one call in progress: the connection it runs on, the request
+   being written and what came back. A bot without TELEGRAM_THREAD_SAFE has
+   a single one; with it every public call has its own, see TelegramLock.h.
+ */
+struct TelegramCall {
+  TelegramCall(unsigned long long &bytesOut) : out(bytesOut) {}
+  // Counting into its own bytesOut
+  TelegramCall() : out(bytesOut) {}
+
+  int slot = 0;                 // in bot.pool, -1 before the first request
+  Client *client = nullptr;
+  unsigned long long bytesOut = 0; // counted by out when it has no counter of its own
+  TelegramCountingPrint out;    // all request bytes go through here
+  bool responseComplete = false;
+  uint32_t heapAtStart = 0;
+  TelegramResult result;
+
+  // Bookkeeping of the calls running on a thread
+  const void *owner = nullptr;
+  TelegramCall *outer = nullptr;
+};
+
+#endif
@@ -0,0 +1,108 @@
+/*
+Copyright (c) 2018 Brian Lough. All right reserved.
+
+UniversalTelegramBot - Library to create your own Telegram Bot using
+ESP8266 or ESP32 on Arduino IDE.
+
+This library is free software; you can redistribute it and/or
+modify it under the terms of the GNU Lesser General Public
+License as published by the Free Software Foundation; either
+version 2.1 of the License, or (at your option) any later version.
+
+This library is distributed in the hope that it will be useful,
+but WITHOUT ANY WARRANTY; without even the implied warranty of
+MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the GNU
+Lesser General Public License for more details.
+
+You should have received a copy of the GNU Lesser General Public
+License along with this library; if not, write to the Free Software
+Foundation, Inc., 51 Franklin St, Fifth Floor, Boston, MA 02110-1301 USA
+*/
+
+
+#include "TelegramClientPool.h"
+#include "TelegramMethod.h"
+
+TelegramClientPool::TelegramClientPool() : keepAlive(true), keepPollOpen(false), _size(0), _uses(0) {
+}
+
+int TelegramClientPool::add(Client *client) {
+  TELEGRAM_LOCK_SCOPE(_lock);
+  if (_size >= TELEGRAM_MAX_CLIENTS) return -1;
+
+  Slot &slot = _slots[_size];
+  slot.client = client;
+  slot.busy = false;
+  slot.wasConnected = false;
+  slot.closedOnPurpose = false;
+  slot.lastUsed = 0;
+  return _size++;
+}
+
+int TelegramClientPool::acquire(int method) {
+  TELEGRAM_LOCK_SCOPE(_lock);
+  int chosen = -1;
+
+  if (_size <= 1 || method == TELEGRAM_GET_UPDATES) {
+    // Polling always has slot 0 to itself; with one client so does everything
+    if (_size > 0 && !_slots[0].busy) chosen = 0;
+  } else {
+    bool chosenConnected = false;
+    for (int i = 1; i < _size; i++) {
+      Slot &slot = _slots[i];
+      if (slot.busy) continue;
+      bool connected = slot.client->connected();
+      // A live session beats a reconnect, then least recently used first
+      if (chosen < 0 || (connected && !chosenConnected) ||
+          (connected == chosenConnected && slot.lastUsed < _slots[chosen].lastUsed)) {
+        chosen = i;
+        chosenConnected = connected;
+      }
+    }
+  }
+
+  if (chosen >= 0) {
+    _slots[chosen].busy = true;
+    _slots[chosen].lastUsed = ++_uses;
+  }
+  return chosen;
+}
+
+bool TelegramClientPool::available(int method) {
+  TELEGRAM_LOCK_SCOPE(_lock);
+  if (_size <= 1 || method == TELEGRAM_GET_UPDATES) return _size > 0 && !_slots[0].busy;
+  for (int i = 1; i < _size; i++) {
+    if (!_slots[i].busy) return true;
+  }
+  return false;
+}
+
+void TelegramClientPool::release(int slot) {
+  TELEGRAM_LOCKED(_lock, if (slot >= 0 && slot < _size) _slots[slot].busy = false);
+}
+
+bool TelegramClientPool::connected(int slot) {
+  TELEGRAM_LOCK_SCOPE(_lock);
+  Slot &s = _slots[slot];
+  bool reconnect = s.wasConnected && !s.closedOnPurpose;
+  s.wasConnected = true;
+  s.closedOnPurpose = false;
+  return reconnect;
+}
+
+void TelegramClientPool::closedOnPurpose(int slot) {
+  TELEGRAM_LOCKED(_lock, _slots[slot].closedOnPurpose = true);
+}
+
+void TelegramClientPool::stopAll() {
+  TELEGRAM_LOCK_SCOPE(_lock);
+  for (int i = 0; i < _size; i++) {
+#ifdef TELEGRAM_THREAD_SAFE
+    if (_slots[i].busy) continue; // another task's call is running on it
+#endif
+    if (_slots[i].client->connected()) {
+      _slots[i].closedOnPurpose = true;
+      _slots[i].client->stop();
+    }
+  }
+}
@@ -0,0 +1,105 @@
+/*
+Copyright (c) 2018 Brian Lough. All right reserved.
+
+UniversalTelegramBot - Library to create your own Telegram Bot using
+ESP8266 or ESP32 on Arduino IDE.
+
+This library is free software; you can redistribute it and/or
+modify it under the terms of the GNU Lesser General Public
+License as published by the Free Software Foundation; either
+version 2.1 of the License, or (at your option) any later version.
+
+This library is distributed in the hope that it will be useful,
+but WITHOUT ANY WARRANTY; without even the implied warranty of
+MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the GNU
+Lesser General Public License for more details.
+
+You should have received a copy of the GNU Lesser General Public
+License along with this library; if not, write to the Free Software
+Foundation, Inc., 51 Franklin St, Fifth Floor, Boston, MA 02110-1301 USA
+*/
+
+
+#ifndef TelegramClientPool_h
+#define TelegramClientPool_h
+
+#include <Arduino.h>
+#include <Client.h>
+#include <TelegramLock.h>
+
+// Most connections one bot can spread its calls over. Each TLS session
+// costs roughly 40KB on ESP32, so more than a handful rarely fits.
+#ifndef TELEGRAM_MAX_CLIENTS
+#define TELEGRAM_MAX_CLIENTS 4
+#endif
+
+/*
+   The connections of a bot. Slot 0 is the client passed to the
+   constructor; more are added with bot.addClient():
+
+     WiFiClientSecure pollClient, sendClient;
+     UniversalTelegramBot bot(BOT_TOKEN, pollClient);
+     bot.addClient(sendClient);
+
+   With a single client everything shares it, as before. With more, slot 0
+   is kept for getUpdates, so a long poll neither delays nor tears down the
+   connection replies go out on, and every other call (sendMessage,
+   answerCallbackQuery, deleteMessage, getFile, ...) leases one of the other
+   slots. A lease goes to an idle slot that is still connected if there is
+   one, so kept-alive sessions are reused, and among equals to the one used
+   longest ago, so calls in flight at the same time spread over the
+   connections in turn. Outbound slots stay connected after a call
+   (keepAlive) to save the TLS handshake on the next one, unless the call
+   ended without a complete response. Slot 0 is closed after each poll
+   unless keepPollOpen is set as well.
+ */
+class TelegramClientPool {
+public:
+  TelegramClientPool();
+
+  // Adds a connection, returns its slot or -1 when the pool is full
+  int add(Client *client);
+  int size() const { return _size; }
+  Client *client(int slot) const { return _slots[slot].client; }
+
+  // Slot to run a call of the given method on, marked busy until release().
+  // -1 when every slot that could take it is busy.
+  int acquire(int method);
+  void release(int slot);
+  bool busy(int slot) const { return _slots[slot].busy; }
+  // Whether acquire(method) would find a slot now
+  bool available(int method);
+
+  // Whether a connection is left open after the call that used it
+  bool keepOpen(int slot) const { return keepAlive && (slot > 0 || keepPollOpen); }
+
+  // Remembers a connect on a slot; true when it replaces a connection the
+  // server dropped rather than one closed on purpose
+  bool connected(int slot);
+  void closedOnPurpose(int slot);
+
+  // Closes every open connection that no call is using, e.g. after the
+  // server changed
+  void stopAll();
+
+  bool keepAlive;     // leave outbound connections open between calls
+  bool keepPollOpen;  // and slot 0 as well, for a caller that polls again at once
+
+private:
+  struct Slot {
+    Client *client;
+    bool busy;
+    bool wasConnected;
+    bool closedOnPurpose;
+    uint32_t lastUsed;
+  };
+
+  Slot _slots[TELEGRAM_MAX_CLIENTS];
+  int _size;
+  uint32_t _uses;
+#ifdef TELEGRAM_THREAD_SAFE
+  TelegramMutex _lock;
+#endif
+};
+
+#endif
@@ -0,0 +1,182 @@
+/*
+Copyright (c) 2018 Brian Lough. All right reserved.
+
+UniversalTelegramBot - Library to create your own Telegram Bot using
+ESP8266 or ESP32 on Arduino IDE.
+
+This library is free software; you can redistribute it and/or
+modify it under the terms of the GNU Lesser General Public
+License as published by the Free Software Foundation; either
+version 2.1 of the License, or (at your option) any later version.
+
+This library is distributed in the hope that it will be useful,
+but WITHOUT ANY WARRANTY; without even the implied warranty of
+MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the GNU
+Lesser General Public License for more details.
+
+You should have received a copy of the GNU Lesser General Public
+License along with this library; if not, write to the Free Software
+Foundation, Inc., 51 Franklin St, Fifth Floor, Boston, MA 02110-1301 USA
+*/
+
+#include "TelegramCommands.h"
+
+#include <ctype.h>
+#include <string.h>
+
+#define TELEGRAM_COMMAND_SLOTS (TELEGRAM_MAX_COMMANDS * 4)
+#define TELEGRAM_COMMAND_EMPTY 0xFF
+// Seeds tried for a perfect hash; with a table four times the commands
+// a handful usually do
+#define TELEGRAM_COMMAND_SEEDS 4096
+
+static bool isBlank(char c) {
+  return isspace((unsigned char)c);
+}
+
+void TelegramCommandArgs::split(char *text) {
+  _count = 0;
+  _cuts = 0;
+
+  // The last argument keeps the rest of the text, less trailing blanks
+  char *end = text + strlen(text);
+  while (end > text && isBlank(end[-1])) end--;
+
+  char *p = text;
+  while (p < end && _count < TELEGRAM_MAX_COMMAND_ARGS) {
+    while (p < end && isBlank(*p)) p++;
+    if (p == end) break;
+    _args[_count++] = p;
+    if (_count == TELEGRAM_MAX_COMMAND_ARGS) {
+      p = end;
+      break;
+    }
+    while (p < end && !isBlank(*p)) p++;
+    if (p < end) {
+      _cut[_cuts] = p;
+      _was[_cuts++] = *p;
+      *p++ = '\0';
+    }
+  }
+  if (*end) {
+    _cut[_cuts] = end;
+    _was[_cuts++] = *end;
+    *end = '\0';
+  }
+}
+
+void TelegramCommandArgs::restore() {
+  while (_cuts > 0) {
+    _cuts--;
+    *_cut[_cuts] = _was[_cuts];
+  }
+}
+
+void TelegramCommandArgs::release() {
+  restore();
+  _count = 0;
+}
+
+TelegramCommandRouter::TelegramCommandRouter() : _size(0), _seed(-1) {
+  memset(_table, TELEGRAM_COMMAND_EMPTY, sizeof(_table));
+}
+
+uint32_t TelegramCommandRouter::hash(const char *name, size_t length, uint32_t seed) {
+  // FNV-1a, started from a seeded basis
+  uint32_t h = 2166136261u ^ (seed * 0x9E3779B9u);
+  for (size_t i = 0; i < length; i++) {
+    h ^= (uint8_t)name[i];
+    h *= 16777619u;
+  }
+  return h ^ (h >> 15);
+}
+
+bool TelegramCommandRouter::add(const char *command, TelegramCommandHandler handler) {
+  if (!command || !handler) return false;
+  if (*command == '/') command++;
+  size_t length = strlen(command);
+  if (length == 0 || length > 255) return false;
+
+  int i = find(command, length);
+  if (i >= 0) {
+    _commands[i].handler = handler;
+    return true;
+  }
+  if (_size >= TELEGRAM_MAX_COMMANDS) return false;
+
+  Command &added = _commands[_size++];
+  added.name = command;
+  added.length = length;
+  added.handler = handler;
+  rebuild();
+  return true;
+}
+
+/***************************************************************
+ * Rebuild - looks for a seed that gives every command a slot  *
+ * of its own                                                  *
+ ***************************************************************/
+void TelegramCommandRouter::rebuild() {
+  for (uint32_t seed = 0; seed < TELEGRAM_COMMAND_SEEDS; seed++) {
+    memset(_table, TELEGRAM_COMMAND_EMPTY, sizeof(_table));
+    int i = 0;
+    for (; i < _size; i++) {
+      uint32_t slot = hash(_commands[i].name, _commands[i].length, seed) % TELEGRAM_COMMAND_SLOTS;
+      if (_table[slot] != TELEGRAM_COMMAND_EMPTY) break;
+      _table[slot] = i;
+    }
+    if (i == _size) {
+      _seed = seed;
+      return;
+    }
+  }
+  _seed = -1;
+}
+
+int TelegramCommandRouter::find(const char *name, size_t length) const {
+  if (_seed < 0) {
+    for (int i = 0; i < _size; i++) {
+      if (_commands[i].length == length && memcmp(_commands[i].name, name, length) == 0) return i;
+    }
+    return -1;
+  }
+
+  uint8_t i = _table[hash(name, length, _seed) % TELEGRAM_COMMAND_SLOTS];
+  if (i == TELEGRAM_COMMAND_EMPTY) return -1;
+  const Command &command = _commands[i];
+  return command.length == length && memcmp(command.name, name, length) == 0 ? i : -1;
+}
+
+static bool sameBotName(const char *name, size_t length, const char *botName) {
+  if (strlen(botName) != length) return false;
+  for (size_t i = 0; i < length; i++) {
+    if (tolower((unsigned char)name[i]) != tolower((unsigned char)botName[i])) return false;
+  }
+  return true;
+}
+
+/***************************************************************
+ * Route - finds the handler for the command text starts with  *
+ * and splits the arguments after it                           *
+ ***************************************************************/
+TelegramCommandHandler TelegramCommandRouter::route(char *text, const char *botName,
+                                                    TelegramCommandArgs &args) {
+  if (!text || text[0] != '/') return nullptr;
+
+  const char *name = text + 1;
+  char *p = text + 1;
+  while (*p && *p != '@' && !isBlank(*p)) p++;
+  size_t length = p - name;
+
+  if (*p == '@') {
+    const char *to = ++p;
+    while (*p && !isBlank(*p)) p++;
+    // Meant for another bot in the same group
+    if (botName && *botName && !sameBotName(to, p - to, botName)) return nullptr;
+  }
+
+  int i = find(name, length);
+  if (i < 0) return nullptr;
+  args.split(p);
+  return _commands[i].handler;
+}
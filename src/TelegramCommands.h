@@ -0,0 +1,135 @@
+/*
+Copyright (c) 2018 Brian Lough. All right reserved.
+
+UniversalTelegramBot - Library to create your own Telegram Bot using
+ESP8266 or ESP32 on Arduino IDE.
+
+This library is free software; you can redistribute it and/or
+modify it under the terms of the GNU Lesser General Public
+License as published by the Free Software Foundation; either
+version 2.1 of the License, or (at your option) any later version.
+
+This library is distributed in the hope that it will be useful,
+but WITHOUT ANY WARRANTY; without even the implied warranty of
+MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the GNU
+Lesser General Public License for more details.
+
+You should have received a copy of the GNU Lesser General Public
+License along with this library; if not, write to the Free Software
+Foundation, Inc., 51 Franklin St, Fifth Floor, Boston, MA 02110-1301 USA
+*/
+
+#ifndef TelegramCommands_h
+#define TelegramCommands_h
+
+#include <Arduino.h>
+
+// Commands one bot can register with bot.on(), at most 254
+#ifndef TELEGRAM_MAX_COMMANDS
+#define TELEGRAM_MAX_COMMANDS 16
+#endif
+
+// Arguments split off a command; the last one keeps the rest of the text
+#ifndef TELEGRAM_MAX_COMMAND_ARGS
+#define TELEGRAM_MAX_COMMAND_ARGS 8
+#endif
+
+class UniversalTelegramBot;
+struct telegramMessage;
+
+/*
+   The arguments of a command, split in place: each is a pointer into
+   message.text with the whitespace after it overwritten by a '\0', put
+   back once the handler returns. Nothing is allocated. "/say hi there"
+   with a single argument allowed gives "hi there".
+
+   A handler that assigns message.text calls args.release() first. That
+   puts the text back at once and ends the arguments, so nothing is
+   written into the new text afterwards.
+ */
+class TelegramCommandArgs {
+public:
+  TelegramCommandArgs() : _count(0), _cuts(0) {}
+
+  int count() const { return _count; }
+  // The i-th argument, "" past the last
+  const char *operator[](int i) const { return i >= 0 && i < _count ? _args[i] : ""; }
+  long toInt(int i) const { return atol((*this)[i]); }
+  // Puts message.text back together now; the arguments are "" after it
+  void release();
+
+private:
+  friend class TelegramCommandRouter;
+  void split(char *text);
+  void restore();
+
+  int _count;
+  const char *_args[TELEGRAM_MAX_COMMAND_ARGS];
+  int _cuts;
+  char *_cut[TELEGRAM_MAX_COMMAND_ARGS];
+  char _was[TELEGRAM_MAX_COMMAND_ARGS];
+};
+
+typedef void (*TelegramCommandHandler)(UniversalTelegramBot &bot, telegramMessage &message,
+                                       TelegramCommandArgs &args);
+
+/*
+   Dispatches commands by name instead of a chain of String comparisons:
+
+     bot.on("/status", onStatus);
+     bot.on("/led", onLed);
+     ...
+     int n = bot.getUpdates(bot.last_message_received + 1);
+     for (int i = 0; i < n; i++) {
+       if (!bot.dispatch(bot.messages[i])) handleOther(bot.messages[i]);
+     }
+
+     void onLed(UniversalTelegramBot &bot, telegramMessage &message,
+                TelegramCommandArgs &args) {
+       digitalWrite(LED, strcmp(args[0], "on") == 0);
+     }
+
+   Every on() rebuilds a perfect hash over the names: it tries seeds
+   until each name lands in a slot of its own in a table of four per
+   command. A dispatch then hashes the command once, looks at one slot and
+   compares one name, however many are registered. Should no seed be found
+   the names are searched in turn instead.
+
+   "/status@MyBot" is routed as "/status" if MyBot is this bot's userName
+   (known after getMe(), compared ignoring case), and not at all if it
+   names another bot in the group. Names are kept by pointer, pass string
+   literals or storage that outlives the bot.
+ */
+class TelegramCommandRouter {
+public:
+  TelegramCommandRouter();
+
+  // Registers or replaces the handler of a command, with or without its
+  // leading '/'; false when TELEGRAM_MAX_COMMANDS are registered already
+  bool add(const char *command, TelegramCommandHandler handler);
+  int size() const { return _size; }
+
+  // The handler for a command in text, nullptr if it is none of them or
+  // is addressed to another bot. On a match args is split out of text,
+  // to be restored with done().
+  TelegramCommandHandler route(char *text, const char *botName, TelegramCommandArgs &args);
+  void done(TelegramCommandArgs &args) { args.restore(); }
+
+private:
+  struct Command {
+    const char *name;    // without the '/'
+    uint8_t length;
+    TelegramCommandHandler handler;
+  };
+
+  static uint32_t hash(const char *name, size_t length, uint32_t seed);
+  void rebuild();
+  int find(const char *name, size_t length) const;
+
+  Command _commands[TELEGRAM_MAX_COMMANDS];
+  int _size;
+  int32_t _seed;       // -1 without a perfect hash
+  uint8_t _table[TELEGRAM_MAX_COMMANDS * 4];
+};
+
+#endif
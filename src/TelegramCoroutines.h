@@ -0,0 +1,308 @@
+/*
+Copyright (c) 2018 Brian Lough. All right reserved.
+
+UniversalTelegramBot - Library to create your own Telegram Bot using
+ESP8266 or ESP32 on Arduino IDE.
+
+This library is free software; you can redistribute it and/or
+modify it under the terms of the GNU Lesser General Public
+License as published by the Free Software Foundation; either
+version 2.1 of the License, or (at your option) any later version.
+
+This library is distributed in the hope that it will be useful,
+but WITHOUT ANY WARRANTY; without even the implied warranty of
+MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the GNU
+Lesser General Public License for more details.
+
+You should have received a copy of the GNU Lesser General Public
+License along with this library; if not, write to the Free Software
+Foundation, Inc., 51 Franklin St, Fifth Floor, Boston, MA 02110-1301 USA
+*/
+
+
+#ifndef TelegramCoroutines_h
+#define TelegramCoroutines_h
+
+#if !defined(__cpp_impl_coroutine) || !__has_include(<coroutine>)
+#error "TelegramCoroutines.h needs C++20 coroutines, build with -std=gnu++20"
+#endif
+
+#include <coroutine>
+#include <exception>
+
+#include <UniversalTelegramBot.h>
+
+/*
+   Coroutine interface over the asynchronous calls (see TelegramAsync.h),
+   for toolchains with C++20: recent ESP32 cores (ESP-IDF 5) and the Linux
+   build. Handlers are written as straight-line code and co_await each
+   call; while one waits for its answer the others run, all on one thread:
+
+     TelegramTask countdown(TelegramCoroutines &co, String chat_id) {
+       for (int i = 3; i > 0; i--) {
+         co_await co.sendMessage(chat_id, String(i));
+         co_await co.sleep(1000);
+       }
+       TelegramReply reply = co_await co.sendMessage(chat_id, "Go");
+       if (!reply.result.ok) Serial.println(reply.result.errorCode);
+     }
+
+     TelegramTask poller(TelegramCoroutines &co) {
+       for (;;) {
+         int n = co_await co.getUpdates();
+         for (int i = 0; i < n; i++) {
+           if (co.bot.messages[i].text == "/countdown") countdown(co, co.bot.messages[i].chat_id);
+         }
+       }
+     }
+
+     TelegramCoroutines co(bot);
+     poller(co);
+     void loop() { co.poll(); }
+
+   A TelegramTask starts when it is called and frees itself when it
+   returns. Tasks are resumed from poll(), which also ticks the bot, so
+   bot.tick() is not called separately. Besides the Bot API calls a task
+   can wait for a time (sleep) or for data on any Client (readable).
+
+   messages[] is refilled by the next getUpdates, so handlers take what
+   they need from it by value before their first co_await. Each call holds
+   one of the bot's TELEGRAM_MAX_ASYNC requests while it runs; calls beyond
+   that wait for one to free up. The TelegramCoroutines must outlive the
+   tasks waiting on it.
+ */
+
+// Coroutine that runs on its own once called
+struct TelegramTask {
+  struct promise_type {
+    TelegramTask get_return_object() { return {}; }
+    std::suspend_never initial_suspend() noexcept { return {}; }
+    std::suspend_never final_suspend() noexcept { return {}; }
+    void return_void() {}
+    void unhandled_exception() { std::terminate(); }
+  };
+};
+
+// What an awaited Bot API call resumes with
+struct TelegramReply {
+  TelegramResult result;
+  String body;
+};
+
+class TelegramCoroutines;
+
+// Base of everything a task can co_await. Suspended awaiters wait in a list
+// of their TelegramCoroutines until ready() says their task can go on.
+class TelegramAwaiter {
+public:
+  TelegramAwaiter(TelegramCoroutines &co) : _co(co) {}
+  TelegramAwaiter(const TelegramAwaiter &) = delete;
+
+  bool await_ready() { return false; }
+  void await_suspend(std::coroutine_handle<> handle);
+
+protected:
+  friend class TelegramCoroutines;
+
+  // Starts the wait; false to be tried again on the next poll()
+  virtual bool start() { return true; }
+  virtual bool ready() = 0;
+  // An asynchronous call finished; true if it was this awaiter's
+  virtual bool finished(TelegramAsyncHandle, const TelegramResult &, const String &) { return false; }
+
+  TelegramCoroutines &_co;
+  std::coroutine_handle<> _handle;
+  TelegramAwaiter *_next = nullptr;
+  unsigned long _round = 0;   // poll() it suspended in
+  bool _started = false;
+};
+
+// Waits for an asynchronous call, queued by queue()
+class TelegramCallAwaiter : public TelegramAwaiter {
+public:
+  TelegramCallAwaiter(TelegramCoroutines &co) : TelegramAwaiter(co) {}
+
+protected:
+  virtual TelegramAsyncHandle queue() = 0;
+
+  bool start() override {
+    _call = queue();
+    return _call != 0;
+  }
+  bool ready() override { return _done; }
+  bool finished(TelegramAsyncHandle call, const TelegramResult &result, const String &body) override {
+    if (!_started || call != _call) return false;
+    _reply.result = result;
+    _reply.body = body;
+    _done = true;
+    return true;
+  }
+
+  TelegramAsyncHandle _call = 0;
+  bool _done = false;
+  TelegramReply _reply;
+};
+
+// A call that resumes with its TelegramReply; queue is a *Async method
+// bound to its arguments
+template <typename Queue>
+class TelegramReplyAwaiter : public TelegramCallAwaiter {
+public:
+  TelegramReplyAwaiter(TelegramCoroutines &co, Queue queue) : TelegramCallAwaiter(co), _queue(queue) {}
+
+  TelegramReply await_resume() { return _reply; }
+
+protected:
+  TelegramAsyncHandle queue() override { return _queue(); }
+
+  Queue _queue;
+};
+
+class TelegramCoroutines {
+public:
+  explicit TelegramCoroutines(UniversalTelegramBot &bot) : bot(bot) {}
+
+  auto sendMessage(const String &chat_id, const String &text, const String &parse_mode = "") {
+    return call([=, this] { return bot.sendMessageAsync(chat_id, text, callDone, parse_mode); });
+  }
+
+  auto answerCallbackQuery(const String &query_id, const String &text = "") {
+    return call([=, this] { return bot.answerCallbackQueryAsync(query_id, text, callDone); });
+  }
+
+  // The payload is copied, so it may go out of scope before the call ends
+  auto sendPost(const String &command, JsonObject payload) {
+    JsonDocument doc;
+    doc.set(payload);
+    return call([=, this]() mutable {
+      return bot.sendPostToTelegramAsync(command, doc.as<JsonObject>(), callDone);
+    });
+  }
+
+  // Resumes with the number of new messages in bot.messages[]
+  class Updates : public TelegramCallAwaiter {
+  public:
+    Updates(TelegramCoroutines &co)
+        : TelegramCallAwaiter(co), _offset(co.bot.last_message_received + 1) {}
+
+    int await_resume() { return _co.bot.parseUpdates(_reply.body, _offset); }
+
+  protected:
+    TelegramAsyncHandle queue() override { return _co.bot.getUpdatesAsync(_offset, callDone); }
+
+    long _offset;
+  };
+  Updates getUpdates() { return Updates(*this); }
+
+  class Sleep : public TelegramAwaiter {
+  public:
+    Sleep(TelegramCoroutines &co, unsigned long ms) : TelegramAwaiter(co), _ms(ms) {}
+    void await_resume() {}
+
+  protected:
+    bool start() override {
+      _since = millis();
+      return true;
+    }
+    bool ready() override { return millis() - _since >= _ms; }
+
+    unsigned long _ms;
+    unsigned long _since = 0;
+  };
+  Sleep sleep(unsigned long ms) { return Sleep(*this, ms); }
+
+  // Resumes with true once client has data to read, false when it closed
+  // or timeoutMs passed first
+  class Readable : public TelegramAwaiter {
+  public:
+    Readable(TelegramCoroutines &co, Client &client, unsigned long timeoutMs)
+        : TelegramAwaiter(co), _client(client), _timeoutMs(timeoutMs) {}
+    bool await_resume() { return _client.available() > 0; }
+
+  protected:
+    bool start() override {
+      _since = millis();
+      return true;
+    }
+    bool ready() override {
+      return _client.available() > 0 || !_client.connected() || millis() - _since >= _timeoutMs;
+    }
+
+    Client &_client;
+    unsigned long _timeoutMs;
+    unsigned long _since = 0;
+  };
+  Readable readable(Client &client, unsigned long timeoutMs) {
+    return Readable(*this, client, timeoutMs);
+  }
+
+  // Ticks the bot and resumes the tasks whose wait is over. Call it from
+  // loop(); a task that is resumed and waits again goes on next time.
+  void poll() {
+    _rounds++;
+    for (TelegramAwaiter *a = _waiting; a; a = a->_next) {
+      if (!a->_started) a->_started = a->start();
+    }
+
+    TelegramCoroutines *outer = _ticking;
+    _ticking = this;
+    bot.tick();
+    _ticking = outer;
+
+    for (;;) {
+      TelegramAwaiter **link = &_waiting;
+      while (*link && ((*link)->_round == _rounds || !(*link)->_started || !(*link)->ready())) {
+        link = &(*link)->_next;
+      }
+      TelegramAwaiter *a = *link;
+      if (!a) break;
+      *link = a->_next;
+      _count--;
+      a->_handle.resume();
+    }
+  }
+
+  // Tasks suspended on this
+  int waiting() const { return _count; }
+
+  UniversalTelegramBot &bot;
+
+private:
+  friend class TelegramAwaiter;
+
+  template <typename Queue>
+  TelegramReplyAwaiter<Queue> call(Queue queue) {
+    return TelegramReplyAwaiter<Queue>(*this, queue);
+  }
+
+  void add(TelegramAwaiter *a) {
+    a->_round = _rounds;
+    a->_started = a->start();
+    // Appended, so tasks go on in the order they suspended
+    TelegramAwaiter **link = &_waiting;
+    while (*link) link = &(*link)->_next;
+    a->_next = nullptr;
+    *link = a;
+    _count++;
+  }
+
+  static void callDone(TelegramAsyncHandle handle, const TelegramResult &result,
+                       const String &body) {
+    if (!_ticking) return;
+    for (TelegramAwaiter *a = _ticking->_waiting; a; a = a->_next) {
+      if (a->finished(handle, result, body)) return;
+    }
+  }
+
+  TelegramAwaiter *_waiting = nullptr;
+  int _count = 0;
+  unsigned long _rounds = 0;
+  static inline TelegramCoroutines *_ticking = nullptr;  // whose bot is in tick()
+};
+
+inline void TelegramAwaiter::await_suspend(std::coroutine_handle<> handle) {
+  _handle = handle;
+  _co.add(this);
+}
+
+#endif
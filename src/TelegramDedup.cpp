@@ -0,0 +1,67 @@
+/*
+Copyright (c) 2018 Brian Lough. All right reserved.
+
+UniversalTelegramBot - Library to create your own Telegram Bot using
+ESP8266 or ESP32 on Arduino IDE.
+
+This library is free software; you can redistribute it and/or
+modify it under the terms of the GNU Lesser General Public
+License as published by the Free Software Foundation; either
+version 2.1 of the License, or (at your option) any later version.
+
+This library is distributed in the hope that it will be useful,
+but WITHOUT ANY WARRANTY; without even the implied warranty of
+MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the GNU
+Lesser General Public License for more details.
+
+You should have received a copy of the GNU Lesser General Public
+License along with this library; if not, write to the Free Software
+Foundation, Inc., 51 Franklin St, Fifth Floor, Boston, MA 02110-1301 USA
+*/
+
+#include "TelegramDedup.h"
+
+void TelegramUpdateFilter::reset() {
+  _newest = 0;
+  for (unsigned i = 0; i < TELEGRAM_DEDUP_WINDOW / 32; i++) _bits[i] = 0;
+}
+
+bool TelegramUpdateFilter::bit(long updateId) const {
+  unsigned long index = (unsigned long)updateId % TELEGRAM_DEDUP_WINDOW;
+  return _bits[index / 32] & (1ul << (index % 32));
+}
+
+void TelegramUpdateFilter::setBit(long updateId, bool value) {
+  unsigned long index = (unsigned long)updateId % TELEGRAM_DEDUP_WINDOW;
+  if (value) {
+    _bits[index / 32] |= 1ul << (index % 32);
+  } else {
+    _bits[index / 32] &= ~(1ul << (index % 32));
+  }
+}
+
+bool TelegramUpdateFilter::add(long updateId) {
+  if (_newest == 0 || updateId - _newest >= TELEGRAM_DEDUP_WINDOW ||
+      _newest - updateId >= TELEGRAM_DEDUP_WINDOW) {
+    // Nothing in the window is still behind it. A jump back that far is
+    // not a redelivery: after a week without updates Telegram may start
+    // the ids over at a lower, random value.
+    for (unsigned i = 0; i < TELEGRAM_DEDUP_WINDOW / 32; i++) _bits[i] = 0;
+    _newest = updateId;
+    setBit(updateId, true);
+    return true;
+  }
+
+  if (updateId > _newest) {
+    // The ids passed over were not seen; their bits still hold ids a
+    // window older
+    for (long id = _newest + 1; id < updateId; id++) setBit(id, false);
+    _newest = updateId;
+    setBit(updateId, true);
+    return true;
+  }
+
+  if (bit(updateId)) return false;
+  setBit(updateId, true);
+  return true;
+}
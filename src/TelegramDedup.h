@@ -0,0 +1,61 @@
+/*
+Copyright (c) 2018 Brian Lough. All right reserved.
+
+UniversalTelegramBot - Library to create your own Telegram Bot using
+ESP8266 or ESP32 on Arduino IDE.
+
+This library is free software; you can redistribute it and/or
+modify it under the terms of the GNU Lesser General Public
+License as published by the Free Software Foundation; either
+version 2.1 of the License, or (at your option) any later version.
+
+This library is distributed in the hope that it will be useful,
+but WITHOUT ANY WARRANTY; without even the implied warranty of
+MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the GNU
+Lesser General Public License for more details.
+
+You should have received a copy of the GNU Lesser General Public
+License along with this library; if not, write to the Free Software
+Foundation, Inc., 51 Franklin St, Fifth Floor, Boston, MA 02110-1301 USA
+*/
+
+#ifndef TelegramDedup_h
+#define TelegramDedup_h
+
+#include <Arduino.h>
+
+// Update ids remembered behind the newest one, a multiple of 32. Each
+// costs one bit.
+#ifndef TELEGRAM_DEDUP_WINDOW
+#define TELEGRAM_DEDUP_WINDOW 64
+#endif
+
+/*
+   Filters updates the bot has handed out before, e.g. when a retried
+   getUpdates or a reconnect delivers some of them again. It remembers the
+   newest update_id and, as a ring of bits indexed by id, which of the
+   TELEGRAM_DEDUP_WINDOW ids below it were seen. An id further away than
+   that, ahead or behind, starts the window over and is let through:
+   Telegram may restart its ids at a lower value after a week without
+   updates.
+
+   The bot checks every update against it before reading any other field;
+   duplicates are counted in bot.stats.duplicateUpdates.
+ */
+class TelegramUpdateFilter {
+public:
+  TelegramUpdateFilter() { reset(); }
+
+  void reset();
+  // Notes an update id; false if it was seen before
+  bool add(long updateId);
+
+private:
+  bool bit(long updateId) const;
+  void setBit(long updateId, bool value);
+
+  long _newest;   // 0 until the first update
+  uint32_t _bits[TELEGRAM_DEDUP_WINDOW / 32];
+};
+
+#endif
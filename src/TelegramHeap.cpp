@@ -0,0 +1,138 @@
+/*
+Copyright (c) 2018 Brian Lough. All right reserved.
+
+UniversalTelegramBot - Library to create your own Telegram Bot using
+ESP8266 or ESP32 on Arduino IDE.
+
+This library is free software; you can redistribute it and/or
+modify it under the terms of the GNU Lesser General Public
+License as published by the Free Software Foundation; either
+version 2.1 of the License, or (at your option) any later version.
+
+This library is distributed in the hope that it will be useful,
+but WITHOUT ANY WARRANTY; without even the implied warranty of
+MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the GNU
+Lesser General Public License for more details.
+
+You should have received a copy of the GNU Lesser General Public
+License along with this library; if not, write to the Free Software
+Foundation, Inc., 51 Franklin St, Fifth Floor, Boston, MA 02110-1301 USA
+*/
+
+#include "TelegramHeap.h"
+
+#if defined(ESP32)
+#include <esp_heap_caps.h>
+#endif
+
+static TelegramHeapProbe heapProbe = nullptr;
+
+void telegramSetHeapProbe(TelegramHeapProbe probe) {
+  heapProbe = probe;
+}
+
+bool telegramHeapSample(TelegramHeapSample &sample) {
+  if (heapProbe) return heapProbe(sample);
+
+#if defined(ESP8266)
+  sample.freeHeap = ESP.getFreeHeap();
+  sample.largestBlock = ESP.getMaxFreeBlockSize();
+  return true;
+#elif defined(ESP32)
+  sample.freeHeap = heap_caps_get_free_size(MALLOC_CAP_8BIT);
+  sample.largestBlock = heap_caps_get_largest_free_block(MALLOC_CAP_8BIT);
+  return true;
+#else
+  sample.freeHeap = 0;
+  sample.largestBlock = 0;
+  return false;
+#endif
+}
+
+TelegramHeapTracker::TelegramHeapTracker()
+    : regressionThreshold(128), onRegression(nullptr), _depth(0) {
+  reset();
+}
+
+void TelegramHeapTracker::reset() {
+  callCount = 0;
+  lastRegression = nullptr;
+  regressions = 0;
+}
+
+const TelegramHeapCall *TelegramHeapTracker::find(const __FlashStringHelper *name) const {
+  for (int i = 0; i < callCount; i++) {
+    if (calls[i].name == name) return &calls[i];
+  }
+  return nullptr;
+}
+
+void TelegramHeapTracker::enter() {
+  if (_depth++ == 0) _known = telegramHeapSample(_before);
+}
+
+void TelegramHeapTracker::leave(const __FlashStringHelper *name) {
+  if (--_depth != 0 || !_known) return;
+
+  TelegramHeapSample after;
+  if (!telegramHeapSample(after)) return;
+
+  TelegramHeapCall *call = (TelegramHeapCall *)find(name);
+  if (!call) {
+    if (callCount == TELEGRAM_HEAP_CALLS) return;
+    call = &calls[callCount++];
+    call->name = name;
+    call->calls = 0;
+    call->worstFreeDelta = 0;
+    call->worstLargestDelta = 0;
+    call->minFreeHeap = after.freeHeap;
+    call->minLargestBlock = after.largestBlock;
+  }
+
+  call->calls++;
+  call->lastFreeDelta = (int32_t)(after.freeHeap - _before.freeHeap);
+  call->lastLargestDelta = (int32_t)(after.largestBlock - _before.largestBlock);
+  if (call->lastFreeDelta < call->worstFreeDelta) call->worstFreeDelta = call->lastFreeDelta;
+  if (call->lastLargestDelta < call->worstLargestDelta) call->worstLargestDelta = call->lastLargestDelta;
+  if (after.freeHeap < call->minFreeHeap) call->minFreeHeap = after.freeHeap;
+  if (after.largestBlock < call->minLargestBlock) call->minLargestBlock = after.largestBlock;
+
+  if (call->lastFreeDelta < -regressionThreshold || call->lastLargestDelta < -regressionThreshold) {
+    regressions++;
+    lastRegression = call;
+    lastRegressionSample = after;
+    if (onRegression) onRegression(*call, after);
+  }
+}
+
+void TelegramHeapTracker::printTo(Print &out) const {
+  for (int i = 0; i < callCount; i++) {
+    const TelegramHeapCall &c = calls[i];
+    out.print(c.name);
+    out.print(F(" n="));
+    out.print(c.calls);
+    out.print(F(" free last="));
+    out.print(c.lastFreeDelta);
+    out.print(F(" worst="));
+    out.print(c.worstFreeDelta);
+    out.print(F(" min="));
+    out.print(c.minFreeHeap);
+    out.print(F(" largest last="));
+    out.print(c.lastLargestDelta);
+    out.print(F(" worst="));
+    out.print(c.worstLargestDelta);
+    out.print(F(" min="));
+    out.println(c.minLargestBlock);
+  }
+  if (lastRegression) {
+    out.print(F("last regression: "));
+    out.print(lastRegression->name);
+    out.print(F(" (free "));
+    out.print(lastRegressionSample.freeHeap);
+    out.print(F(", largest block "));
+    out.print(lastRegressionSample.largestBlock);
+    out.print(F("), "));
+    out.print(regressions);
+    out.println(F(" in total"));
+  }
+}
@@ -0,0 +1,123 @@
+/*
+Copyright (c) 2018 Brian Lough. All right reserved.
+
+UniversalTelegramBot - Library to create your own Telegram Bot using
+ESP8266 or ESP32 on Arduino IDE.
+
+This library is free software; you can redistribute it and/or
+modify it under the terms of the GNU Lesser General Public
+License as published by the Free Software Foundation; either
+version 2.1 of the License, or (at your option) any later version.
+
+This library is distributed in the hope that it will be useful,
+but WITHOUT ANY WARRANTY; without even the implied warranty of
+MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the GNU
+Lesser General Public License for more details.
+
+You should have received a copy of the GNU Lesser General Public
+License along with this library; if not, write to the Free Software
+Foundation, Inc., 51 Franklin St, Fifth Floor, Boston, MA 02110-1301 USA
+*/
+
+#ifndef TelegramHeap_h
+#define TelegramHeap_h
+
+#include <Arduino.h>
+
+// Number of public calls the tracker keeps figures for
+#ifndef TELEGRAM_HEAP_CALLS
+#define TELEGRAM_HEAP_CALLS 20
+#endif
+
+struct TelegramHeapSample {
+  uint32_t freeHeap;
+  uint32_t largestBlock; // biggest single allocation that would still succeed
+};
+
+// Fills sample from the platform's heap API. Returns false where the heap
+// can not be queried and no probe was installed.
+bool telegramHeapSample(TelegramHeapSample &sample);
+
+// Replaces the platform query, e.g. with one fed by an allocator hook on a
+// PC. Pass nullptr to go back to the platform query.
+typedef bool (*TelegramHeapProbe)(TelegramHeapSample &sample);
+void telegramSetHeapProbe(TelegramHeapProbe probe);
+
+/*
+   Define TELEGRAM_HEAP_TRACKING (in UniversalTelegramBot.h or as a build
+   flag) to sample the heap around every public call of the bot. For each
+   call the tracker keeps the free heap and largest block before and after,
+   the worst change seen, and reports the call after which either dropped by
+   more than regressionThreshold bytes:
+
+     bot.heap.onRegression = reportRegression;   // optional
+     bot.heap.printTo(Serial);
+
+   Only the outermost call is measured, so sendMessage is not also counted as
+   sendPostMessage and sendPostToTelegram.
+ */
+#ifdef TELEGRAM_HEAP_TRACKING
+#define TELEGRAM_HEAP_SCOPE(name) TelegramHeapScope heapScope(heap, F(name))
+#else
+#define TELEGRAM_HEAP_SCOPE(name)
+#endif
+
+struct TelegramHeapCall {
+  const __FlashStringHelper *name;
+  uint32_t calls;
+  int32_t lastFreeDelta;     // free heap after - before, negative is heap kept
+  int32_t worstFreeDelta;
+  int32_t lastLargestDelta;  // same for the largest block, i.e. fragmentation
+  int32_t worstLargestDelta;
+  uint32_t minFreeHeap;      // lowest free heap seen after this call
+  uint32_t minLargestBlock;
+};
+
+typedef void (*TelegramHeapRegressionCallback)(const TelegramHeapCall &call,
+                                               const TelegramHeapSample &after);
+
+class TelegramHeapTracker {
+public:
+  TelegramHeapTracker();
+  void reset();
+
+  // Drop in free heap or largest block that counts as a regression
+  int32_t regressionThreshold;
+  // Called right after a call that regressed
+  TelegramHeapRegressionCallback onRegression;
+
+  TelegramHeapCall calls[TELEGRAM_HEAP_CALLS];
+  int callCount;
+
+  // The most recent call that regressed, nullptr if none did
+  const TelegramHeapCall *lastRegression;
+  TelegramHeapSample lastRegressionSample;
+  uint32_t regressions;
+
+  const TelegramHeapCall *find(const __FlashStringHelper *name) const;
+  void printTo(Print &out) const;
+
+  // Used by TelegramHeapScope
+  void enter();
+  void leave(const __FlashStringHelper *name);
+
+private:
+  uint8_t _depth;
+  bool _known;
+  TelegramHeapSample _before;
+};
+
+class TelegramHeapScope {
+public:
+  TelegramHeapScope(TelegramHeapTracker &tracker, const __FlashStringHelper *name)
+      : _tracker(tracker), _name(name) {
+    _tracker.enter();
+  }
+  ~TelegramHeapScope() { _tracker.leave(_name); }
+
+private:
+  TelegramHeapTracker &_tracker;
+  const __FlashStringHelper *_name;
+};
+
+#endif
@@ -0,0 +1,191 @@
+/*
+Copyright (c) 2018 Brian Lough. All right reserved.
+
+UniversalTelegramBot - Library to create your own Telegram Bot using
+ESP8266 or ESP32 on Arduino IDE.
+
+This library is free software; you can redistribute it and/or
+modify it under the terms of the GNU Lesser General Public
+License as published by the Free Software Foundation; either
+version 2.1 of the License, or (at your option) any later version.
+
+This library is distributed in the hope that it will be useful,
+but WITHOUT ANY WARRANTY; without even the implied warranty of
+MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the GNU
+Lesser General Public License for more details.
+
+You should have received a copy of the GNU Lesser General Public
+License along with this library; if not, write to the Free Software
+Foundation, Inc., 51 Franklin St, Fifth Floor, Boston, MA 02110-1301 USA
+*/
+
+#include "TelegramHttpResponse.h"
+
+TelegramHttpResponse::TelegramHttpResponse() {
+  begin(nullptr, 0);
+}
+
+void TelegramHttpResponse::begin(String *body, int maxBodyLength) {
+  _state = STATUS_LINE;
+  _body = body;
+  _maxBodyLength = maxBodyLength;
+  _chunkRemaining = 0;
+  _chunkSizeSeen = false;
+  _lineLength = 0;
+  status = 0;
+  contentLength = -1;
+  chunked = false;
+  bodyLength = 0;
+  truncated = false;
+}
+
+bool TelegramHttpResponse::feed(char c) {
+  switch (_state) {
+    case STATUS_LINE:
+    case HEADER_LINE:
+    case TRAILER:
+      if (c == '\n') {
+        lineFinished();
+      } else if (c != '\r' && _lineLength < TELEGRAM_HTTP_LINE_LENGTH) {
+        _line[_lineLength++] = c;
+      }
+      break;
+
+    case BODY:
+      appendBody(c);
+      if (contentLength >= 0 && bodyLength >= contentLength) _state = DONE;
+      break;
+
+    case CHUNK_SIZE:
+      if (c == '\n') {
+        if (!_chunkSizeSeen) break; // blank line, tolerate and keep waiting
+        _state = _chunkRemaining > 0 ? CHUNK_DATA : TRAILER;
+        _lineLength = 0;
+      } else if (c == ';' || c == ' ' || c == '\t') {
+        _state = CHUNK_EXTENSION;
+      } else if (c != '\r') {
+        int digit;
+        if (c >= '0' && c <= '9') digit = c - '0';
+        else if (c >= 'a' && c <= 'f') digit = c - 'a' + 10;
+        else if (c >= 'A' && c <= 'F') digit = c - 'A' + 10;
+        else break;
+        if (_chunkRemaining > 0x7FFFFFFL) break; // absurd size, don't overflow
+        _chunkRemaining = (_chunkRemaining << 4) | digit;
+        _chunkSizeSeen = true;
+      }
+      break;
+
+    case CHUNK_EXTENSION:
+      // Chunk extensions are allowed by the spec but carry nothing we need
+      if (c == '\n') {
+        _state = _chunkRemaining > 0 ? CHUNK_DATA : TRAILER;
+        _lineLength = 0;
+      }
+      break;
+
+    case CHUNK_DATA:
+      appendBody(c);
+      if (--_chunkRemaining == 0) _state = CHUNK_DATA_END;
+      break;
+
+    case CHUNK_DATA_END:
+      // CRLF that closes the chunk data, then the next size line
+      if (c == '\n') {
+        _state = CHUNK_SIZE;
+        _chunkSizeSeen = false;
+      }
+      break;
+
+    case DONE:
+      break;
+  }
+
+  return _state == DONE;
+}
+
+bool TelegramHttpResponse::closed() {
+  if (_state == BODY && contentLength < 0) _state = DONE;
+  return _state == DONE;
+}
+
+void TelegramHttpResponse::appendBody(char c) {
+  bodyLength++;
+  if (_body == nullptr) return;
+
+  if ((int)_body->length() < _maxBodyLength) {
+    *_body += c;
+  } else {
+    truncated = true;
+  }
+}
+
+void TelegramHttpResponse::lineFinished() {
+  _line[_lineLength] = '\0';
+
+  if (_state == STATUS_LINE) {
+    // "HTTP/1.1 200 OK"
+    if (lineStartsWith("http/")) {
+      for (int i = 5; i < _lineLength; i++) {
+        if (_line[i] == ' ') {
+          status = (int)lineValue(i + 1);
+          break;
+        }
+      }
+    }
+    _state = HEADER_LINE;
+  } else if (_state == TRAILER) {
+    if (_lineLength == 0) _state = DONE;
+  } else if (_lineLength == 0) {
+    // Blank line, end of the headers
+    if (status >= 100 && status < 200) {
+      // Interim response (100 Continue), the real one follows
+      begin(_body, _maxBodyLength);
+    } else if (status == 204 || status == 304 || contentLength == 0) {
+      _state = DONE;
+    } else if (chunked) {
+      _state = CHUNK_SIZE;
+      _chunkSizeSeen = false;
+      _chunkRemaining = 0;
+    } else {
+      _state = BODY;
+    }
+  } else if (lineStartsWith("content-length:")) {
+    contentLength = lineValue(15);
+  } else if (lineStartsWith("transfer-encoding:")) {
+    // Only the last coding matters and for a response it is always chunked
+    // when present at all
+    for (int i = 18; i + 7 <= _lineLength; i++) {
+      if ((_line[i] | 0x20) == 'c' && (_line[i + 1] | 0x20) == 'h' &&
+          (_line[i + 2] | 0x20) == 'u' && (_line[i + 3] | 0x20) == 'n' &&
+          (_line[i + 4] | 0x20) == 'k' && (_line[i + 5] | 0x20) == 'e' &&
+          (_line[i + 6] | 0x20) == 'd') {
+        chunked = true;
+        break;
+      }
+    }
+  }
+
+  _lineLength = 0;
+}
+
+bool TelegramHttpResponse::lineStartsWith(const char *prefix) const {
+  int i = 0;
+  for (; prefix[i] != '\0'; i++) {
+    if (i >= _lineLength) return false;
+    char c = _line[i];
+    if (c >= 'A' && c <= 'Z') c += 'a' - 'A';
+    if (c != prefix[i]) return false;
+  }
+  return true;
+}
+
+long TelegramHttpResponse::lineValue(int from) const {
+  long value = 0;
+  int i = from;
+  while (i < _lineLength && (_line[i] == ' ' || _line[i] == '\t')) i++;
+  while (i < _lineLength && _line[i] >= '0' && _line[i] <= '9') {
+    value = value * 10 + (_line[i] - '0');
+    i++;
+  }
+  return value;
+}
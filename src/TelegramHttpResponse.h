@@ -0,0 +1,91 @@
+/*
+Copyright (c) 2018 Brian Lough. All right reserved.
+
+UniversalTelegramBot - Library to create your own Telegram Bot using
+ESP8266 or ESP32 on Arduino IDE.
+
+This library is free software; you can redistribute it and/or
+modify it under the terms of the GNU Lesser General Public
+License as published by the Free Software Foundation; either
+version 2.1 of the License, or (at your option) any later version.
+
+This library is distributed in the hope that it will be useful,
+but WITHOUT ANY WARRANTY; without even the implied warranty of
+MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the GNU
+Lesser General Public License for more details.
+
+You should have received a copy of the GNU Lesser General Public
+License along with this library; if not, write to the Free Software
+Foundation, Inc., 51 Franklin St, Fifth Floor, Boston, MA 02110-1301 USA
+*/
+
+#ifndef TelegramHttpResponse_h
+#define TelegramHttpResponse_h
+
+#include <Arduino.h>
+
+// Longest header line prefix that is kept for inspection. Only the status
+// line, Content-Length and Transfer-Encoding are looked at, so anything
+// past this is simply dropped.
+#define TELEGRAM_HTTP_LINE_LENGTH 48
+
+/*
+   Incremental HTTP/1.1 response parser. Bytes are fed one at a time as they
+   arrive from the client, in whatever fragments the network delivers them,
+   and the body is appended to a String without any intermediate copy. Both
+   Content-Length and Transfer-Encoding: chunked bodies are understood; chunk
+   framing is stripped on the fly so the String only ever holds the payload.
+ */
+class TelegramHttpResponse {
+public:
+  TelegramHttpResponse();
+
+  // Resets the parser. The body is appended to *body, at most maxBodyLength
+  // characters are kept; the rest is still consumed but dropped.
+  void begin(String *body, int maxBodyLength);
+
+  // Feeds one byte of the response. Returns true once the response is
+  // complete; bytes fed after that are ignored.
+  bool feed(char c);
+
+  // Tells the parser the server closed the connection. A body that has
+  // neither Content-Length nor chunked framing ends here. Returns finished().
+  bool closed();
+
+  bool finished() const { return _state == DONE; }
+  bool headersFinished() const { return _state >= BODY; }
+
+  int status;           // HTTP status code, 0 until the status line is read
+  long contentLength;   // -1 when the response has no Content-Length
+  bool chunked;         // Transfer-Encoding: chunked
+  long bodyLength;      // payload bytes received, including dropped ones
+  bool truncated;       // payload did not fit in maxBodyLength
+
+private:
+  enum State {
+    STATUS_LINE,
+    HEADER_LINE,
+    BODY,
+    CHUNK_SIZE,
+    CHUNK_EXTENSION,
+    CHUNK_DATA,
+    CHUNK_DATA_END,
+    TRAILER,
+    DONE
+  };
+
+  void appendBody(char c);
+  void lineFinished();
+  bool lineStartsWith(const char *prefix) const;
+  long lineValue(int from) const;
+
+  State _state;
+  String *_body;
+  int _maxBodyLength;
+  long _chunkRemaining;
+  bool _chunkSizeSeen;
+  char _line[TELEGRAM_HTTP_LINE_LENGTH + 1];
+  int _lineLength;
+};
+
+#endif
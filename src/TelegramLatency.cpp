@@ -0,0 +1,162 @@
+/*
+Copyright (c) 2018 Brian Lough. All right reserved.
+
+UniversalTelegramBot - Library to create your own Telegram Bot using
+ESP8266 or ESP32 on Arduino IDE.
+
+This library is free software; you can redistribute it and/or
+modify it under the terms of the GNU Lesser General Public
+License as published by the Free Software Foundation; either
+version 2.1 of the License, or (at your option) any later version.
+
+This library is distributed in the hope that it will be useful,
+but WITHOUT ANY WARRANTY; without even the implied warranty of
+MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the GNU
+Lesser General Public License for more details.
+
+You should have received a copy of the GNU Lesser General Public
+License along with this library; if not, write to the Free Software
+Foundation, Inc., 51 Franklin St, Fifth Floor, Boston, MA 02110-1301 USA
+*/
+
+#include "TelegramLatency.h"
+
+void TelegramLatencyHistogram::reset() {
+  count = 0;
+  minMicros = 0;
+  maxMicros = 0;
+  totalMicros = 0;
+  for (int i = 0; i < TELEGRAM_LATENCY_BUCKETS; i++) buckets[i] = 0;
+}
+
+void TelegramLatencyHistogram::record(unsigned long micros) {
+  int bucket = 0;
+  while (bucket < TELEGRAM_LATENCY_BUCKETS - 1 && micros >= bucketLimit(bucket)) bucket++;
+  if (buckets[bucket] < 0xFFFF) buckets[bucket]++;
+
+  if (count == 0 || micros < minMicros) minMicros = micros;
+  if (micros > maxMicros) maxMicros = micros;
+  totalMicros += micros;
+  count++;
+}
+
+unsigned long TelegramLatencyHistogram::mean() const {
+  return count ? (unsigned long)(totalMicros / count) : 0;
+}
+
+unsigned long TelegramLatencyHistogram::percentile(int p) const {
+  uint32_t total = 0;
+  for (int i = 0; i < TELEGRAM_LATENCY_BUCKETS; i++) total += buckets[i];
+  if (total == 0) return 0;
+
+  uint32_t wanted = ((unsigned long long)total * p + 99) / 100;
+  uint32_t seen = 0;
+  for (int i = 0; i < TELEGRAM_LATENCY_BUCKETS; i++) {
+    seen += buckets[i];
+    if (seen >= wanted && seen > 0) {
+      unsigned long limit = bucketLimit(i);
+      return (limit == 0 || limit > maxMicros) ? maxMicros : limit;
+    }
+  }
+  return maxMicros;
+}
+
+unsigned long TelegramLatencyHistogram::bucketLimit(int bucket) {
+  if (bucket >= TELEGRAM_LATENCY_BUCKETS - 1) return 0;
+  return 128ul << bucket;
+}
+
+TelegramLatencyStats::TelegramLatencyStats() {
+  reset();
+}
+
+void TelegramLatencyStats::reset() {
+  for (int m = 0; m < TELEGRAM_METHOD_COUNT; m++) {
+    for (int p = 0; p < TELEGRAM_PHASE_COUNT; p++) methods[m].phases[p].reset();
+    methods[m].failures = 0;
+  }
+  _method = TELEGRAM_OTHER_METHOD;
+  _active = false;
+  _lapped = 0;
+}
+
+void TelegramLatencyStats::begin(const String &command) {
+  _method = telegramMethodId(command.c_str());
+  _start = _mark = micros();
+  _active = true;
+  _gotFirstByte = false;
+  _lapped = 0;
+}
+
+void TelegramLatencyStats::mark() {
+  _mark = micros();
+}
+
+void TelegramLatencyStats::lap(TelegramLatencyPhase phase) {
+  unsigned long now = micros();
+  _laps[phase] = now - _mark;
+  _lapped |= 1 << phase;
+  _mark = now;
+}
+
+void TelegramLatencyStats::firstByte() {
+  if (!_gotFirstByte) {
+    _gotFirstByte = true;
+    lap(TELEGRAM_PHASE_FIRST_BYTE);
+  }
+}
+
+void TelegramLatencyStats::end(bool ok) {
+  if (!_active) return;
+  _active = false;
+
+  TelegramMethodLatency &m = methods[_method];
+  if (!ok) {
+    m.failures++;
+    // A connect that worked is still worth keeping
+    if (_lapped & (1 << TELEGRAM_PHASE_CONNECT)) {
+      m.phases[TELEGRAM_PHASE_CONNECT].record(_laps[TELEGRAM_PHASE_CONNECT]);
+    }
+    return;
+  }
+
+  for (int p = 0; p < TELEGRAM_PHASE_TOTAL; p++) {
+    if (_lapped & (1 << p)) m.phases[p].record(_laps[p]);
+  }
+  m.phases[TELEGRAM_PHASE_TOTAL].record(micros() - _start);
+}
+
+void TelegramLatencyStats::parsed() {
+  methods[_method].phases[TELEGRAM_PHASE_PARSE].record(micros() - _mark);
+}
+
+void TelegramLatencyStats::printTo(Print &out) const {
+  static const char *const phaseNames[TELEGRAM_PHASE_COUNT] = {
+    "connect", "send", "ttfb", "body", "parse", "total"
+  };
+
+  for (int m = 0; m < TELEGRAM_METHOD_COUNT; m++) {
+    const TelegramMethodLatency &method = methods[m];
+    if (method.phases[TELEGRAM_PHASE_TOTAL].count == 0 && method.failures == 0) continue;
+
+    out.print(telegramMethodName(m));
+    out.print(F(" n="));
+    out.print(method.phases[TELEGRAM_PHASE_TOTAL].count);
+    out.print(F(" failed="));
+    out.println(method.failures);
+    for (int p = 0; p < TELEGRAM_PHASE_COUNT; p++) {
+      const TelegramLatencyHistogram &h = method.phases[p];
+      if (h.count == 0) continue;
+      out.print(F("  "));
+      out.print(phaseNames[p]);
+      out.print(F(" us p50="));
+      out.print(h.percentile(50));
+      out.print(F(" p95="));
+      out.print(h.percentile(95));
+      out.print(F(" max="));
+      out.print(h.maxMicros);
+      out.print(F(" n="));
+      out.println(h.count);
+    }
+  }
+}
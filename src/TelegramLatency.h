@@ -0,0 +1,117 @@
+/*
+Copyright (c) 2018 Brian Lough. All right reserved.
+
+UniversalTelegramBot - Library to create your own Telegram Bot using
+ESP8266 or ESP32 on Arduino IDE.
+
+This library is free software; you can redistribute it and/or
+modify it under the terms of the GNU Lesser General Public
+License as published by the Free Software Foundation; either
+version 2.1 of the License, or (at your option) any later version.
+
+This library is distributed in the hope that it will be useful,
+but WITHOUT ANY WARRANTY; without even the implied warranty of
+MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the GNU
+Lesser General Public License for more details.
+
+You should have received a copy of the GNU Lesser General Public
+License along with this library; if not, write to the Free Software
+Foundation, Inc., 51 Franklin St, Fifth Floor, Boston, MA 02110-1301 USA
+*/
+
+#ifndef TelegramLatency_h
+#define TelegramLatency_h
+
+#include <Arduino.h>
+#include <TelegramMethod.h>
+
+// Number of histogram buckets per phase. Bucket 0 holds everything below
+// 128us, each following bucket doubles the limit, and the last one is open
+// ended (2.1s and up with 16 buckets).
+#define TELEGRAM_LATENCY_BUCKETS 16
+
+/*
+   Define TELEGRAM_LATENCY_STATS (in UniversalTelegramBot.h or as a build
+   flag, so the library sources see it too) to time every request the bot
+   makes. Results are kept per Bot API method in bot.latency; without the
+   define the bot has no latency member and all the timing calls compile to
+   nothing.
+
+   With all methods that is about 3.5KB of RAM.
+ */
+#ifdef TELEGRAM_LATENCY_STATS
+#define TELEGRAM_LATENCY(call) latency.call
+#else
+#define TELEGRAM_LATENCY(call)
+#endif
+
+enum TelegramLatencyPhase {
+  TELEGRAM_PHASE_CONNECT,    // DNS, TCP and TLS, only when a new connection was made
+  TELEGRAM_PHASE_SEND,       // writing the request, including any upload
+  TELEGRAM_PHASE_FIRST_BYTE, // request sent to first response byte
+  TELEGRAM_PHASE_BODY,       // first byte to complete response
+  TELEGRAM_PHASE_PARSE,      // deserializing the JSON answer
+  TELEGRAM_PHASE_TOTAL,      // whole request, connect to complete response
+  TELEGRAM_PHASE_COUNT
+};
+
+struct TelegramLatencyHistogram {
+  uint32_t count;
+  uint32_t minMicros;
+  uint32_t maxMicros;
+  unsigned long long totalMicros;
+  uint16_t buckets[TELEGRAM_LATENCY_BUCKETS]; // saturate at 65535
+
+  void reset();
+  void record(unsigned long micros);
+  unsigned long mean() const;
+  // Upper bound of the bucket holding the p-th percentile, capped at
+  // maxMicros. 0 when nothing was recorded.
+  unsigned long percentile(int p) const;
+
+  // Exclusive upper limit of a bucket in microseconds, 0 for the last one
+  static unsigned long bucketLimit(int bucket);
+};
+
+struct TelegramMethodLatency {
+  TelegramLatencyHistogram phases[TELEGRAM_PHASE_COUNT];
+  uint32_t failures; // no connection, or no complete response in time
+};
+
+/*
+   Latency histograms of one bot, plus the bookkeeping for the request in
+   flight. UniversalTelegramBot drives begin / lap / end as a request goes
+   through its phases; applications only read methods[] or call printTo().
+ */
+class TelegramLatencyStats {
+public:
+  TelegramLatencyStats();
+  void reset();
+
+  TelegramMethodLatency methods[TELEGRAM_METHOD_COUNT];
+
+  const TelegramMethodLatency &method(TelegramMethod id) const { return methods[id]; }
+
+  // One line per method that was used, with p50 / p95 / max per phase
+  void printTo(Print &out) const;
+
+  // Request in flight
+  void begin(const String &command);
+  void mark();
+  void lap(TelegramLatencyPhase phase);
+  void firstByte();
+  void end(bool ok);
+  // Time since mark(), recorded as the parse time of the last request
+  void parsed();
+
+private:
+  TelegramMethod _method;
+  unsigned long _start;
+  unsigned long _mark;
+  bool _active;
+  bool _gotFirstByte;
+  uint8_t _lapped;
+  unsigned long _laps[TELEGRAM_PHASE_COUNT];
+};
+
+#endif
@@ -0,0 +1,113 @@
+/*
+Copyright (c) 2018 Brian Lough. All right reserved.
+
+UniversalTelegramBot - Library to create your own Telegram Bot using
+ESP8266 or ESP32 on Arduino IDE.
+
+This library is free software; you can redistribute it and/or
+modify it under the terms of the GNU Lesser General Public
+License as published by the Free Software Foundation; either
+version 2.1 of the License, or (at your option) any later version.
+
+This library is distributed in the hope that it will be useful,
+but WITHOUT ANY WARRANTY; without even the implied warranty of
+MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the GNU
+Lesser General Public License for more details.
+
+You should have received a copy of the GNU Lesser General Public
+License along with this library; if not, write to the Free Software
+Foundation, Inc., 51 Franklin St, Fifth Floor, Boston, MA 02110-1301 USA
+*/
+
+
+#ifndef TelegramLock_h
+#define TelegramLock_h
+
+#include <Arduino.h>
+
+/*
+   Define TELEGRAM_THREAD_SAFE (as a build flag, so the library sources see
+   it too) when several tasks use the same bot, e.g. a sensor task sending
+   alerts while loop() handles commands. Every public call then runs as a
+   call of its own:
+
+   - the connection, request state and result belong to the call, so calls
+     from different tasks do not see each other's
+   - a call holds a connection from bot.pool only while it talks to the
+     server; building and serializing the JSON payload happens before that,
+     so producers only queue behind each other for the network itself. Add
+     clients with addClient() and that many calls run at the same time.
+   - bot.stats, last_sent_message_id and bot.trace are updated under a short
+     lock of their own
+   - bot.lastResult() returns the outcome of the calling task's own last
+     call (ok, error code, message_id)
+
+   getUpdates and messages[] belong to one task, the one that polls.
+   TELEGRAM_LATENCY_STATS and TELEGRAM_HEAP_TRACKING time and measure one
+   call after another and can not be combined with it.
+
+   Supported on ESP32 (FreeRTOS mutexes) and in host builds (std::mutex).
+   Without the define all of this compiles to nothing.
+ */
+#ifdef TELEGRAM_THREAD_SAFE
+
+#if defined(TELEGRAM_LATENCY_STATS) || defined(TELEGRAM_HEAP_TRACKING)
+#error "TELEGRAM_THREAD_SAFE can not be combined with TELEGRAM_LATENCY_STATS or TELEGRAM_HEAP_TRACKING"
+#endif
+
+#if defined(ESP32)
+#include <freertos/FreeRTOS.h>
+#include <freertos/semphr.h>
+
+class TelegramMutex {
+public:
+  TelegramMutex() : _handle(xSemaphoreCreateMutex()) {}
+  ~TelegramMutex() { vSemaphoreDelete(_handle); }
+  void lock() { xSemaphoreTake(_handle, portMAX_DELAY); }
+  void unlock() { xSemaphoreGive(_handle); }
+
+private:
+  SemaphoreHandle_t _handle;
+};
+#elif !defined(ARDUINO)
+#include <mutex>
+
+class TelegramMutex {
+public:
+  void lock() { _mutex.lock(); }
+  void unlock() { _mutex.unlock(); }
+
+private:
+  std::mutex _mutex;
+};
+#else
+#error "TELEGRAM_THREAD_SAFE needs FreeRTOS (ESP32) or a host build"
+#endif
+
+class TelegramLockGuard {
+public:
+  TelegramLockGuard(TelegramMutex &mutex) : _mutex(mutex) { _mutex.lock(); }
+  ~TelegramLockGuard() { _mutex.unlock(); }
+
+private:
+  TelegramMutex &_mutex;
+};
+
+// Holds mutex until the end of the enclosing block
+#define TELEGRAM_LOCK_SCOPE(mutex) TelegramLockGuard lockGuard(mutex)
+// Runs the statements with mutex held; without TELEGRAM_THREAD_SAFE the
+// mutex is not even looked at
+#define TELEGRAM_LOCKED(mutex, ...)     \
+  do {                                  \
+    TelegramLockGuard lockGuard(mutex); \
+    __VA_ARGS__;                        \
+  } while (0)
+#else
+#define TELEGRAM_LOCK_SCOPE(mutex)
+#define TELEGRAM_LOCKED(mutex, ...) \
+  do {                              \
+    __VA_ARGS__;                    \
+  } while (0)
+#endif
+
+#endif
@@ -0,0 +1,55 @@
+/*
+Copyright (c) 2018 Brian Lough. All right reserved.
+
+UniversalTelegramBot - Library to create your own Telegram Bot using
+ESP8266 or ESP32 on Arduino IDE.
+
+This library is free software; you can redistribute it and/or
+modify it under the terms of the GNU Lesser General Public
+License as published by the Free Software Foundation; either
+version 2.1 of the License, or (at your option) any later version.
+
+This library is distributed in the hope that it will be useful,
+but WITHOUT ANY WARRANTY; without even the implied warranty of
+MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the GNU
+Lesser General Public License for more details.
+
+You should have received a copy of the GNU Lesser General Public
+License along with this library; if not, write to the Free Software
+Foundation, Inc., 51 Franklin St, Fifth Floor, Boston, MA 02110-1301 USA
+*/
+
+#include "TelegramMethod.h"
+
+static const char *const methodNames[TELEGRAM_METHOD_COUNT] = {
+  "getMe",
+  "getUpdates",
+  "sendMessage",
+  "editMessageText",
+  "deleteMessage",
+  "sendChatAction",
+  "sendPhoto",
+  "getFile",
+  "answerCallbackQuery",
+  "setMyCommands",
+  "other"
+};
+
+TelegramMethod telegramMethodId(const char *command) {
+  // Skip "bot<token>/", the token itself contains a ':' but never a '/'
+  const char *name = strchr(command, '/');
+  name = name ? name + 1 : command;
+
+  size_t length = strcspn(name, "?");
+  for (int i = 0; i < TELEGRAM_OTHER_METHOD; i++) {
+    if (strlen(methodNames[i]) == length && strncmp(methodNames[i], name, length) == 0) {
+      return (TelegramMethod)i;
+    }
+  }
+  return TELEGRAM_OTHER_METHOD;
+}
+
+const char *telegramMethodName(int method) {
+  if (method < 0 || method >= TELEGRAM_METHOD_COUNT) method = TELEGRAM_OTHER_METHOD;
+  return methodNames[method];
+}
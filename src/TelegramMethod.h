@@ -0,0 +1,54 @@
+/*
+Copyright (c) 2018 Brian Lough. All right reserved.
+
+UniversalTelegramBot - Library to create your own Telegram Bot using
+ESP8266 or ESP32 on Arduino IDE.
+
+This library is free software; you can redistribute it and/or
+modify it under the terms of the GNU Lesser General Public
+License as published by the Free Software Foundation; either
+version 2.1 of the License, or (at your option) any later version.
+
+This library is distributed in the hope that it will be useful,
+but WITHOUT ANY WARRANTY; without even the implied warranty of
+MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the GNU
+Lesser General Public License for more details.
+
+You should have received a copy of the GNU Lesser General Public
+License along with this library; if not, write to the Free Software
+Foundation, Inc., 51 Franklin St, Fifth Floor, Boston, MA 02110-1301 USA
+*/
+
+#ifndef TelegramMethod_h
+#define TelegramMethod_h
+
+#include <Arduino.h>
+
+/*
+   Small integer ids for the Bot API methods the library calls, so per-method
+   statistics can be kept in plain arrays instead of keyed by name.
+ */
+enum TelegramMethod {
+  TELEGRAM_GET_ME,
+  TELEGRAM_GET_UPDATES,
+  TELEGRAM_SEND_MESSAGE,
+  TELEGRAM_EDIT_MESSAGE_TEXT,
+  TELEGRAM_DELETE_MESSAGE,
+  TELEGRAM_SEND_CHAT_ACTION,
+  TELEGRAM_SEND_PHOTO,
+  TELEGRAM_GET_FILE,
+  TELEGRAM_ANSWER_CALLBACK_QUERY,
+  TELEGRAM_SET_MY_COMMANDS,
+  TELEGRAM_OTHER_METHOD,
+  TELEGRAM_METHOD_COUNT
+};
+
+// Method of a command as built by buildCommand ("bot<token>/sendMessage?...")
+// or a bare method name ("sendPhoto"). Unknown methods map to
+// TELEGRAM_OTHER_METHOD.
+TelegramMethod telegramMethodId(const char *command);
+
+// Bot API name of a method id, "other" for TELEGRAM_OTHER_METHOD
+const char *telegramMethodName(int method);
+
+#endif
@@ -0,0 +1,98 @@
+/*
+Copyright (c) 2018 Brian Lough. All right reserved.
+
+UniversalTelegramBot - Library to create your own Telegram Bot using
+ESP8266 or ESP32 on Arduino IDE.
+
+This library is free software; you can redistribute it and/or
+modify it under the terms of the GNU Lesser General Public
+License as published by the Free Software Foundation; either
+version 2.1 of the License, or (at your option) any later version.
+
+This library is distributed in the hope that it will be useful,
+but WITHOUT ANY WARRANTY; without even the implied warranty of
+MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the GNU
+Lesser General Public License for more details.
+
+You should have received a copy of the GNU Lesser General Public
+License along with this library; if not, write to the Free Software
+Foundation, Inc., 51 Franklin St, Fifth Floor, Boston, MA 02110-1301 USA
+*/
+
+#include "TelegramOffsetStore.h"
+
+#if defined(ESP32) || defined(ESP8266)
+#include <FS.h>
+#elif !defined(ARDUINO)
+#include <stdio.h>
+#endif
+#if defined(ESP32)
+#include <Preferences.h>
+#endif
+
+#if defined(ESP32) || defined(ESP8266)
+
+bool TelegramFileOffsetStore::load(long &offset) {
+  File file = _fs.open(_path, "r");
+  // Power was cut between removing the old file and renaming the new one
+  if (!file) file = _fs.open(String(_path) + ".tmp", "r");
+  if (!file) return false;
+  String text = file.readStringUntil('\n');
+  file.close();
+  if (text.length() == 0) return false;
+  offset = text.toInt();
+  return true;
+}
+
+bool TelegramFileOffsetStore::save(long offset) {
+  String temporary = String(_path) + ".tmp";
+  File file = _fs.open(temporary, "w");
+  if (!file) return false;
+  bool written = file.println(offset) > 0;
+  file.close();
+  if (!written) return false;
+  _fs.remove(_path);
+  return _fs.rename(temporary, _path);
+}
+
+#elif !defined(ARDUINO)
+
+bool TelegramFileOffsetStore::load(long &offset) {
+  FILE *file = fopen(_path, "r");
+  if (!file) return false;
+  bool read = fscanf(file, "%ld", &offset) == 1;
+  fclose(file);
+  return read;
+}
+
+bool TelegramFileOffsetStore::save(long offset) {
+  String temporary = String(_path) + ".tmp";
+  FILE *file = fopen(temporary.c_str(), "w");
+  if (!file) return false;
+  bool written = fprintf(file, "%ld\n", offset) > 0;
+  written = fclose(file) == 0 && written;
+  return written && rename(temporary.c_str(), _path) == 0;
+}
+
+#endif
+
+#if defined(ESP32)
+
+bool TelegramNvsOffsetStore::load(long &offset) {
+  Preferences preferences;
+  if (!preferences.begin(_name, true)) return false;
+  bool found = preferences.isKey("offset");
+  if (found) offset = preferences.getLong("offset");
+  preferences.end();
+  return found;
+}
+
+bool TelegramNvsOffsetStore::save(long offset) {
+  Preferences preferences;
+  if (!preferences.begin(_name, false)) return false;
+  bool written = preferences.putLong("offset", offset) > 0;
+  preferences.end();
+  return written;
+}
+
+#endif
@@ -0,0 +1,106 @@
+/*
+Copyright (c) 2018 Brian Lough. All right reserved.
+
+UniversalTelegramBot - Library to create your own Telegram Bot using
+ESP8266 or ESP32 on Arduino IDE.
+
+This library is free software; you can redistribute it and/or
+modify it under the terms of the GNU Lesser General Public
+License as published by the Free Software Foundation; either
+version 2.1 of the License, or (at your option) any later version.
+
+This library is distributed in the hope that it will be useful,
+but WITHOUT ANY WARRANTY; without even the implied warranty of
+MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the GNU
+Lesser General Public License for more details.
+
+You should have received a copy of the GNU Lesser General Public
+License along with this library; if not, write to the Free Software
+Foundation, Inc., 51 Franklin St, Fifth Floor, Boston, MA 02110-1301 USA
+*/
+
+#ifndef TelegramOffsetStore_h
+#define TelegramOffsetStore_h
+
+#include <Arduino.h>
+
+#if defined(ESP32) || defined(ESP8266)
+namespace fs {
+class FS;
+}
+#endif
+
+/*
+   Non-volatile home for the update offset, so a bot picks up after a
+   reboot or OTA update where it left off, neither handling updates twice
+   nor throwing the backlog away with getUpdates(-1):
+
+     TelegramFileOffsetStore offsetStore(LittleFS, "/telegram.offset");
+     ...
+     LittleFS.begin();
+     bot.setOffsetStore(&offsetStore);   // resumes from the saved offset
+
+   Calling getUpdates(offset) acknowledges every update before offset, to
+   Telegram and to the store. The acknowledged offset is written once
+   saveEveryUpdates updates have been acknowledged since the last write or
+   saveEveryMs has passed with at least one, so flash sees a write per batch
+   instead of one per update; LittleFS and NVS spread those writes over the
+   flash themselves. After a crash at most the last batch is handled again.
+   Call bot.saveOffset() before a planned restart (OTA, deep sleep) to
+   resume exactly. A store holds the offset of one token; with
+   TelegramBotGroup give each token its own, set after bots.use().
+
+   Stores for LittleFS / SPIFFS files (ESP32, ESP8266, and plain files in
+   the Linux build) and ESP32 NVS are below; anything else can be plugged
+   in by implementing load() and save().
+ */
+class TelegramOffsetStore {
+public:
+  virtual ~TelegramOffsetStore() {}
+
+  // The offset saved last, false when there is none
+  virtual bool load(long &offset) = 0;
+  virtual bool save(long offset) = 0;
+};
+
+#if defined(ESP32) || defined(ESP8266) || !defined(ARDUINO)
+/*
+   The offset as text in a file, written to a temporary file and renamed
+   over the old one so a power cut leaves one or the other.
+ */
+class TelegramFileOffsetStore : public TelegramOffsetStore {
+public:
+#if defined(ESP32) || defined(ESP8266)
+  TelegramFileOffsetStore(fs::FS &fs, const char *path) : _fs(fs), _path(path) {}
+#else
+  explicit TelegramFileOffsetStore(const char *path) : _path(path) {}
+#endif
+
+  bool load(long &offset) override;
+  bool save(long offset) override;
+
+private:
+#if defined(ESP32) || defined(ESP8266)
+  fs::FS &_fs;
+#endif
+  const char *_path;
+};
+#endif
+
+#if defined(ESP32)
+/*
+   The offset in NVS through Preferences, under the given namespace.
+ */
+class TelegramNvsOffsetStore : public TelegramOffsetStore {
+public:
+  explicit TelegramNvsOffsetStore(const char *name = "telegram") : _name(name) {}
+
+  bool load(long &offset) override;
+  bool save(long offset) override;
+
+private:
+  const char *_name;
+};
+#endif
+
+#endif
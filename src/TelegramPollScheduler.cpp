@@ -0,0 +1,84 @@
+/*
+Copyright (c) 2018 Brian Lough. All right reserved.
+
+UniversalTelegramBot - Library to create your own Telegram Bot using
+ESP8266 or ESP32 on Arduino IDE.
+
+This library is free software; you can redistribute it and/or
+modify it under the terms of the GNU Lesser General Public
+License as published by the Free Software Foundation; either
+version 2.1 of the License, or (at your option) any later version.
+
+This library is distributed in the hope that it will be useful,
+but WITHOUT ANY WARRANTY; without even the implied warranty of
+MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the GNU
+Lesser General Public License for more details.
+
+You should have received a copy of the GNU Lesser General Public
+License along with this library; if not, write to the Free Software
+Foundation, Inc., 51 Franklin St, Fifth Floor, Boston, MA 02110-1301 USA
+*/
+
+#include "TelegramPollScheduler.h"
+
+TelegramPollScheduler::TelegramPollScheduler()
+    : adaptive(false), shortPollMs(1000), idleAfterMs(30000), idlePollMs(10000),
+      retryMs(1000), maxRetryMs(60000), _mode(TELEGRAM_POLL_NOW), _limit(0),
+      _canLongPoll(false), _next(0), _lastTraffic(0), _traffic(false), _failures(0) {
+}
+
+bool TelegramPollScheduler::due() const {
+  return !adaptive || (long)(millis() - _next) >= 0;
+}
+
+unsigned long TelegramPollScheduler::untilNextPoll() const {
+  long wait = (long)(_next - millis());
+  return adaptive && wait > 0 ? wait : 0;
+}
+
+void TelegramPollScheduler::schedule(unsigned long delayMs) {
+  _next = millis() + delayMs;
+}
+
+int TelegramPollScheduler::started(int limit, int longPoll) {
+  _limit = limit;
+  if (!adaptive) return longPoll;
+
+  if (_traffic && millis() - _lastTraffic >= idleAfterMs) _traffic = false;
+  _canLongPoll = longPoll > 0;
+  return _canLongPoll && !_traffic ? longPoll : 0;
+}
+
+/***************************************************************
+ * Received - picks the mode and time of the next poll from    *
+ * the size of the batch the last one brought                  *
+ ***************************************************************/
+void TelegramPollScheduler::received(int updates, bool more) {
+  _failures = 0;
+  if (updates > 0) {
+    _traffic = true;
+    _lastTraffic = millis();
+  } else if (_traffic && millis() - _lastTraffic >= idleAfterMs) {
+    _traffic = false;
+  }
+
+  if (more || (updates > 0 && updates >= _limit)) {
+    _mode = TELEGRAM_POLL_NOW;
+    schedule(0);
+  } else if (_traffic) {
+    _mode = TELEGRAM_POLL_SHORT;
+    schedule(shortPollMs);
+  } else {
+    // A long poll does its waiting on the server
+    _mode = TELEGRAM_POLL_LONG;
+    schedule(_canLongPoll ? 0 : idlePollMs);
+  }
+}
+
+void TelegramPollScheduler::failed() {
+  unsigned long wait = retryMs;
+  for (int i = 0; i < _failures && wait < maxRetryMs; i++) wait *= 2;
+  if (wait > maxRetryMs) wait = maxRetryMs;
+  if (_failures < 16) _failures++;
+  schedule(wait);
+}
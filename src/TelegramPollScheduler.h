@@ -0,0 +1,101 @@
+/*
+Copyright (c) 2018 Brian Lough. All right reserved.
+
+UniversalTelegramBot - Library to create your own Telegram Bot using
+ESP8266 or ESP32 on Arduino IDE.
+
+This library is free software; you can redistribute it and/or
+modify it under the terms of the GNU Lesser General Public
+License as published by the Free Software Foundation; either
+version 2.1 of the License, or (at your option) any later version.
+
+This library is distributed in the hope that it will be useful,
+but WITHOUT ANY WARRANTY; without even the implied warranty of
+MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the GNU
+Lesser General Public License for more details.
+
+You should have received a copy of the GNU Lesser General Public
+License along with this library; if not, write to the Free Software
+Foundation, Inc., 51 Franklin St, Fifth Floor, Boston, MA 02110-1301 USA
+*/
+
+#ifndef TelegramPollScheduler_h
+#define TelegramPollScheduler_h
+
+#include <Arduino.h>
+
+enum TelegramPollMode {
+  TELEGRAM_POLL_LONG,    // idle: the poll waits on the server for bot.longPoll seconds
+  TELEGRAM_POLL_SHORT,   // recent traffic: quick polls every shortPollMs
+  TELEGRAM_POLL_NOW      // the last batch was full: more is waiting
+};
+
+/*
+   Decides when to poll and for how long, from the traffic the polls see,
+   instead of a fixed BOT_MTBS and longPoll. Off until adaptive is set:
+
+     bot.longPoll = 30;              // what an idle poll waits on the server
+     bot.polling.adaptive = true;
+
+     void loop() {
+       if (bot.polling.due()) {
+         int n = bot.getUpdates(bot.last_message_received + 1);
+         for (int i = 0; i < n; i++) handle(bot.messages[i]);
+       }
+       doOtherWork();
+       delay(bot.polling.untilNextPoll());   // or a light sleep
+     }
+
+   A batch as large as the poll asked for means more updates are queued,
+   so the next poll is due at once. While updates came in the last
+   idleAfterMs the bot polls without a server timeout every shortPollMs,
+   which keeps the loop and the replies to a conversation from waiting
+   behind a long poll. Once it has been quiet that long it long-polls:
+   one request that Telegram holds until an update arrives or longPoll
+   runs out, due again right after it returns. With longPoll at 0 an idle
+   bot polls every idlePollMs instead. A failed poll is retried after
+   retryMs, doubled for every further failure up to maxRetryMs.
+
+   getUpdates and getUpdatesAsync report to it, so it is driven from the
+   one task that polls.
+ */
+class TelegramPollScheduler {
+public:
+  TelegramPollScheduler();
+
+  bool adaptive;               // off: every poll uses longPoll and is due at once
+  unsigned long shortPollMs;   // between polls while there is traffic
+  unsigned long idleAfterMs;   // quiet time after which it long-polls
+  unsigned long idlePollMs;    // between idle polls when longPoll is 0
+  unsigned long retryMs;       // after a failed poll
+  unsigned long maxRetryMs;
+
+  TelegramPollMode mode() const { return _mode; }
+  // The next poll is due; always true while not adaptive
+  bool due() const;
+  // millis() when the next poll is due
+  unsigned long nextPollAt() const { return _next; }
+  // Milliseconds until then, 0 when due: how long the sketch may sleep
+  unsigned long untilNextPoll() const;
+
+  // Called by the bot for each poll: started() with the limit it asks for
+  // returns the server timeout to ask for, then one of received() with the
+  // number of updates in the answer (more if it was cut short) or failed()
+  int started(int limit, int longPoll);
+  int limit() const { return _limit; }
+  void received(int updates, bool more = false);
+  void failed();
+
+private:
+  void schedule(unsigned long delayMs);
+
+  TelegramPollMode _mode;
+  int _limit;                  // of the poll in flight
+  bool _canLongPoll;           // bot.longPoll is set
+  unsigned long _next;
+  unsigned long _lastTraffic;
+  bool _traffic;               // any update seen since idleAfterMs ago
+  int _failures;               // in a row
+};
+
+#endif
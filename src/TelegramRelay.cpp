@@ -0,0 +1,487 @@
+/*
+Copyright (c) 2018 Brian Lough. All right reserved.
+
+UniversalTelegramBot - Library to create your own Telegram Bot using
+ESP8266 or ESP32 on Arduino IDE.
+
+This library is free software; you can redistribute it and/or
+modify it under the terms of the GNU Lesser General Public
+License as published by the Free Software Foundation; either
+version 2.1 of the License, or (at your option) any later version.
+
+This library is distributed in the hope that it will be useful,
+but WITHOUT ANY WARRANTY; without even the implied warranty of
+MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the GNU
+Lesser General Public License for more details.
+
+You should have received a copy of the GNU Lesser General Public
+License along with this library; if not, write to the Free Software
+Foundation, Inc., 51 Franklin St, Fifth Floor, Boston, MA 02110-1301 USA
+*/
+
+#include "TelegramRelay.h"
+
+#define RELAY_VERSION 1
+#define RELAY_HEADER_SIZE 14
+
+#define RELAY_HELLO 1
+#define RELAY_UPDATE 2
+#define RELAY_SEND 3
+
+#define RELAY_FLAG_LEADER 0x01
+
+/*
+   Bounds-checked writing and reading of the little endian fields. A writer
+   that runs out of room cuts strings short at a character boundary; a
+   reader that runs out of data fails.
+ */
+namespace {
+
+struct Writer {
+  uint8_t *data;
+  size_t size;
+  size_t length;
+  bool truncated;
+
+  Writer(uint8_t *data, size_t size) : data(data), size(size), length(0), truncated(false) {}
+
+  void put8(uint8_t value) {
+    if (length < size) {
+      data[length++] = value;
+    } else {
+      truncated = true;
+    }
+  }
+  void put16(uint16_t value) {
+    put8(value);
+    put8(value >> 8);
+  }
+  void put32(uint32_t value) {
+    put16(value);
+    put16(value >> 16);
+  }
+  void putFloat(float value) {
+    uint32_t bits;
+    memcpy(&bits, &value, sizeof(bits));
+    put32(bits);
+  }
+  // Leaves reserve bytes for the fields that follow
+  void putString(const String &value, size_t reserve = 0) {
+    size_t n = value.length();
+    size_t room = size - length >= reserve + 2 ? size - length - reserve - 2 : 0;
+    if (n > room) {
+      n = room;
+      // Not in the middle of a UTF-8 sequence
+      while (n > 0 && ((uint8_t)value[n] & 0xC0) == 0x80) n--;
+      truncated = true;
+    }
+    if (size - length < 2) return;
+    put16(n);
+    memcpy(data + length, value.c_str(), n);
+    length += n;
+  }
+};
+
+struct Reader {
+  const uint8_t *data;
+  size_t size;
+  size_t position;
+  bool failed;
+
+  Reader(const uint8_t *data, size_t size) : data(data), size(size), position(0), failed(false) {}
+
+  uint8_t get8() {
+    if (position >= size) {
+      failed = true;
+      return 0;
+    }
+    return data[position++];
+  }
+  uint16_t get16() {
+    uint16_t low = get8();
+    return low | (uint16_t)get8() << 8;
+  }
+  uint32_t get32() {
+    uint32_t low = get16();
+    return low | (uint32_t)get16() << 16;
+  }
+  float getFloat() {
+    uint32_t bits = get32();
+    float value;
+    memcpy(&value, &bits, sizeof(value));
+    return value;
+  }
+  void getString(String &value) {
+    size_t n = get16();
+    value = "";
+    if (failed || n > size - position) {
+      failed = true;
+      return;
+    }
+    value.reserve(n);
+    for (size_t i = 0; i < n; i++) value += (char)data[position + i];
+    position += n;
+  }
+};
+
+}  // namespace
+
+TelegramRelay::TelegramRelay(UniversalTelegramBot &bot, UDP &udp, uint16_t nodeId)
+    : bot(bot), _udp(udp), _nodeId(nodeId), _leader(0), _session(micros() ^ (uint32_t)nodeId << 16),
+      _started(millis()), _helloAt(0), _lastSend(0), _peerCount(0), _queued(0) {
+  memset(&stats, 0, sizeof(stats));
+  // Say hello on the first getUpdates()
+  _helloAt = _started - heartbeatMs;
+}
+
+bool TelegramRelay::addPeer(IPAddress ip, uint16_t port) {
+  if (_peerCount >= TELEGRAM_RELAY_MAX_PEERS) return false;
+  Peer &peer = _peers[_peerCount++];
+  peer.ip = ip;
+  peer.port = port;
+  peer.nodeId = 0;
+  peer.heardAt = 0;
+  peer.leading = false;
+  peer.session = 0;
+  peer.received = 0;
+  peer.sent = 0;
+  return true;
+}
+
+TelegramRelay::Peer *TelegramRelay::peer(uint16_t nodeId) {
+  for (int i = 0; i < _peerCount; i++) {
+    if (_peers[i].nodeId == nodeId) return &_peers[i];
+  }
+  return nullptr;
+}
+
+/***************************************************************
+ * GetUpdates - takes in what the other nodes sent, elects the *
+ * leader and, on the leader, sends queued messages and polls. *
+ * Returns the number of new updates in bot.messages.          *
+ ***************************************************************/
+int TelegramRelay::getUpdates() {
+  int count = 0;
+  receive(count);
+  elect();
+  if ((long)(millis() - _helloAt) >= (long)heartbeatMs) hello();
+  if (!isLeader() || count > 0) return count;
+
+  sendQueued();
+
+  // Messages waiting for the rate limiter should not wait for a long poll
+  int longPoll = bot.longPoll;
+  if (_queued > 0) bot.longPoll = 0;
+  uint32_t conflicts = bot.stats.conflicts;
+  count = bot.getUpdates(bot.last_message_received + 1);
+  bot.longPoll = longPoll;
+  if (bot.stats.conflicts != conflicts) stats.conflicts++;
+
+  for (int i = 0; i < count; i++) relay(bot.messages[i]);
+  return count;
+}
+
+bool TelegramRelay::sendMessage(const String &chat_id, const String &text,
+                                const String &parse_mode) {
+  // Until a leader is known messages wait here, elect() passes them on
+  if (_leader != 0 && !isLeader()) return forward(chat_id, text, parse_mode);
+  return queue(chat_id, text, parse_mode);
+}
+
+/***************************************************************
+ * Receive - handles the datagrams that arrived, stopping when *
+ * bot.messages is full                                        *
+ ***************************************************************/
+void TelegramRelay::receive(int &count) {
+  while (count < HANDLE_MESSAGES) {
+    int size = _udp.parsePacket();
+    if (size <= 0) return;
+
+    uint8_t packet[TELEGRAM_RELAY_PACKET_SIZE];
+    int length = _udp.read(packet, sizeof(packet));
+    // Drain a datagram too long to be ours
+    while (_udp.available() && _udp.read() >= 0) {}
+
+    Peer *from = nullptr;
+    IPAddress ip = _udp.remoteIP();
+    uint16_t port = _udp.remotePort();
+    for (int i = 0; i < _peerCount; i++) {
+      if (_peers[i].ip == ip && _peers[i].port == port) from = &_peers[i];
+    }
+
+    Reader in(packet, length > 0 ? length : 0);
+    bool ours = in.get8() == 'T' && in.get8() == 'R' && in.get8() == RELAY_VERSION;
+    uint8_t type = in.get8();
+    uint16_t nodeId = in.get16();
+    uint32_t session = in.get32();
+    uint32_t sequence = in.get32();
+    if (!from || !ours || in.failed || size > (int)sizeof(packet) || nodeId == 0) {
+      stats.invalid++;
+      continue;
+    }
+
+    // A restarted node counts from the beginning again
+    if (from->nodeId != nodeId || from->session != session) {
+      from->nodeId = nodeId;
+      from->session = session;
+      from->received = sequence - 1;
+    }
+    if ((int32_t)(sequence - from->received) <= 0) {
+      stats.duplicates++;
+      continue;
+    }
+    stats.lost += sequence - from->received - 1;
+    from->received = sequence;
+    from->heardAt = millis();
+
+    handle(*from, type, packet + RELAY_HEADER_SIZE, length - RELAY_HEADER_SIZE, count);
+  }
+}
+
+void TelegramRelay::handle(Peer &peer, uint8_t type, const uint8_t *data, size_t length,
+                           int &count) {
+  Reader in(data, length);
+
+  if (type == RELAY_HELLO) {
+    uint8_t flags = in.get8();
+    long offset = (int32_t)in.get32();
+    if (in.failed) {
+      stats.invalid++;
+      return;
+    }
+    peer.leading = flags & RELAY_FLAG_LEADER;
+    // Updates the leader has handed out already need not be asked for
+    // again by whoever takes over
+    if (peer.leading && offset > bot.last_message_received) bot.last_message_received = offset;
+    return;
+  }
+
+  if (type == RELAY_UPDATE) {
+    telegramMessage &message = bot.messages[count];
+    message.update_id = (int32_t)in.get32();
+    message.message_id = (int32_t)in.get32();
+    message.reply_to_message_id = (int32_t)in.get32();
+    message.file_size = (int32_t)in.get32();
+    message.latitude = in.getFloat();
+    message.longitude = in.getFloat();
+    message.hasDocument = in.get8() != 0;
+    in.getString(message.chat_id);
+    in.getString(message.chat_title);
+    in.getString(message.from_id);
+    in.getString(message.from_name);
+    in.getString(message.date);
+    in.getString(message.type);
+    in.getString(message.file_path);
+    in.getString(message.file_name);
+    in.getString(message.query_id);
+    in.getString(message.file_caption);
+    in.getString(message.reply_to_text);
+    in.getString(message.text);
+    if (in.failed) {
+      stats.invalid++;
+      return;
+    }
+    // Seen already, from a leader before this one
+    if (message.update_id <= bot.last_message_received) return;
+    bot.last_message_received = message.update_id;
+    stats.updatesReceived++;
+    count++;
+    return;
+  }
+
+  if (type == RELAY_SEND) {
+    String chatId, text, parseMode;
+    in.getString(chatId);
+    in.getString(parseMode);
+    in.getString(text);
+    if (in.failed) {
+      stats.invalid++;
+      return;
+    }
+    stats.sendsReceived++;
+    // A node that has not noticed the change of leader yet
+    if (!isLeader() && _leader != 0) {
+      forward(chatId, text, parseMode);
+    } else {
+      queue(chatId, text, parseMode);
+    }
+    return;
+  }
+
+  stats.invalid++;
+}
+
+/***************************************************************
+ * Elect - the leader is the node with the lowest id heard     *
+ * from lately, this one included once it has waited long      *
+ * enough to have heard the others                             *
+ ***************************************************************/
+void TelegramRelay::elect() {
+  unsigned long now = millis();
+  uint16_t leader = now - _started >= leaderTimeoutMs ? _nodeId : 0;
+  for (int i = 0; i < _peerCount; i++) {
+    const Peer &peer = _peers[i];
+    if (peer.nodeId == 0 || now - peer.heardAt >= leaderTimeoutMs) continue;
+    if (leader == 0 || peer.nodeId < leader) leader = peer.nodeId;
+  }
+  if (leader == _leader) return;
+
+  bool wasLeader = isLeader();
+  _leader = leader;
+  stats.leaderChanges++;
+  // Let the others know at once
+  if (wasLeader || isLeader()) hello();
+
+  // Messages held back here belong to the new leader now
+  if (_leader != 0 && !isLeader()) {
+    for (int i = 0; i < _queued; i++) {
+      forward(_queue[i].chatId, _queue[i].text, _queue[i].parseMode);
+    }
+    _queued = 0;
+  }
+}
+
+void TelegramRelay::hello() {
+  _helloAt = millis();
+  Writer out(_packet + RELAY_HEADER_SIZE, sizeof(_packet) - RELAY_HEADER_SIZE);
+  out.put8(isLeader() ? RELAY_FLAG_LEADER : 0);
+  out.put32(bot.last_message_received);
+  for (int i = 0; i < _peerCount; i++) send(_peers[i], RELAY_HELLO, out.length);
+}
+
+void TelegramRelay::relay(const telegramMessage &message) {
+  Writer out(_packet + RELAY_HEADER_SIZE, sizeof(_packet) - RELAY_HEADER_SIZE);
+  out.put32(message.update_id);
+  out.put32(message.message_id);
+  out.put32(message.reply_to_message_id);
+  out.put32(message.file_size);
+  out.putFloat(message.latitude);
+  out.putFloat(message.longitude);
+  out.put8(message.hasDocument);
+  // The short fields first; room is kept for the length of each long
+  // one, so only those can be cut
+  out.putString(message.chat_id, 6);
+  out.putString(message.chat_title, 6);
+  out.putString(message.from_id, 6);
+  out.putString(message.from_name, 6);
+  out.putString(message.date, 6);
+  out.putString(message.type, 6);
+  out.putString(message.file_path, 6);
+  out.putString(message.file_name, 6);
+  out.putString(message.query_id, 6);
+  out.putString(message.file_caption, 4);
+  out.putString(message.reply_to_text, 2);
+  out.putString(message.text);
+  if (out.truncated) stats.truncated++;
+
+  for (int i = 0; i < _peerCount; i++) {
+    send(_peers[i], RELAY_UPDATE, out.length);
+    stats.updatesRelayed++;
+  }
+}
+
+bool TelegramRelay::forward(const String &chatId, const String &text, const String &parseMode) {
+  Peer *leader = peer(_leader);
+  if (!leader) {
+    stats.sendsDropped++;
+    return false;
+  }
+
+  Writer out(_packet + RELAY_HEADER_SIZE, sizeof(_packet) - RELAY_HEADER_SIZE);
+  out.putString(chatId, 4);
+  out.putString(parseMode, 2);
+  out.putString(text);
+  if (out.truncated) stats.truncated++;
+  send(*leader, RELAY_SEND, out.length);
+  stats.sendsForwarded++;
+  return true;
+}
+
+bool TelegramRelay::queue(const String &chatId, const String &text, const String &parseMode) {
+  if (_queued >= TELEGRAM_RELAY_QUEUE) {
+    stats.sendsDropped++;
+    return false;
+  }
+  Outgoing &entry = _queue[_queued++];
+  entry.chatId = chatId;
+  entry.text = text;
+  entry.parseMode = parseMode;
+  return true;
+}
+
+/***************************************************************
+ * SendQueued - sends the queued messages, oldest first, as    *
+ * far as the rate limits allow                                *
+ ***************************************************************/
+void TelegramRelay::sendQueued() {
+  while (_queued > 0) {
+    // The next message is at most sendIntervalMs away, worth waiting for
+    unsigned long sinceLast = millis() - _lastSend;
+    if (sinceLast < sendIntervalMs) delay(sendIntervalMs - sinceLast);
+
+    // The oldest message whose chat may have another one; a chat's
+    // messages stay in order as they all wait for the same chat
+    unsigned long now = millis();
+    int next = -1;
+    for (int i = 0; i < _queued && next < 0; i++) {
+      if (chatReady(_queue[i].chatId, now)) next = i;
+    }
+    if (next < 0) return;
+
+    Outgoing &entry = _queue[next];
+    if (bot.sendMessage(entry.chatId, entry.text, entry.parseMode)) stats.sent++;
+    _lastSend = millis();
+    chatSent(entry.chatId, _lastSend);
+
+    for (int i = next; i + 1 < _queued; i++) {
+      _queue[i].chatId = _queue[i + 1].chatId;
+      _queue[i].text = _queue[i + 1].text;
+      _queue[i].parseMode = _queue[i + 1].parseMode;
+    }
+    _queued--;
+    _queue[_queued].text = "";
+  }
+}
+
+bool TelegramRelay::chatReady(const String &chatId, unsigned long now) {
+  for (int i = 0; i < TELEGRAM_RELAY_QUEUE; i++) {
+    if (_chats[i].chatId == chatId) return now - _chats[i].sentAt >= chatIntervalMs;
+  }
+  return true;
+}
+
+void TelegramRelay::chatSent(const String &chatId, unsigned long now) {
+  // The chat's own entry, else the one sent to longest ago
+  int slot = 0;
+  for (int i = 0; i < TELEGRAM_RELAY_QUEUE; i++) {
+    if (_chats[i].chatId == chatId) {
+      slot = i;
+      break;
+    }
+    if (_chats[i].chatId.length() == 0 ||
+        now - _chats[i].sentAt > now - _chats[slot].sentAt) {
+      slot = i;
+    }
+  }
+  _chats[slot].chatId = chatId;
+  _chats[slot].sentAt = now;
+}
+
+/***************************************************************
+ * Send - puts the header in front of the payload in _packet   *
+ * and sends it to a peer                                      *
+ ***************************************************************/
+void TelegramRelay::send(Peer &peer, uint8_t type, size_t length) {
+  Writer out(_packet, RELAY_HEADER_SIZE);
+  out.put8('T');
+  out.put8('R');
+  out.put8(RELAY_VERSION);
+  out.put8(type);
+  out.put16(_nodeId);
+  out.put32(_session);
+  out.put32(++peer.sent);
+
+  if (!_udp.beginPacket(peer.ip, peer.port)) return;
+  _udp.write(_packet, RELAY_HEADER_SIZE + length);
+  _udp.endPacket();
+}
@@ -0,0 +1,186 @@
+/*
+Copyright (c) 2018 Brian Lough. All right reserved.
+
+UniversalTelegramBot - Library to create your own Telegram Bot using
+ESP8266 or ESP32 on Arduino IDE.
+
+This library is free software; you can redistribute it and/or
+modify it under the terms of the GNU Lesser General Public
+License as published by the Free Software Foundation; either
+version 2.1 of the License, or (at your option) any later version.
+
+This library is distributed in the hope that it will be useful,
+but WITHOUT ANY WARRANTY; without even the implied warranty of
+MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the GNU
+Lesser General Public License for more details.
+
+You should have received a copy of the GNU Lesser General Public
+License along with this library; if not, write to the Free Software
+Foundation, Inc., 51 Franklin St, Fifth Floor, Boston, MA 02110-1301 USA
+*/
+
+#ifndef TelegramRelay_h
+#define TelegramRelay_h
+
+#include <Udp.h>
+#include <UniversalTelegramBot.h>
+
+// Other nodes one relay talks to
+#ifndef TELEGRAM_RELAY_MAX_PEERS
+#define TELEGRAM_RELAY_MAX_PEERS 4
+#endif
+
+// Largest datagram sent; longer text is cut to fit (stats.truncated)
+#ifndef TELEGRAM_RELAY_PACKET_SIZE
+#define TELEGRAM_RELAY_PACKET_SIZE 1024
+#endif
+
+// Messages the leader holds back for its rate limiter
+#ifndef TELEGRAM_RELAY_QUEUE
+#define TELEGRAM_RELAY_QUEUE 8
+#endif
+
+/*
+   Several devices sharing one bot token. Telegram lets only one client
+   call getUpdates per token, the others get 409 Conflict, so the relays
+   elect a leader among themselves: the node with the lowest id heard from
+   in the last leaderTimeoutMs. The leader polls and sends every update on
+   to the other nodes over UDP; the others take them from there. Messages
+   are sent through the leader from every node, so one rate limiter covers
+   them all.
+
+     WiFiUDP udp;
+     UniversalTelegramBot bot(BOT_TOKEN, client);
+     TelegramRelay relay(bot, udp, NODE_ID);   // unique per device, 1..65535
+
+     void setup() {
+       udp.begin(4210);
+       relay.addPeer(IPAddress(192, 168, 1, 21), 4210);
+       relay.addPeer(IPAddress(192, 168, 1, 22), 4210);
+     }
+
+     void loop() {
+       int n = relay.getUpdates();              // the same on every node
+       for (int i = 0; i < n; i++) {
+         if (bot.messages[i].text == "/door")
+           relay.sendMessage(bot.messages[i].chat_id, "closed");
+       }
+     }
+
+   Every node gets every update in bot.messages and decides itself what to
+   answer. Nodes say hello to their peers every heartbeatMs, the leader's
+   hello carrying its offset so a node taking over goes on from there. A
+   node waits leaderTimeoutMs after start before it leads, so a restarted
+   device does not poll over a leader it has not heard yet.
+
+   The leader sends queued messages no more often than sendIntervalMs and
+   to one chat no more often than chatIntervalMs; a full queue drops them
+   (stats.sendsDropped). Queued messages go out from getUpdates(), which on
+   the leader blocks for bot.longPoll, so keep that at a second or two.
+
+   Datagrams carry the sender's id and a sequence number. Repeats are
+   dropped and gaps counted in stats.lost; there is no resending, so use it
+   on a local network. The format is little endian:
+
+     header   'T' 'R' version type, node id (2), session (4), sequence (4)
+     HELLO    flags (1, bit 0 leader), offset (4)
+     UPDATE   update_id, message_id, reply_to_message_id, file_size (4
+              each), latitude, longitude (float), hasDocument (1), then
+              chat_id, chat_title, from_id, from_name, date, type,
+              file_path, file_name, query_id, file_caption, reply_to_text,
+              text as length (2) and bytes, the last three cut to fit
+     SEND     chat_id, parse_mode, text as length (2) and bytes
+ */
+
+struct TelegramRelayStats {
+  uint32_t updatesRelayed;    // updates sent on, once per peer
+  uint32_t updatesReceived;   // from the leader
+  uint32_t sendsForwarded;    // messages handed to the leader
+  uint32_t sendsReceived;     // messages the leader took from other nodes
+  uint32_t sent;              // messages the leader sent to Telegram
+  uint32_t sendsDropped;      // queue full, or no leader to hand them to
+  uint32_t lost;              // sequence numbers that never arrived
+  uint32_t duplicates;
+  uint32_t invalid;           // datagrams that were not ours or cut short
+  uint32_t truncated;         // updates or messages cut to fit a datagram
+  uint32_t leaderChanges;
+  uint32_t conflicts;         // 409s while this node led
+};
+
+class TelegramRelay {
+public:
+  TelegramRelay(UniversalTelegramBot &bot, UDP &udp, uint16_t nodeId);
+
+  // Adds a node to talk to; false when TELEGRAM_RELAY_MAX_PEERS are there
+  bool addPeer(IPAddress ip, uint16_t port);
+
+  // Handles what arrived from the other nodes and, on the leader, sends
+  // what the rate limiter lets through and polls. Returns the number of
+  // new updates in bot.messages.
+  int getUpdates();
+  // Sends a message through the leader; false if it can not be queued
+  bool sendMessage(const String &chat_id, const String &text, const String &parse_mode = "");
+
+  bool isLeader() const { return _leader == _nodeId; }
+  uint16_t leader() const { return _leader; }  // 0 while none is known
+
+  unsigned long heartbeatMs = 1000;
+  unsigned long leaderTimeoutMs = 3500;
+  unsigned int sendIntervalMs = 40;      // about 25 messages a second
+  unsigned int chatIntervalMs = 1000;    // per chat
+  TelegramRelayStats stats;
+
+  UniversalTelegramBot &bot;
+
+private:
+  struct Peer {
+    IPAddress ip;
+    uint16_t port;
+    uint16_t nodeId;       // 0 until heard from
+    unsigned long heardAt;
+    bool leading;
+    uint32_t session;      // of the node's current run
+    uint32_t received;     // last sequence number from it
+    uint32_t sent;         // last sequence number to it
+  };
+
+  struct Outgoing {
+    String chatId;
+    String text;
+    String parseMode;
+  };
+
+  struct Chat {
+    String chatId;
+    unsigned long sentAt;
+  };
+
+  void receive(int &count);
+  void handle(Peer &peer, uint8_t type, const uint8_t *data, size_t length, int &count);
+  void elect();
+  void hello();
+  void relay(const telegramMessage &message);
+  bool forward(const String &chatId, const String &text, const String &parseMode);
+  bool queue(const String &chatId, const String &text, const String &parseMode);
+  void sendQueued();
+  bool chatReady(const String &chatId, unsigned long now);
+  void chatSent(const String &chatId, unsigned long now);
+  void send(Peer &peer, uint8_t type, size_t length);
+  Peer *peer(uint16_t nodeId);
+
+  UDP &_udp;
+  uint16_t _nodeId;
+  uint16_t _leader;
+  uint32_t _session;
+  unsigned long _started;
+  unsigned long _helloAt;
+  unsigned long _lastSend;
+  Peer _peers[TELEGRAM_RELAY_MAX_PEERS];
+  int _peerCount;
+  Outgoing _queue[TELEGRAM_RELAY_QUEUE];
+  int _queued;
+  Chat _chats[TELEGRAM_RELAY_QUEUE];
+  uint8_t _packet[TELEGRAM_RELAY_PACKET_SIZE];
+};
+
+#endif
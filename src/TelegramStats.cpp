@@ -0,0 +1,91 @@
+/*
+Copyright (c) 2018 Brian Lough. All right reserved.
+
+UniversalTelegramBot - Library to create your own Telegram Bot using
+ESP8266 or ESP32 on Arduino IDE.
+
+This library is free software; you can redistribute it and/or
+modify it under the terms of the GNU Lesser General Public
+License as published by the Free Software Foundation; either
+version 2.1 of the License, or (at your option) any later version.
+
+This library is distributed in the hope that it will be useful,
+but WITHOUT ANY WARRANTY; without even the implied warranty of
+MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the GNU
+Lesser General Public License for more details.
+
+You should have received a copy of the GNU Lesser General Public
+License along with this library; if not, write to the Free Software
+Foundation, Inc., 51 Franklin St, Fifth Floor, Boston, MA 02110-1301 USA
+*/
+
+#include "TelegramStats.h"
+
+void TelegramStats::reset() {
+  for (int i = 0; i < TELEGRAM_METHOD_COUNT; i++) requests[i] = 0;
+  failedRequests = 0;
+  bytesOut = 0;
+  bytesIn = 0;
+  connects = 0;
+  reconnects = 0;
+  connectFailures = 0;
+  tlsHandshakes = 0;
+  parseFailures = 0;
+  truncatedResponses = 0;
+  retries = 0;
+  rateLimited = 0;
+  conflicts = 0;
+  offsetSaves = 0;
+  duplicateUpdates = 0;
+  peakHeapUsed = 0;
+  minFreeHeap = 0;
+}
+
+uint32_t TelegramStats::totalRequests() const {
+  uint32_t total = 0;
+  for (int i = 0; i < TELEGRAM_METHOD_COUNT; i++) total += requests[i];
+  return total;
+}
+
+void TelegramStats::toJson(JsonObject obj) const {
+  JsonObject perMethod = obj["requests"].to<JsonObject>();
+  for (int i = 0; i < TELEGRAM_METHOD_COUNT; i++) {
+    if (requests[i]) perMethod[telegramMethodName(i)] = requests[i];
+  }
+  obj["failed"] = failedRequests;
+  obj["bytes_out"] = bytesOut;
+  obj["bytes_in"] = bytesIn;
+  obj["connects"] = connects;
+  obj["reconnects"] = reconnects;
+  obj["connect_failures"] = connectFailures;
+  obj["tls_handshakes"] = tlsHandshakes;
+  obj["parse_failures"] = parseFailures;
+  obj["truncated"] = truncatedResponses;
+  obj["retries"] = retries;
+  obj["rate_limited"] = rateLimited;
+  obj["conflicts"] = conflicts;
+  obj["offset_saves"] = offsetSaves;
+  obj["duplicate_updates"] = duplicateUpdates;
+  obj["peak_heap_used"] = peakHeapUsed;
+  obj["min_free_heap"] = minFreeHeap;
+}
+
+String TelegramStats::toJson() const {
+  JsonDocument doc;
+  toJson(doc.to<JsonObject>());
+  String out;
+  serializeJson(doc, out);
+  return out;
+}
+
+size_t TelegramCountingPrint::write(uint8_t b) {
+  size_t n = target ? target->write(b) : 0;
+  _counter += n;
+  return n;
+}
+
+size_t TelegramCountingPrint::write(const uint8_t *buffer, size_t size) {
+  size_t n = target ? target->write(buffer, size) : 0;
+  _counter += n;
+  return n;
+}
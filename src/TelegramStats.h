@@ -0,0 +1,82 @@
+/*
+Copyright (c) 2018 Brian Lough. All right reserved.
+
+UniversalTelegramBot - Library to create your own Telegram Bot using
+ESP8266 or ESP32 on Arduino IDE.
+
+This library is free software; you can redistribute it and/or
+modify it under the terms of the GNU Lesser General Public
+License as published by the Free Software Foundation; either
+version 2.1 of the License, or (at your option) any later version.
+
+This library is distributed in the hope that it will be useful,
+but WITHOUT ANY WARRANTY; without even the implied warranty of
+MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the GNU
+Lesser General Public License for more details.
+
+You should have received a copy of the GNU Lesser General Public
+License along with this library; if not, write to the Free Software
+Foundation, Inc., 51 Franklin St, Fifth Floor, Boston, MA 02110-1301 USA
+*/
+
+#ifndef TelegramStats_h
+#define TelegramStats_h
+
+#include <Arduino.h>
+#include <ArduinoJson.h>
+#include <TelegramMethod.h>
+
+/*
+   Counters kept by every bot in bot.stats. They only ever grow, until
+   reset(); sample them periodically and subtract to get rates.
+ */
+struct TelegramStats {
+  uint32_t requests[TELEGRAM_METHOD_COUNT]; // per Bot API method, see TelegramMethod.h
+  uint32_t failedRequests;      // no connection, or no complete response in time
+  unsigned long long bytesOut;  // request bytes written, uploads included
+  unsigned long long bytesIn;   // response bytes read, headers included
+  uint32_t connects;            // connections opened
+  uint32_t reconnects;          // of those, after the server dropped the last one
+  uint32_t connectFailures;
+  uint32_t tlsHandshakes;       // connects with a secure server (see setServer)
+  uint32_t parseFailures;       // responses that were not valid JSON
+  uint32_t truncatedResponses;  // bodies cut at maxMessageLength
+  uint32_t retries;             // failed attempts inside the send retry loops
+  uint32_t rateLimited;         // 429 Too Many Requests answers
+  uint32_t conflicts;           // 409 Conflict, another getUpdates on the same token
+  uint32_t offsetSaves;         // update offsets written to the offset store
+  uint32_t duplicateUpdates;    // updates delivered again and dropped
+  uint32_t peakHeapUsed;        // largest drop of free heap during one request
+  uint32_t minFreeHeap;         // lowest free heap seen, 0 where the heap is unknown
+
+  TelegramStats() { reset(); }
+  void reset();
+
+  uint32_t totalRequests() const;
+
+  // Adds the counters to obj, requests as a nested object keyed by method
+  void toJson(JsonObject obj) const;
+  // Compact JSON of all counters, e.g. for a /stats command
+  String toJson() const;
+};
+
+/*
+   Print that forwards to the bot's client and counts what goes through, so
+   bytesOut needs no bookkeeping at the individual print calls.
+ */
+class TelegramCountingPrint : public Print {
+public:
+  TelegramCountingPrint(unsigned long long &counter) : target(nullptr), _counter(counter) {}
+
+  size_t write(uint8_t b) override;
+  size_t write(const uint8_t *buffer, size_t size) override;
+
+  using Print::write;
+
+  Print *target;
+
+private:
+  unsigned long long &_counter;
+};
+
+#endif
@@ -0,0 +1,135 @@
+/*
+Copyright (c) 2018 Brian Lough. All right reserved.
+
+UniversalTelegramBot - Library to create your own Telegram Bot using
+ESP8266 or ESP32 on Arduino IDE.
+
+This library is free software; you can redistribute it and/or
+modify it under the terms of the GNU Lesser General Public
+License as published by the Free Software Foundation; either
+version 2.1 of the License, or (at your option) any later version.
+
+This library is distributed in the hope that it will be useful,
+but WITHOUT ANY WARRANTY; without even the implied warranty of
+MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the GNU
+Lesser General Public License for more details.
+
+You should have received a copy of the GNU Lesser General Public
+License along with this library; if not, write to the Free Software
+Foundation, Inc., 51 Franklin St, Fifth Floor, Boston, MA 02110-1301 USA
+*/
+
+#include "TelegramTrace.h"
+
+static const char *const eventNames[TELEGRAM_EVENT_COUNT] = {
+  "connect",
+  "connect failed",
+  "close",
+  "request",
+  "upload",
+  "upload buffer",
+  "response",
+  "response incomplete",
+  "response truncated",
+  "empty response",
+  "parse failed",
+  "no result",
+  "updates",
+  "update skipped",
+  "api result",
+  "invalid argument",
+  "async queued",
+  "async full",
+  "async done"
+};
+
+TelegramTrace::TelegramTrace() : echo(nullptr) {
+  clear();
+}
+
+void TelegramTrace::record(uint8_t level, TelegramTraceEventId id, int32_t a, int32_t b, int32_t c) {
+  TELEGRAM_LOCK_SCOPE(_lock);
+  uint16_t slot = (_head + _count) % TELEGRAM_TRACE_EVENTS;
+  if (_count == TELEGRAM_TRACE_EVENTS) {
+    // Full, the oldest event makes room
+    _head = (_head + 1) % TELEGRAM_TRACE_EVENTS;
+    _dropped++;
+  } else {
+    _count++;
+  }
+
+  TelegramTraceEvent &event = _events[slot];
+  event.micros = micros();
+  event.id = id;
+  event.level = level;
+  event.a = a;
+  event.b = b;
+  event.c = c;
+
+  if (echo) printEvent(*echo, event);
+}
+
+bool TelegramTrace::next(TelegramTraceEvent &event) {
+  TELEGRAM_LOCK_SCOPE(_lock);
+  if (_count == 0) return false;
+  event = _events[_head];
+  _head = (_head + 1) % TELEGRAM_TRACE_EVENTS;
+  _count--;
+  return true;
+}
+
+bool TelegramTrace::printNext(Print &out) {
+  TelegramTraceEvent event;
+  if (!next(event)) return false;
+  printEvent(out, event);
+  return true;
+}
+
+int TelegramTrace::dump(Print &out) {
+  unsigned long dropped;
+  {
+    TELEGRAM_LOCK_SCOPE(_lock);
+    dropped = _dropped;
+    _dropped = 0;
+  }
+  if (dropped) {
+    out.print(F("[trace] "));
+    out.print(dropped);
+    out.println(F(" older events dropped"));
+  }
+  int printed = 0;
+  while (printNext(out)) printed++;
+  return printed;
+}
+
+void TelegramTrace::clear() {
+  TELEGRAM_LOCK_SCOPE(_lock);
+  _head = 0;
+  _count = 0;
+  _dropped = 0;
+}
+
+const char *TelegramTrace::eventName(uint8_t id) {
+  return id < TELEGRAM_EVENT_COUNT ? eventNames[id] : "?";
+}
+
+void TelegramTrace::printEvent(Print &out, const TelegramTraceEvent &event) {
+  static const char levels[] = "?EWID";
+
+  out.print('[');
+  out.print(event.micros / 1000000ul);
+  out.print('.');
+  unsigned long fraction = event.micros % 1000000ul;
+  for (unsigned long digit = 100000ul; digit > 1 && fraction < digit; digit /= 10) out.print('0');
+  out.print(fraction);
+  out.print(F("] "));
+  out.print(levels[event.level < sizeof(levels) - 1 ? event.level : 0]);
+  out.print(' ');
+  out.print(eventName(event.id));
+  out.print(' ');
+  out.print(event.a);
+  out.print(' ');
+  out.print(event.b);
+  out.print(' ');
+  out.println(event.c);
+}
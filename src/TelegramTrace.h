@@ -0,0 +1,155 @@
+/*
+Copyright (c) 2018 Brian Lough. All right reserved.
+
+UniversalTelegramBot - Library to create your own Telegram Bot using
+ESP8266 or ESP32 on Arduino IDE.
+
+This library is free software; you can redistribute it and/or
+modify it under the terms of the GNU Lesser General Public
+License as published by the Free Software Foundation; either
+version 2.1 of the License, or (at your option) any later version.
+
+This library is distributed in the hope that it will be useful,
+but WITHOUT ANY WARRANTY; without even the implied warranty of
+MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the GNU
+Lesser General Public License for more details.
+
+You should have received a copy of the GNU Lesser General Public
+License along with this library; if not, write to the Free Software
+Foundation, Inc., 51 Franklin St, Fifth Floor, Boston, MA 02110-1301 USA
+*/
+
+#ifndef TelegramTrace_h
+#define TelegramTrace_h
+
+#include <Arduino.h>
+#include <TelegramLock.h>
+
+/*
+   Structured tracing into a fixed RAM ring buffer.
+
+   Instead of printing payloads over Serial while a request is in progress,
+   the library records compact events (id, level, timestamp and up to three
+   integers) which cost a few hundred nanoseconds each. They can be dumped
+   afterwards or streamed one at a time from loop():
+
+     bot.trace.dump(Serial);               // everything recorded so far
+     bot.trace.printNext(Serial);          // oldest event, if any
+
+   TELEGRAM_TRACE_LEVEL selects what is compiled in: 0 (the default) removes
+   tracing completely, 1 errors, 2 warnings, 3 info and 4 debug. Defining
+   TELEGRAM_DEBUG selects level 4 and additionally echoes every event to
+   Serial as it is recorded. Like TELEGRAM_DEBUG, these have to be set in
+   UniversalTelegramBot.h or as build flags so the library sources see them.
+ */
+
+#define TELEGRAM_TRACE_LEVEL_ERROR 1
+#define TELEGRAM_TRACE_LEVEL_WARN 2
+#define TELEGRAM_TRACE_LEVEL_INFO 3
+#define TELEGRAM_TRACE_LEVEL_DEBUG 4
+
+#ifndef TELEGRAM_TRACE_LEVEL
+#ifdef TELEGRAM_DEBUG
+#define TELEGRAM_TRACE_LEVEL TELEGRAM_TRACE_LEVEL_DEBUG
+#else
+#define TELEGRAM_TRACE_LEVEL 0
+#endif
+#endif
+
+// Events kept in the ring buffer, 20 bytes each. The oldest are overwritten.
+#ifndef TELEGRAM_TRACE_EVENTS
+#define TELEGRAM_TRACE_EVENTS 64
+#endif
+
+// Trace macros for use inside UniversalTelegramBot. Arguments are not
+// evaluated for levels that are compiled out.
+#if TELEGRAM_TRACE_LEVEL >= TELEGRAM_TRACE_LEVEL_ERROR
+#define TELEGRAM_TRACE_ERROR(...) trace.record(TELEGRAM_TRACE_LEVEL_ERROR, __VA_ARGS__)
+#else
+#define TELEGRAM_TRACE_ERROR(...)
+#endif
+#if TELEGRAM_TRACE_LEVEL >= TELEGRAM_TRACE_LEVEL_WARN
+#define TELEGRAM_TRACE_WARN(...) trace.record(TELEGRAM_TRACE_LEVEL_WARN, __VA_ARGS__)
+#else
+#define TELEGRAM_TRACE_WARN(...)
+#endif
+#if TELEGRAM_TRACE_LEVEL >= TELEGRAM_TRACE_LEVEL_INFO
+#define TELEGRAM_TRACE_INFO(...) trace.record(TELEGRAM_TRACE_LEVEL_INFO, __VA_ARGS__)
+#else
+#define TELEGRAM_TRACE_INFO(...)
+#endif
+#if TELEGRAM_TRACE_LEVEL >= TELEGRAM_TRACE_LEVEL_DEBUG
+#define TELEGRAM_TRACE_DEBUG(...) trace.record(TELEGRAM_TRACE_LEVEL_DEBUG, __VA_ARGS__)
+#else
+#define TELEGRAM_TRACE_DEBUG(...)
+#endif
+
+// Event ids. The comments name the integer arguments a, b, c.
+enum TelegramTraceEventId {
+  TELEGRAM_EVENT_CONNECT,            // port
+  TELEGRAM_EVENT_CONNECT_FAILED,     // port
+  TELEGRAM_EVENT_CLOSE,
+  TELEGRAM_EVENT_REQUEST,            // method, command length, payload length
+  TELEGRAM_EVENT_UPLOAD,             // method, file size (-1 chunked)
+  TELEGRAM_EVENT_UPLOAD_BUFFER,      // bytes
+  TELEGRAM_EVENT_RESPONSE,           // status, body length, chunked
+  TELEGRAM_EVENT_RESPONSE_INCOMPLETE,// status, body length received
+  TELEGRAM_EVENT_RESPONSE_TRUNCATED, // body length, maxMessageLength
+  TELEGRAM_EVENT_EMPTY_RESPONSE,     // method
+  TELEGRAM_EVENT_PARSE_FAILED,       // DeserializationError code, response length, update id
+  TELEGRAM_EVENT_NO_RESULT,
+  TELEGRAM_EVENT_UPDATES,            // number of updates, offset
+  TELEGRAM_EVENT_UPDATE_SKIPPED,     // update id, response length
+  TELEGRAM_EVENT_API_RESULT,         // ok, error_code, message_id
+  TELEGRAM_EVENT_INVALID_ARGUMENT,   // method
+  TELEGRAM_EVENT_ASYNC_QUEUED,       // handle, method
+  TELEGRAM_EVENT_ASYNC_FULL,         // method
+  TELEGRAM_EVENT_ASYNC_DONE,         // handle, ok, error_code
+  TELEGRAM_EVENT_COUNT
+};
+
+struct TelegramTraceEvent {
+  uint32_t micros;
+  uint8_t id;
+  uint8_t level;
+  int32_t a;
+  int32_t b;
+  int32_t c;
+};
+
+class TelegramTrace {
+public:
+  TelegramTrace();
+
+  void record(uint8_t level, TelegramTraceEventId id, int32_t a = 0, int32_t b = 0, int32_t c = 0);
+
+  // Events waiting in the buffer
+  int available() const { return _count; }
+  // Events overwritten before they were read
+  unsigned long dropped() const { return _dropped; }
+
+  // Removes the oldest event into event. Returns false when empty.
+  bool next(TelegramTraceEvent &event);
+  // Prints and removes the oldest event. Returns false when empty.
+  bool printNext(Print &out);
+  // Prints and removes all events, returns how many were printed
+  int dump(Print &out);
+  void clear();
+
+  static void printEvent(Print &out, const TelegramTraceEvent &event);
+  static const char *eventName(uint8_t id);
+
+  // When set, every event is also printed here as it is recorded
+  Print *echo;
+
+private:
+  TelegramTraceEvent _events[TELEGRAM_TRACE_EVENTS];
+  uint16_t _head;
+  uint16_t _count;
+  unsigned long _dropped;
+#ifdef TELEGRAM_THREAD_SAFE
+  TelegramMutex _lock;
+#endif
+};
+
+#endif
@@ -31,20 +31,47 @@
    be closed manually after calling sendGetToTelegram or sendPostToTelegram by
    calling closeClient(); Failure to close connection causes memory leakage and
    SSL errors
+
+   With more than one client (see TelegramClientPool.h) closeClient() leaves
+   the outbound connections open on purpose, they are kept alive for the
+   next call.
  */
 
 #include "UniversalTelegramBot.h"
 
 #define ZERO_COPY(STR)    ((char*)STR.c_str())
 #define BOT_CMD(STR)      buildCommand(F(STR))
+#define MULTIPART_BOUNDARY "------------------------b8f610217e83e29b"
+
+#ifdef TELEGRAM_THREAD_SAFE
+#define TELEGRAM_CALL_SCOPE() CallScope callScope(*this)
+
+// Calls running on this thread, innermost first
+static thread_local TelegramCall *currentCall = nullptr;
+static thread_local TelegramResult threadLastResult;
+#else
+#define TELEGRAM_CALL_SCOPE()
+#endif
 
-UniversalTelegramBot::UniversalTelegramBot(const String& token, Client &client, int maxMessageLength) {
+UniversalTelegramBot::UniversalTelegramBot(const String& token, Client &client, int maxMessageLength)
+    : _call(stats.bytesOut) {
   updateToken(token);
-  this->client = &client;
+  setServer(TELEGRAM_HOST, TELEGRAM_SSL_PORT, true);
+  pool.add(&client);
+  _call.client = &client;
+#if defined(TELEGRAM_DEBUG) && TELEGRAM_TRACE_LEVEL > 0
+  trace.echo = &Serial;
+#endif
   this->maxMessageLength = maxMessageLength;
 }
 
 void UniversalTelegramBot::updateToken(const String& token) {
+  if (token != _token) {
+    // A prefetched answer would be the old token's updates, and the new
+    // token counts its update ids from somewhere else
+    dropPrefetch();
+    _seen.reset();
+  }
   _token = token;
 }
 
@@ -52,6 +79,249 @@ String UniversalTelegramBot::getToken() {
   return _token;
 }
 
+/***************************************************************
+ * SetServer - point the bot at another Bot API server, e.g. a  *
+ * self-hosted telegram-bot-api instance on the local network.  *
+ * secure only describes the scheme used for file URLs; the     *
+ * transport itself is whatever Client was passed in, so use a  *
+ * plain (non-TLS) client together with secure = false.         *
+ ***************************************************************/
+void UniversalTelegramBot::setServer(const String& host, int port, bool secure) {
+  // Kept-alive connections still lead to the old server
+  if (host != _host || port != _port) {
+    dropPrefetch();
+    pool.stopAll();
+  }
+  _host = host;
+  _port = port;
+  _secure = secure;
+}
+
+String UniversalTelegramBot::getServer() {
+  return _host;
+}
+
+bool UniversalTelegramBot::addClient(Client &client) {
+  return pool.add(&client) >= 0;
+}
+
+#ifdef TELEGRAM_THREAD_SAFE
+UniversalTelegramBot::CallScope::CallScope(UniversalTelegramBot &bot)
+    : _bot(bot), _nested(false) {
+  for (TelegramCall *c = currentCall; c; c = c->outer) {
+    if (c->owner == &bot) _nested = true;
+  }
+  if (_nested) return; // part of a public call already running
+
+  _call.owner = &bot;
+  _call.slot = -1;
+  _call.outer = currentCall;
+  currentCall = &_call;
+}
+
+UniversalTelegramBot::CallScope::~CallScope() {
+  if (_nested) return;
+
+  currentCall = _call.outer;
+  threadLastResult = _call.result;
+  _bot.pool.release(_call.slot);
+  TELEGRAM_LOCKED(_bot._statsLock, _bot.stats.bytesOut += _call.bytesOut);
+}
+#endif
+
+/***************************************************************
+ * Call - state of the call in progress, the calling task's    *
+ * own with TELEGRAM_THREAD_SAFE                               *
+ ***************************************************************/
+TelegramCall &UniversalTelegramBot::call() {
+#ifdef TELEGRAM_THREAD_SAFE
+  for (TelegramCall *c = currentCall; c; c = c->outer) {
+    if (c->owner == this) return *c;
+  }
+#endif
+  return _call;
+}
+
+const TelegramResult &UniversalTelegramBot::lastResult() {
+#ifdef TELEGRAM_THREAD_SAFE
+  return threadLastResult;
+#else
+  return _call.result;
+#endif
+}
+
+bool UniversalTelegramBot::connectClient() {
+  TelegramCall &c = call();
+  Client *client = c.client;
+  c.out.target = client;
+
+  // Connect with the Bot API server if not already connected
+  if (!client->connected()) {
+    TELEGRAM_LATENCY(mark());
+    if (!openConnection(client, c.slot)) {
+      TELEGRAM_LATENCY(end(false));
+      return false;
+    }
+    TELEGRAM_LATENCY(lap(TELEGRAM_PHASE_CONNECT));
+    sampleHeap();
+  }
+  return client->connected();
+}
+
+bool UniversalTelegramBot::openConnection(Client *client, int slot) {
+  TELEGRAM_TRACE_INFO(TELEGRAM_EVENT_CONNECT, _port);
+  if (!client->connect(_host.c_str(), _port)) {
+    TELEGRAM_TRACE_ERROR(TELEGRAM_EVENT_CONNECT_FAILED, _port);
+    TELEGRAM_LOCKED(_statsLock, stats.connectFailures++; stats.failedRequests++);
+    return false;
+  }
+  bool reconnect = pool.connected(slot);
+  TELEGRAM_LOCKED(_statsLock, {
+    stats.connects++;
+    if (_secure) stats.tlsHandshakes++;
+    if (reconnect) stats.reconnects++;
+  });
+  return true;
+}
+
+/***************************************************************
+ * RequestStarted - picks the connection for a request, counts *
+ * it and remembers the free heap at its start for the peak    *
+ * heap statistic                                              *
+ ***************************************************************/
+void UniversalTelegramBot::requestStarted(const String& command) {
+  TelegramMethod method = telegramMethodId(command.c_str());
+  TelegramCall &c = call();
+
+  // The previous request is over once the next one starts
+  pool.release(c.slot);
+  int slot = pool.acquire(method);
+  // An asynchronous request has the connection; it is finished first, its
+  // callback still runs from tick()
+  while (slot < 0) {
+    bool inFlight = pumpAsync(false);
+    slot = pool.acquire(method);
+    if (!inFlight) break;
+  }
+#ifdef TELEGRAM_THREAD_SAFE
+  // Every connection that could take it is busy with another task's call
+  while (slot < 0) {
+    delay(1);
+    pumpAsync(false);
+    slot = pool.acquire(method);
+  }
+#endif
+  if (slot >= 0) c.slot = slot;
+  c.client = pool.client(c.slot);
+  c.responseComplete = false;
+  c.result = TelegramResult();
+
+  TELEGRAM_LOCKED(_statsLock, stats.requests[method]++);
+  TelegramHeapSample sample;
+  c.heapAtStart = telegramHeapSample(sample) ? sample.freeHeap : 0;
+}
+
+void UniversalTelegramBot::sampleHeap() {
+  TelegramHeapSample sample;
+  if (!telegramHeapSample(sample)) return; // not known on this platform
+  uint32_t freeHeap = sample.freeHeap;
+  uint32_t heapAtStart = call().heapAtStart;
+
+  TELEGRAM_LOCKED(_statsLock, {
+    if (stats.minFreeHeap == 0 || freeHeap < stats.minFreeHeap) stats.minFreeHeap = freeHeap;
+    if (heapAtStart > freeHeap && heapAtStart - freeHeap > stats.peakHeapUsed) {
+      stats.peakHeapUsed = heapAtStart - freeHeap;
+    }
+  });
+}
+
+void UniversalTelegramBot::printHostHeader(Print &out) {
+  out.print(F("Host: "));
+  out.print(_host);
+  if (_port != (_secure ? TELEGRAM_SSL_PORT : TELEGRAM_PORT)) {
+    out.print(F(":"));
+    out.print(_port);
+  }
+  out.println();
+}
+
+void UniversalTelegramBot::printGetRequest(Print &out, const String& command) {
+  out.print(F("GET /"));
+  out.print(command);
+  out.println(F(" HTTP/1.1"));
+  printHostHeader(out);
+  out.println(F("Accept: application/json"));
+  out.println(F("Cache-Control: no-cache"));
+  out.println();
+}
+
+void UniversalTelegramBot::printPostRequest(Print &out, const String& command, const String& json) {
+  // POST URI
+  out.print(F("POST /"));
+  out.print(command);
+  out.println(F(" HTTP/1.1"));
+  // Host header
+  printHostHeader(out);
+  // JSON content type
+  out.println(F("Content-Type: application/json"));
+
+  // Content length
+  out.print(F("Content-Length:"));
+  out.println(json.length());
+  // End of headers
+  out.println();
+  // POST message body
+  out.println(json);
+}
+
+/***************************************************************
+ * PrintMultipartHead - request line and headers of an upload  *
+ * of command, as built by buildCommand. Sent chunked when     *
+ * contentLength is negative.                                  *
+ ***************************************************************/
+void UniversalTelegramBot::printMultipartHead(Print &out, const String& command, int contentLength) {
+  out.print(F("POST /"));
+  out.print(command);
+  out.println(F(" HTTP/1.1"));
+  // Host header
+  printHostHeader(out); // bugfix - https://github.com/witnessmenow/Universal-Arduino-Telegram-Bot/issues/186
+  out.println(F("User-Agent: arduino/1.0"));
+  out.println(F("Accept: */*"));
+
+  if (contentLength < 0) {
+    out.println(F("Transfer-Encoding: chunked"));
+  } else {
+    out.print(F("Content-Length: "));
+    out.println(String(contentLength));
+  }
+  out.print(F("Content-Type: multipart/form-data; boundary="));
+  out.println(F(MULTIPART_BOUNDARY));
+  out.println();
+}
+
+/***************************************************************
+ * MultipartParts - the form data in front of and behind the   *
+ * file of an upload                                           *
+ ***************************************************************/
+void UniversalTelegramBot::multipartParts(String &start, String &end,
+                                          const String& binaryPropertyName,
+                                          const String& fileName, const String& contentType,
+                                          const String& chat_id) {
+  start = F("--" MULTIPART_BOUNDARY);
+  start += F("\r\ncontent-disposition: form-data; name=\"chat_id\"\r\n\r\n");
+  start += chat_id;
+  start += F("\r\n" "--" MULTIPART_BOUNDARY);
+  start += F("\r\ncontent-disposition: form-data; name=\"");
+  start += binaryPropertyName;
+  start += F("\"; filename=\"");
+  start += fileName;
+  start += F("\"\r\n" "Content-Type: ");
+  start += contentType;
+  start += F("\r\n" "\r\n");
+
+  end = F("\r\n" "--" MULTIPART_BOUNDARY "--" "\r\n");
+}
+
 String UniversalTelegramBot::buildCommand(const String& cmd) {
   String command;
 
@@ -64,140 +334,110 @@ String UniversalTelegramBot::buildCommand(const String& cmd) {
 }
 
 String UniversalTelegramBot::sendGetToTelegram(const String& command) {
+  TELEGRAM_CALL_SCOPE();
+  TELEGRAM_HEAP_SCOPE("sendGetToTelegram");
   String body;
-  
-  // Connect with api.telegram.org if not already connected
-  if (!client->connected()) {
-    #ifdef TELEGRAM_DEBUG  
-        Serial.println(F("[BOT]Connecting to server"));
-    #endif
-    if (!client->connect(TELEGRAM_HOST, TELEGRAM_SSL_PORT)) {
-      #ifdef TELEGRAM_DEBUG  
-        Serial.println(F("[BOT]Connection error"));
-      #endif
-    }
-  }
-  if (client->connected()) {
+  TELEGRAM_LATENCY(begin(command));
+  if (sendGetRequest(command)) readHTTPAnswer(body);
 
-    #ifdef TELEGRAM_DEBUG  
-        Serial.println("sending: " + command);
-    #endif  
+  return body;
+}
 
-    client->print(F("GET /"));
-    client->print(command);
-    client->println(F(" HTTP/1.1"));
-    client->println(F("Host:" TELEGRAM_HOST));
-    client->println(F("Accept: application/json"));
-    client->println(F("Cache-Control: no-cache"));
-    client->println();
+/***************************************************************
+ * SendGetRequest - writes a GET request without waiting for   *
+ * the answer                                                  *
+ ***************************************************************/
+bool UniversalTelegramBot::sendGetRequest(const String& command) {
+  requestStarted(command);
+  if (!connectClient()) return false;
 
-    readHTTPAnswer(body);
-  }
+  TELEGRAM_TRACE_DEBUG(TELEGRAM_EVENT_REQUEST, telegramMethodId(command.c_str()), command.length());
 
-  return body;
+  printGetRequest(call().out, command);
+  TELEGRAM_LATENCY(lap(TELEGRAM_PHASE_SEND));
+  return true;
 }
 
 bool UniversalTelegramBot::readHTTPAnswer(String &body) {
-  int ch_count = 0;
+  TelegramCall &c = call();
+  Client *client = c.client;
   unsigned long now = millis();
-  bool finishedHeaders = false;
-  bool currentLineIsBlank = true;
-  bool responseReceived = false;
-  int toRead = 0;
-  String headers;
+  TelegramHttpResponse response;
+  response.begin(&body, maxMessageLength);
+
+  unsigned long received = 0;
 
   while (millis() - now < longPoll * 1000 + waitForResponse) {
     while (client->available()) {
-      char c = client->read();
-
-      if (!finishedHeaders) {
-        if (currentLineIsBlank && c == '\n') {
-          finishedHeaders = true;
-
-		  String headerLC = String(headers);
-          headerLC.toLowerCase();
-          int ind1 = headerLC.indexOf("content-length");
-          if (ind1 != -1) {
-            int ind2 = headerLC.indexOf("\r", ind1 + 15);
-            if (ind2 != -1) {
-              toRead = headerLC.substring(ind1 + 15, ind2).toInt();
-              headers = "";
-              #ifdef TELEGRAM_DEBUG
-                Serial.print(F("Content-Length: "));
-                Serial.println(toRead);
-              #endif
-            }
-          }
-        } else {
-          headers += c;
-        }
-      } else {
-        if (ch_count < maxMessageLength) {
-          body += c;
-          ch_count++;
-          responseReceived = toRead > 0 ? ch_count == toRead : true;
-        }
-      }
+      TELEGRAM_LATENCY(firstByte());
+      received++;
+      // The body is de-chunked as it is fed, so it lands in body ready for
+      // the JSON parser without a second pass
+      if (response.feed(client->read())) break;
+    }
 
-      if (c == '\n') currentLineIsBlank = true;
-      else if (c != '\r') currentLineIsBlank = false;
+    if (response.finished()) {
+      break;
     }
 
-    if (responseReceived) {
+    if (!client->connected() && !client->available()) {
+      // Server closed the connection, which ends a body sent without a length
+      response.closed();
       break;
     }
   }
 
-  #ifdef TELEGRAM_DEBUG
-    Serial.println(F("Body:"));
-    Serial.println(body);
-    Serial.print(F("ch_count: "));
-    Serial.println(ch_count);
-  #endif
+  if (response.finished()) {
+    TELEGRAM_LATENCY(lap(TELEGRAM_PHASE_BODY));
+  }
+  TELEGRAM_LATENCY(end(response.finished()));
+
+  responseReceived(response, received);
+  sampleHeap();
 
-  return responseReceived;
+  c.responseComplete = response.finished();
+  return response.finished();
+}
+
+/***************************************************************
+ * ResponseReceived - counts and traces the end of a response, *
+ * complete or not                                             *
+ ***************************************************************/
+void UniversalTelegramBot::responseReceived(const TelegramHttpResponse &response,
+                                            unsigned long received) {
+  TELEGRAM_LOCKED(_statsLock, {
+    stats.bytesIn += received;
+    if (!response.finished()) stats.failedRequests++;
+    if (response.truncated) stats.truncatedResponses++;
+    if (response.status == 429) stats.rateLimited++;
+    if (response.status == 409) stats.conflicts++;
+  });
+
+  TELEGRAM_TRACE_INFO(TELEGRAM_EVENT_RESPONSE, response.status, response.bodyLength, response.chunked);
+  if (!response.finished()) {
+    TELEGRAM_TRACE_WARN(TELEGRAM_EVENT_RESPONSE_INCOMPLETE, response.status, response.bodyLength);
+  }
+  if (response.truncated) {
+    TELEGRAM_TRACE_WARN(TELEGRAM_EVENT_RESPONSE_TRUNCATED, response.bodyLength, maxMessageLength);
+  }
 }
 
 String UniversalTelegramBot::sendPostToTelegram(const String& command, JsonObject payload) {
+  TELEGRAM_CALL_SCOPE();
+  TELEGRAM_HEAP_SCOPE("sendPostToTelegram");
 
   String body;
-
-  // Connect with api.telegram.org if not already connected
-  if (!client->connected()) {
-    #ifdef TELEGRAM_DEBUG  
-        Serial.println(F("[BOT Client]Connecting to server"));
-    #endif
-    if (!client->connect(TELEGRAM_HOST, TELEGRAM_SSL_PORT)) {
-      #ifdef TELEGRAM_DEBUG  
-        Serial.println(F("[BOT Client]Connection error"));
-      #endif
-    }
-  }
-  if (client->connected()) {
-    // POST URI
-    client->print(F("POST /"));
-    client->print(command);
-    client->println(F(" HTTP/1.1"));
-    // Host header
-    client->println(F("Host:" TELEGRAM_HOST));
-    // JSON content type
-    client->println(F("Content-Type: application/json"));
-
-    // Content length
-    int length = measureJson(payload);
-    client->print(F("Content-Length:"));
-    client->println(length);
-    // End of headers
-    client->println();
-    // POST message body
-    String out;
-    serializeJson(payload, out);
-    
-    client->println(out);
-    #ifdef TELEGRAM_DEBUG
-      Serial.print(F("Posting: "));
-      Serial.println(out);
-    #endif
+  // Serialized before a connection is taken, so other calls are not kept
+  // waiting for it
+  String json;
+  serializeJson(payload, json);
+  TELEGRAM_LATENCY(begin(command));
+  requestStarted(command);
+
+  if (connectClient()) {
+    printPostRequest(call().out, command, json);
+    TELEGRAM_LATENCY(lap(TELEGRAM_PHASE_SEND));
+    TELEGRAM_TRACE_DEBUG(TELEGRAM_EVENT_REQUEST, telegramMethodId(command.c_str()), command.length(), json.length());
 
     readHTTPAnswer(body);
   }
@@ -212,80 +452,36 @@ String UniversalTelegramBot::sendMultipartFormDataToTelegram(
     GetNextByte getNextByteCallback, 
     GetNextBuffer getNextBufferCallback,
     GetNextBufferLen getNextBufferLenCallback) {
+  TELEGRAM_CALL_SCOPE();
+  TELEGRAM_HEAP_SCOPE("sendMultipartFormDataToTelegram");
 
   String body;
   
-  const String boundary = F("------------------------b8f610217e83e29b");
+  TELEGRAM_LATENCY(begin(command));
+  requestStarted(command);
 
-  // Connect with api.telegram.org if not already connected
-  if (!client->connected()) {
-    #ifdef TELEGRAM_DEBUG  
-        Serial.println(F("[BOT Client]Connecting to server"));
-    #endif
-    if (!client->connect(TELEGRAM_HOST, TELEGRAM_SSL_PORT)) {
-      #ifdef TELEGRAM_DEBUG  
-        Serial.println(F("[BOT Client]Connection error"));
-      #endif
-    }
-  }
-  if (client->connected()) {
+  if (connectClient()) {
+    Print &out = call().out;
     String start_request;
     String end_request;
-    
+    multipartParts(start_request, end_request, binaryPropertyName, fileName, contentType, chat_id);
 
-    start_request += F("--");
-    start_request += boundary;
-    start_request += F("\r\ncontent-disposition: form-data; name=\"chat_id\"\r\n\r\n");
-    start_request += chat_id;
-    start_request += F("\r\n" "--");
-    start_request += boundary;
-    start_request += F("\r\ncontent-disposition: form-data; name=\"");
-    start_request += binaryPropertyName;
-    start_request += F("\"; filename=\"");
-    start_request += fileName;
-    start_request += F("\"\r\n" "Content-Type: ");
-    start_request += contentType;
-    start_request += F("\r\n" "\r\n");
-
-    end_request += F("\r\n" "--");
-    end_request += boundary;
-    end_request += F("--" "\r\n");
-
-    client->print(F("POST /"));
-    client->print(buildCommand(command));
-    client->println(F(" HTTP/1.1"));
-    // Host header
-    client->println(F("Host: " TELEGRAM_HOST)); // bugfix - https://github.com/witnessmenow/Universal-Arduino-Telegram-Bot/issues/186
-    client->println(F("User-Agent: arduino/1.0"));
-    client->println(F("Accept: */*"));
-
-    int contentLength = fileSize + start_request.length() + end_request.length();
-    #ifdef TELEGRAM_DEBUG  
-        Serial.println("Content-Length: " + String(contentLength));
-    #endif
-    client->print(F("Content-Length: "));
-    client->println(String(contentLength));
-    client->print(F("Content-Type: multipart/form-data; boundary="));
-    client->println(boundary);
-    client->println();
-    client->print(start_request);
-
-    #ifdef TELEGRAM_DEBUG  
-     Serial.print(F("Start request: "));
-     Serial.println(start_request);
-    #endif
+    // A negative fileSize means the total length is not known up front, so
+    // the body is streamed with Transfer-Encoding: chunked instead
+    bool chunked = fileSize < 0;
+    printMultipartHead(out, buildCommand(command),
+                       chunked ? -1 : fileSize + start_request.length() + end_request.length());
+    TELEGRAM_TRACE_DEBUG(TELEGRAM_EVENT_UPLOAD, telegramMethodId(command.c_str()), fileSize);
+    writeBody(out, (const uint8_t *)start_request.c_str(), start_request.length(), chunked);
 
     if (getNextByteCallback == nullptr) {
         while (moreDataAvailableCallback()) {
-            client->write((const uint8_t *)getNextBufferCallback(), getNextBufferLenCallback());
-            #ifdef TELEGRAM_DEBUG  
-             Serial.println(F("Sending photo from buffer"));
-            #endif
+            const uint8_t *buffer = (const uint8_t *)getNextBufferCallback();
+            int length = getNextBufferLenCallback();
+            writeBody(out, buffer, length, chunked);
+            TELEGRAM_TRACE_DEBUG(TELEGRAM_EVENT_UPLOAD_BUFFER, length);
             }
     } else {
-        #ifdef TELEGRAM_DEBUG  
-            Serial.println(F("Sending photo by binary"));
-        #endif
         byte buffer[512];
         int count = 0;
         while (moreDataAvailableCallback()) {
@@ -293,27 +489,24 @@ String UniversalTelegramBot::sendMultipartFormDataToTelegram(
             count++;
             if (count == 512) {
                 // yield();
-                #ifdef TELEGRAM_DEBUG  
-                    Serial.println(F("Sending binary photo full buffer"));
-                #endif
-                client->write((const uint8_t *)buffer, 512);
+                TELEGRAM_TRACE_DEBUG(TELEGRAM_EVENT_UPLOAD_BUFFER, 512);
+                writeBody(out, (const uint8_t *)buffer, 512, chunked);
                 count = 0;
             }
         }
         
         if (count > 0) {
-            #ifdef TELEGRAM_DEBUG  
-                Serial.println(F("Sending binary photo remaining buffer"));
-            #endif
-            client->write((const uint8_t *)buffer, count);
+            TELEGRAM_TRACE_DEBUG(TELEGRAM_EVENT_UPLOAD_BUFFER, count);
+            writeBody(out, (const uint8_t *)buffer, count, chunked);
         }
     }
 
-    client->print(end_request);
-    #ifdef TELEGRAM_DEBUG  
-      Serial.print(F("End request: "));
-      Serial.println(end_request);
-    #endif
+    writeBody(out, (const uint8_t *)end_request.c_str(), end_request.length(), chunked);
+    if (chunked) {
+      // Zero length chunk terminates the body
+      out.print(F("0\r\n\r\n"));
+    }
+    TELEGRAM_LATENCY(lap(TELEGRAM_PHASE_SEND));
     readHTTPAnswer(body);
   }
 
@@ -321,12 +514,33 @@ String UniversalTelegramBot::sendMultipartFormDataToTelegram(
   return body;
 }
 
+/***************************************************************
+ * WriteBody - writes a piece of a request body to the client, *
+ * framed as a single HTTP chunk when chunked is true          *
+ ***************************************************************/
+void UniversalTelegramBot::writeBody(Print &out, const uint8_t *data, size_t len, bool chunked) {
+  if (len == 0) return; // an empty chunk would end the body early
+
+  if (chunked) {
+    out.print(len, HEX);
+    out.print(F("\r\n"));
+  }
+  out.write(data, len);
+  if (chunked) {
+    out.print(F("\r\n"));
+  }
+}
 
 bool UniversalTelegramBot::getMe() {
+  TELEGRAM_CALL_SCOPE();
+  TELEGRAM_HEAP_SCOPE("getMe");
   String response = sendGetToTelegram(BOT_CMD("getMe")); // receive reply from telegram.org
   JsonDocument doc;
+  TELEGRAM_LATENCY(mark());
   DeserializationError error = deserializeJson(doc, ZERO_COPY(response));
+  TELEGRAM_LATENCY(parsed());
   closeClient();
+  if (error) TELEGRAM_LOCKED(_statsLock, stats.parseFailures++);
 
   if (!error) {
     if (doc.containsKey("result")) {
@@ -346,23 +560,19 @@ bool UniversalTelegramBot::getMe() {
  * Returns true, if the command list was updated successfully                    *
  ********************************************************************************/
 bool UniversalTelegramBot::setMyCommands(const String& commandArray) {
+  TELEGRAM_CALL_SCOPE();
+  TELEGRAM_HEAP_SCOPE("setMyCommands");
   JsonDocument payload;
   payload["commands"] = serialized(commandArray);
   bool sent = false;
   String response = "";
-  #ifdef TELEGRAM_DEBUG
-    Serial.println(F("sendSetMyCommands: SEND Post /setMyCommands"));
-  #endif
   unsigned long sttime = millis();
 
   while (millis() - sttime < 8000ul) { // loop for a while to send the message
     response = sendPostToTelegram(BOT_CMD("setMyCommands"), payload.as<JsonObject>());
-    #ifdef TELEGRAM_DEBUG
-      Serial.println(F("setMyCommands response:"));
-      Serial.println(response);
-    #endif
     sent = checkForOkResponse(response);
     if (sent) break;
+    TELEGRAM_LOCKED(_statsLock, stats.retries++);
   }
 
   closeClient();
@@ -376,106 +586,323 @@ bool UniversalTelegramBot::setMyCommands(const String& commandArray) {
  * Returns the number of new messages                          *
  ***************************************************************/
 int UniversalTelegramBot::getUpdates(long offset) {
-
-  #ifdef TELEGRAM_DEBUG  
-    Serial.println(F("GET Update Messages"));
-  #endif
-  String command = BOT_CMD("getUpdates?offset=");
-  command += offset;
-  command += F("&limit=");
-  command += HANDLE_MESSAGES;
-
-  if (longPoll > 0) {
-    command += F("&timeout=");
-    command += String(longPoll);
+  TELEGRAM_CALL_SCOPE();
+  TELEGRAM_HEAP_SCOPE("getUpdates");
+
+  long requested = offset;
+  int limit;
+  offset = pollOffset(offset, limit);
+  // Every update a poll could hand out waits for an ack
+  if (limit == 0) return 0;
+
+  String response;
+  if (_prefetchOffset != 0 && _prefetchOffset == requested) {
+    // Sent as the last batch came in, the answer may be here already
+    response = readPrefetched();
+  } else {
+    dropPrefetch();
+    acknowledge(offset);
+    response = sendGetToTelegram(updatesCommand(offset, limit)); // receive reply from telegram.org
   }
-  String response = sendGetToTelegram(command); // receive reply from telegram.org
-  long updateId = getUpdateIdFromResponse(response);
 
   if (response == "") {
-    #ifdef TELEGRAM_DEBUG  
-        Serial.println(F("Received empty string in response!"));
-    #endif
+    TELEGRAM_TRACE_WARN(TELEGRAM_EVENT_EMPTY_RESPONSE, TELEGRAM_GET_UPDATES);
+    polling.failed();
     // close the client as there's nothing to do with an empty string
     closeClient();
     return 0;
   } else {
-    #ifdef TELEGRAM_DEBUG  
-      Serial.print(F("incoming message length "));
-      Serial.println(response.length());
-      Serial.println(F("Creating DynamicJsonBuffer"));
-    #endif
-
-    // Parse response into Json object
-    JsonDocument doc;
-    DeserializationError error = deserializeJson(doc, ZERO_COPY(response));
-      
-    if (!error) {
-      #ifdef TELEGRAM_DEBUG  
-        Serial.print(F("GetUpdates parsed jsonObj: "));
-        serializeJson(doc, Serial);
-        Serial.println();
-      #endif
-      if (doc.containsKey("result")) {
-        int resultArrayLength = doc["result"].size();
-        if (resultArrayLength > 0) {
-          int newMessageIndex = 0;
-          // Step through all results
-          for (int i = 0; i < resultArrayLength; i++) {
-            JsonObject result = doc["result"][i];
-            if (processResult(result, newMessageIndex)) newMessageIndex++;
-          }
-          // We will keep the client open because there may be a response to be
-          // given
-          return newMessageIndex;
-        } else {
-          #ifdef TELEGRAM_DEBUG  
-            Serial.println(F("no new messages"));
-          #endif
-        }
-      } else {
-        #ifdef TELEGRAM_DEBUG  
-            Serial.println(F("Response contained no 'result'"));
-        #endif
-      }
-    } else { // Parsing failed
-      Serial.print(F("Update ID with error: "));
-      Serial.println(updateId);
-
-      if (response.length() < 2) { // Too short a message. Maybe a connection issue
-        #ifdef TELEGRAM_DEBUG  
-            Serial.println(F("Parsing error: Message too short"));
-        #endif
-      } else {
-        // Buffer may not be big enough, increase buffer or reduce max number of
-        // messages
-        #ifdef TELEGRAM_DEBUG 
-            Serial.print(F("Failed to parse update, the message could be too "
-                           "big for the buffer. Error code: "));
-            Serial.println(error.c_str()); // debug print of parsing error
-        #endif     
-      }
+    long skipTo = 0;
+    // The call's last request is a getFile once a document is processed
+    bool pollComplete = call().responseComplete;
+    int newMessages = readUpdates(response, offset, skipTo);
+    // We will keep the client open because there may be a response to be
+    // given
+    if (newMessages > 0) {
+      if (prefetchUpdates) prefetch(last_message_received + 1, pollComplete);
+      return newMessages;
     }
+
     // Close the client as no response is to be given
     closeClient();
 
-    if (error && response.length() == (unsigned) maxMessageLength) {
-        Serial.print(F("The message with update ID "));
-        Serial.print(updateId);
-        Serial.println(F(" is too long and was skipped. The next update ID has been sent for processing."));
-
-        return getUpdates(updateId + 1);
+    // The update is too long and is skipped, the next one is requested
+    if (skipTo > 0) {
+      // With manual acks the updates fetched again can be what made the
+      // answer too long; they are polled past once acknowledged
+      if (_manualAck && skipTo - 1 <= last_message_received) return 0;
+      skipped(skipTo - 1);
+      return getUpdates(skipTo);
     }
 
     return 0;
   }
 }
 
+/***************************************************************
+ * Prefetch - asks for the updates after a batch as soon as it *
+ * is parsed, so the answer travels while the sketch handles   *
+ * the batch. Needs a connection of its own for polling.       *
+ ***************************************************************/
+void UniversalTelegramBot::prefetch(long offset, bool pollComplete) {
+  if (pool.size() < 2) return;
+
+  long requested = offset;
+  int limit;
+  offset = pollOffset(offset, limit);
+  if (limit == 0) return;
+
+  // What is left of a poll answer cut short would be read as the next one
+  if (!pollComplete) closeConnection(pool.client(0), 0, false);
+
+  acknowledge(offset);
+  if (sendGetRequest(updatesCommand(offset, limit))) {
+    _prefetchOffset = requested;
+  } else {
+    closeClient();
+  }
+}
+
+String UniversalTelegramBot::readPrefetched() {
+  _prefetchOffset = 0;
+  String body;
+  TELEGRAM_LATENCY(begin(F("getUpdates")));
+
+  // Slot 0, which polls have to themselves while there are other clients;
+  // the request was counted when it was sent
+  TelegramCall &c = call();
+  pool.release(c.slot);
+  pool.acquire(TELEGRAM_GET_UPDATES);
+  c.slot = 0;
+  c.client = pool.client(0);
+  c.out.target = c.client;
+  c.responseComplete = false;
+  c.result = TelegramResult();
+
+  readHTTPAnswer(body);
+  return body;
+}
+
+/***************************************************************
+ * DropPrefetch - forgets a prefetched poll whose answer is no *
+ * longer wanted, closing the connection it is coming in on    *
+ ***************************************************************/
+void UniversalTelegramBot::dropPrefetch() {
+  if (_prefetchOffset == 0) return;
+  _prefetchOffset = 0;
+  closeConnection(pool.client(0), 0, false);
+}
+
+void UniversalTelegramBot::setManualAck(bool manual) {
+  TELEGRAM_LOCK_SCOPE(_ackLock);
+  _manualAck = manual;
+  _acks.reset(last_message_received);
+  _refetchedAt = -1;
+}
+
+bool UniversalTelegramBot::ack(long update_id) {
+  TELEGRAM_LOCK_SCOPE(_ackLock);
+  return _acks.ack(update_id);
+}
+
+int UniversalTelegramBot::unacked() {
+  TELEGRAM_LOCK_SCOPE(_ackLock);
+  return _acks.size();
+}
+
+bool UniversalTelegramBot::on(const char *command, TelegramCommandHandler handler) {
+  return _commands.add(command, handler);
+}
+
+/***************************************************************
+ * Dispatch - runs the handler registered for the command a    *
+ * message starts with                                         *
+ ***************************************************************/
+bool UniversalTelegramBot::dispatch(telegramMessage &message) {
+  TelegramCommandArgs args;
+  TelegramCommandHandler handler = _commands.route(ZERO_COPY(message.text), userName.c_str(), args);
+  if (!handler) return false;
+
+  handler(*this, message, args);
+  // Nothing is left to put back if the handler called args.release()
+  _commands.done(args);
+  return true;
+}
+
+/***************************************************************
+ * PollOffset - the offset and limit a poll asked to start at  *
+ * offset really uses. With manual acks it confirms no further *
+ * than the acknowledged updates and fetches the outstanding   *
+ * ones again on top of the new ones there is room for. A poll *
+ * that brought nothing but those, or an answer too long to    *
+ * read that starts with them, is not repeated until an ack    *
+ * confirms more: Telegram answers such an offset at once, so  *
+ * it would only spin fetching them again.                     *
+ ***************************************************************/
+long UniversalTelegramBot::pollOffset(long offset, int &limit) {
+  limit = HANDLE_MESSAGES;
+  if (!_manualAck) return offset;
+
+  TELEGRAM_LOCK_SCOPE(_ackLock);
+  int room = _acks.free() < HANDLE_MESSAGES ? _acks.free() : HANDLE_MESSAGES;
+  limit = room > 0 ? _acks.size() + room : 0;
+  if (_acks.size() > 0 && _acks.confirmed() == _refetchedAt) limit = 0;
+  return offset < _acks.confirmed() + 1 ? offset : _acks.confirmed() + 1;
+}
+
+/***************************************************************
+ * Skipped - an update too long to parse is handed out and     *
+ * acknowledged at once, or manual acks would wait for it      *
+ * forever                                                     *
+ ***************************************************************/
+void UniversalTelegramBot::skipped(long update_id) {
+  if (!_manualAck || update_id <= last_message_received) return;
+  last_message_received = update_id;
+  TELEGRAM_LOCK_SCOPE(_ackLock);
+  if (_acks.push(update_id)) _acks.ack(update_id);
+}
+
+void UniversalTelegramBot::setOffsetStore(TelegramOffsetStore *store, int saveEveryUpdates,
+                                          unsigned long saveEveryMs) {
+  _offsetStore = store;
+  _saveEveryUpdates = saveEveryUpdates;
+  _saveEveryMs = saveEveryMs;
+
+  long offset;
+  if (store && store->load(offset) && offset > last_message_received) {
+    last_message_received = offset;
+  }
+  _ackedOffset = _savedOffset = last_message_received;
+  _savedAt = millis();
+}
+
+bool UniversalTelegramBot::saveOffset() {
+  if (!_offsetStore || _ackedOffset == _savedOffset) return true;
+
+  bool saved = _offsetStore->save(_ackedOffset);
+  if (saved) {
+    _savedOffset = _ackedOffset;
+    TELEGRAM_LOCKED(_statsLock, stats.offsetSaves++);
+  }
+  // A failing store is tried again with the next batch, not every poll
+  _savedAt = millis();
+  return saved;
+}
+
+/***************************************************************
+ * Acknowledge - notes that a poll from offset confirms every  *
+ * update before it and saves that in batches                  *
+ ***************************************************************/
+void UniversalTelegramBot::acknowledge(long offset) {
+  if (!_offsetStore) return;
+  if (offset - 1 > _ackedOffset) _ackedOffset = offset - 1;
+  if (_ackedOffset == _savedOffset) return;
+
+  if (_ackedOffset - _savedOffset >= _saveEveryUpdates || millis() - _savedAt >= _saveEveryMs) {
+    saveOffset();
+  }
+}
+
+String UniversalTelegramBot::updatesCommand(long offset, int limit) {
+  String command = BOT_CMD("getUpdates?offset=");
+  command += offset;
+  command += F("&limit=");
+  command += limit;
+
+  int timeout = polling.started(limit, longPoll);
+  if (timeout > 0) {
+    command += F("&timeout=");
+    command += String(timeout);
+  }
+  return command;
+}
+
+/***************************************************************
+ * ParseUpdates - fills messages[] from the body of an answer  *
+ * to getUpdatesAsync(offset), returns the number of new ones. *
+ * An update too long to parse is skipped by moving            *
+ * last_message_received past it.                              *
+ ***************************************************************/
+int UniversalTelegramBot::parseUpdates(const String& response, long offset) {
+  long skipTo = 0;
+  int newMessages = readUpdates(response, offset, skipTo);
+  if (skipTo > 0 && skipTo - 1 > last_message_received) {
+    skipped(skipTo - 1);
+    last_message_received = skipTo - 1;
+  }
+  return newMessages;
+}
+
+/***************************************************************
+ * ReadUpdates - parses a getUpdates answer into messages[].   *
+ * Sets skipTo to the offset to ask for next when the update   *
+ * in it was too long for maxMessageLength.                    *
+ ***************************************************************/
+int UniversalTelegramBot::readUpdates(const String& response, long offset, long &skipTo) {
+  (void)offset; // only traced, unused when tracing is compiled out
+  if (response == "") return 0;
+  long updateId = getUpdateIdFromResponse(response);
+
+  // Parse response into Json object
+  JsonDocument doc;
+  TELEGRAM_LATENCY(mark());
+  DeserializationError error = deserializeJson(doc, ZERO_COPY(response));
+  TELEGRAM_LATENCY(parsed());
+    
+  if (!error) {
+    if (doc.containsKey("result")) {
+      int resultArrayLength = doc["result"].size();
+      TELEGRAM_TRACE_INFO(TELEGRAM_EVENT_UPDATES, resultArrayLength, offset);
+      int newMessageIndex = 0;
+      // Step through all results
+      for (int i = 0; i < resultArrayLength; i++) {
+        JsonObject result = doc["result"][i];
+        if (processResult(result, newMessageIndex)) newMessageIndex++;
+      }
+      if (_manualAck) {
+        TELEGRAM_LOCK_SCOPE(_ackLock);
+        bool refetchedOnly = resultArrayLength > 0 && newMessageIndex == 0 && _acks.size() > 0;
+        _refetchedAt = refetchedOnly ? _acks.confirmed() : -1;
+      }
+      // Updates fetched again while waiting for their ack are no traffic,
+      // but they do take up the batch
+      polling.received(newMessageIndex, resultArrayLength > 0 && resultArrayLength >= polling.limit());
+      return newMessageIndex;
+    } else {
+      TELEGRAM_TRACE_WARN(TELEGRAM_EVENT_NO_RESULT);
+      polling.failed();
+    }
+  } else { // Parsing failed
+    TELEGRAM_LOCKED(_statsLock, stats.parseFailures++);
+    // A very short response points at a connection issue, one of
+    // maxMessageLength at an update too big for the buffer
+    TELEGRAM_TRACE_ERROR(TELEGRAM_EVENT_PARSE_FAILED, error.code(), response.length(), updateId);
+
+    if (response.length() == (unsigned) maxMessageLength) {
+      TELEGRAM_TRACE_WARN(TELEGRAM_EVENT_UPDATE_SKIPPED, updateId, response.length());
+      skipTo = updateId + 1;
+      if (_manualAck) {
+        // An answer led by an outstanding update is given up on until an
+        // ack confirms more, or the same one would be fetched every poll
+        TELEGRAM_LOCK_SCOPE(_ackLock);
+        bool outstanding = _acks.size() > 0 && updateId <= last_message_received;
+        _refetchedAt = outstanding ? _acks.confirmed() : -1;
+      }
+      polling.received(0, true);
+    } else {
+      polling.failed();
+    }
+  }
+  return 0;
+}
+
 bool UniversalTelegramBot::processResult(JsonObject result, int messageIndex) {
   long update_id = result["update_id"];
-  // Check have we already dealt with this message (this shouldn't happen!)
-  if (last_message_received != update_id) {
-    last_message_received = update_id;
+  // Skip what was handed out before: delivered again after a retry or a
+  // reconnect, or fetched again while waiting for its ack
+  if (_seen.add(update_id)) {
+    if (update_id > last_message_received) last_message_received = update_id;
+    if (_manualAck) TELEGRAM_LOCKED(_ackLock, _acks.push(update_id));
     messages[messageIndex].update_id = update_id;
     messages[messageIndex].text = F("");
     messages[messageIndex].from_id = F("");
@@ -566,6 +993,7 @@ bool UniversalTelegramBot::processResult(JsonObject result, int messageIndex) {
     }
     return true;
   }
+  TELEGRAM_LOCKED(_statsLock, stats.duplicateUpdates++);
   return false;
 }
 
@@ -575,11 +1003,10 @@ bool UniversalTelegramBot::processResult(JsonObject result, int messageIndex) {
  ***********************************************************************/
 bool UniversalTelegramBot::sendSimpleMessage(const String& chat_id, const String& text,
                                              const String& parse_mode) {
+  TELEGRAM_CALL_SCOPE();
+  TELEGRAM_HEAP_SCOPE("sendSimpleMessage");
 
   bool sent = false;
-  #ifdef TELEGRAM_DEBUG  
-    Serial.println(F("sendSimpleMessage: SEND Simple Message"));
-  #endif
   unsigned long sttime = millis();
 
   if (text != "") {
@@ -591,11 +1018,9 @@ bool UniversalTelegramBot::sendSimpleMessage(const String& chat_id, const String
       command += F("&parse_mode=");
       command += parse_mode;
       String response = sendGetToTelegram(command);
-      #ifdef TELEGRAM_DEBUG  
-        Serial.println(response);
-      #endif
       sent = checkForOkResponse(response);
       if (sent) break;
+      TELEGRAM_LOCKED(_statsLock, stats.retries++);
     }
   }
   closeClient();
@@ -605,6 +1030,8 @@ bool UniversalTelegramBot::sendSimpleMessage(const String& chat_id, const String
 bool UniversalTelegramBot::sendMessage(const String& chat_id, const String& text,
                                        const String& parse_mode, int message_id, bool disable_web_page_preview,
                                        bool disable_notification) {
+  TELEGRAM_CALL_SCOPE();
+  TELEGRAM_HEAP_SCOPE("sendMessage");
 
   JsonDocument payload;
   payload["chat_id"] = chat_id;
@@ -631,11 +1058,11 @@ bool UniversalTelegramBot::sendMessage(const String& chat_id, const String& text
  * https://core.telegram.org/bots/api#deletemessage                    *
  ***********************************************************************/
 bool UniversalTelegramBot::deleteMessage(const String& chat_id, int message_id) {
+  TELEGRAM_CALL_SCOPE();
+  TELEGRAM_HEAP_SCOPE("deleteMessage");
   if (message_id == 0)
   {
-    #ifdef TELEGRAM_DEBUG
-	  Serial.println(F("deleteMessage: message_id not passed for deletion"));
-	#endif
+    TELEGRAM_TRACE_WARN(TELEGRAM_EVENT_INVALID_ARGUMENT, TELEGRAM_DELETE_MESSAGE);
     return false;
   }
 
@@ -643,17 +1070,7 @@ bool UniversalTelegramBot::deleteMessage(const String& chat_id, int message_id)
   payload["chat_id"] = chat_id;
   payload["message_id"] = message_id;
 
-  #ifdef TELEGRAM_DEBUG
-    Serial.print(F("deleteMessage: SEND Post Message: "));
-    serializeJson(payload, Serial);
-    Serial.println();
-  #endif
-
   String response = sendPostToTelegram(BOT_CMD("deleteMessage"), payload.as<JsonObject>());
-  #ifdef TELEGRAM_DEBUG
-     Serial.print(F("deleteMessage response:"));
-     Serial.println(response);
-  #endif
 
   bool sent = checkForOkResponse(response);
   closeClient();
@@ -663,6 +1080,8 @@ bool UniversalTelegramBot::deleteMessage(const String& chat_id, int message_id)
 bool UniversalTelegramBot::sendMessageWithReplyKeyboard(
     const String& chat_id, const String& text, const String& parse_mode, const String& keyboard,
     bool resize, bool oneTime, bool selective) {
+  TELEGRAM_CALL_SCOPE();
+  TELEGRAM_HEAP_SCOPE("sendMessageWithReplyKeyboard");
     
   JsonDocument payload;
   payload["chat_id"] = chat_id;
@@ -697,6 +1116,8 @@ bool UniversalTelegramBot::sendMessageWithInlineKeyboard(const String& chat_id,
                                                          const String& parse_mode,
                                                          const String& keyboard,
                                                          int message_id) {
+  TELEGRAM_CALL_SCOPE();
+  TELEGRAM_HEAP_SCOPE("sendMessageWithInlineKeyboard");
 
   JsonDocument payload;
   payload["chat_id"] = chat_id;
@@ -718,23 +1139,18 @@ bool UniversalTelegramBot::sendMessageWithInlineKeyboard(const String& chat_id,
  * (Arguments to pass: chat_id, text to transmit and markup(optional)) *
  ***********************************************************************/
 bool UniversalTelegramBot::sendPostMessage(JsonObject payload, bool edit) { // added message_id
+  TELEGRAM_CALL_SCOPE();
+  TELEGRAM_HEAP_SCOPE("sendPostMessage");
 
   bool sent = false;
-  #ifdef TELEGRAM_DEBUG 
-    Serial.print(F("sendPostMessage: SEND Post Message: "));
-    serializeJson(payload, Serial);
-    Serial.println();
-  #endif 
   unsigned long sttime = millis();
 
   if (payload.containsKey("text")) {
     while (millis() < sttime + 8000) { // loop for a while to send the message
         String response = sendPostToTelegram((edit ? BOT_CMD("editMessageText") : BOT_CMD("sendMessage")), payload); // if edit is true we send a editMessageText CMD
-         #ifdef TELEGRAM_DEBUG  
-        Serial.println(response);
-      #endif
       sent = checkForOkResponse(response);
       if (sent) break;
+      TELEGRAM_LOCKED(_statsLock, stats.retries++);
     }
   }
 
@@ -743,22 +1159,19 @@ bool UniversalTelegramBot::sendPostMessage(JsonObject payload, bool edit) { // a
 }
 
 String UniversalTelegramBot::sendPostPhoto(JsonObject payload) {
+  TELEGRAM_CALL_SCOPE();
+  TELEGRAM_HEAP_SCOPE("sendPostPhoto");
 
   bool sent = false;
   String response = "";
-  #ifdef TELEGRAM_DEBUG  
-    Serial.println(F("sendPostPhoto: SEND Post Photo"));
-  #endif
   unsigned long sttime = millis();
 
   if (payload.containsKey("photo")) {
     while (millis() - sttime < 8000ul) { // loop for a while to send the message
       response = sendPostToTelegram(BOT_CMD("sendPhoto"), payload);
-      #ifdef TELEGRAM_DEBUG  
-        Serial.println(response);
-      #endif
       sent = checkForOkResponse(response);
       if (sent) break;
+      TELEGRAM_LOCKED(_statsLock, stats.retries++);
       
     }
   }
@@ -771,19 +1184,13 @@ String UniversalTelegramBot::sendPhotoByBinary(
     const String& chat_id, const String& contentType, int fileSize,
     MoreDataAvailable moreDataAvailableCallback,
     GetNextByte getNextByteCallback, GetNextBuffer getNextBufferCallback, GetNextBufferLen getNextBufferLenCallback) {
-
-  #ifdef TELEGRAM_DEBUG  
-    Serial.println(F("sendPhotoByBinary: SEND Photo"));
-  #endif
+  TELEGRAM_CALL_SCOPE();
+  TELEGRAM_HEAP_SCOPE("sendPhotoByBinary");
 
   String response = sendMultipartFormDataToTelegram("sendPhoto", "photo", "img.jpg",
     contentType, chat_id, fileSize,
     moreDataAvailableCallback, getNextByteCallback, getNextBufferCallback, getNextBufferLenCallback);
 
-  #ifdef TELEGRAM_DEBUG  
-    Serial.println(response);
-  #endif
-
   return response;
 }
 
@@ -792,6 +1199,8 @@ String UniversalTelegramBot::sendPhoto(const String& chat_id, const String& phot
                                        bool disable_notification,
                                        int reply_to_message_id,
                                        const String& keyboard) {
+  TELEGRAM_CALL_SCOPE();
+  TELEGRAM_HEAP_SCOPE("sendPhoto");
 
   JsonDocument payload;
   payload["chat_id"] = chat_id;
@@ -815,23 +1224,41 @@ String UniversalTelegramBot::sendPhoto(const String& chat_id, const String& phot
 }
 
 bool UniversalTelegramBot::checkForOkResponse(const String& response) {
+  TELEGRAM_LATENCY(mark());
+  bool ok = parseResult(response, call().result);
+  TELEGRAM_LATENCY(parsed());
+  return ok;
+}
+
+/***************************************************************
+ * ParseResult - reads ok, error_code and message_id from an   *
+ * answer into result, returns ok                              *
+ ***************************************************************/
+bool UniversalTelegramBot::parseResult(const String& response, TelegramResult &result) {
   int last_id;
   JsonDocument doc;
-  deserializeJson(doc, response);
+  // An empty response already counts as a failed request
+  if (deserializeJson(doc, response) && response.length() > 0) {
+    TELEGRAM_LOCKED(_statsLock, stats.parseFailures++);
+  }
 
   // Save last sent message_id
   last_id = doc["result"]["message_id"];
-  if (last_id > 0) last_sent_message_id = last_id;
-
-  return doc["ok"] | false;  // default is false, but this is more explicit and clear
+  if (last_id > 0) TELEGRAM_LOCKED(_statsLock, last_sent_message_id = last_id);
+
+  bool ok = doc["ok"] | false;  // default is false, but this is more explicit and clear
+  result.ok = ok;
+  result.errorCode = doc["error_code"] | 0;
+  result.messageId = last_id > 0 ? last_id : 0;
+  TELEGRAM_TRACE_INFO(TELEGRAM_EVENT_API_RESULT, ok, doc["error_code"] | 0, last_id);
+  return ok;
 }
 
 bool UniversalTelegramBot::sendChatAction(const String& chat_id, const String& text) {
+  TELEGRAM_CALL_SCOPE();
+  TELEGRAM_HEAP_SCOPE("sendChatAction");
 
   bool sent = false;
-  #ifdef TELEGRAM_DEBUG  
-    Serial.println(F("SEND Chat Action Message"));
-  #endif
   unsigned long sttime = millis();
 
   if (text != "") {
@@ -843,12 +1270,10 @@ bool UniversalTelegramBot::sendChatAction(const String& chat_id, const String& t
 
       String response = sendGetToTelegram(command);
 
-      #ifdef TELEGRAM_DEBUG  
-        Serial.println(response);
-      #endif
       sent = checkForOkResponse(response);
 
       if (sent) break;
+      TELEGRAM_LOCKED(_statsLock, stats.retries++);
       
     }
   }
@@ -858,10 +1283,20 @@ bool UniversalTelegramBot::sendChatAction(const String& chat_id, const String& t
 }
 
 void UniversalTelegramBot::closeClient() {
+  TelegramCall &c = call();
+  if (!c.client) return; // no request made in this call
+
+  closeConnection(c.client, c.slot, c.responseComplete);
+}
+
+void UniversalTelegramBot::closeConnection(Client *client, int slot, bool responseComplete) {
+  // A pooled outbound connection is kept for the next call, unless a
+  // response was cut short and may have left bytes behind
+  if (pool.keepOpen(slot) && responseComplete) return;
+
   if (client->connected()) {
-    #ifdef TELEGRAM_DEBUG  
-        Serial.println(F("Closing client"));
-    #endif
+    pool.closedOnPurpose(slot);
+    TELEGRAM_TRACE_DEBUG(TELEGRAM_EVENT_CLOSE);
     client->stop();
   }
 }
@@ -872,13 +1307,29 @@ bool UniversalTelegramBot::getFile(String& file_path, long& file_size, const Str
   command += file_id;
   String response = sendGetToTelegram(command); // receive reply from telegram.org
   JsonDocument doc;
+  TELEGRAM_LATENCY(mark());
   DeserializationError error = deserializeJson(doc, ZERO_COPY(response));
+  TELEGRAM_LATENCY(parsed());
   closeClient();
+  if (error) TELEGRAM_LOCKED(_statsLock, stats.parseFailures++);
 
   if (!error) {
     if (doc.containsKey("result")) {
-      file_path  = F("https://api.telegram.org/file/");
-      file_path += buildCommand(doc["result"]["file_path"]);
+      String path = doc["result"]["file_path"].as<String>();
+      if (path.startsWith("/")) {
+        // A server running with --local hands out absolute paths on its own
+        // disk instead of something downloadable through /file/
+        file_path = path;
+      } else {
+        file_path  = _secure ? F("https://") : F("http://");
+        file_path += _host;
+        if (_port != (_secure ? TELEGRAM_SSL_PORT : TELEGRAM_PORT)) {
+          file_path += F(":");
+          file_path += _port;
+        }
+        file_path += F("/file/");
+        file_path += buildCommand(path);
+      }
       file_size = doc["result"]["file_size"].as<long>();
       return true;
     }
@@ -887,6 +1338,8 @@ bool UniversalTelegramBot::getFile(String& file_path, long& file_size, const Str
 }
 
 bool UniversalTelegramBot::answerCallbackQuery(const String &query_id, const String &text, bool show_alert, const String &url, int cache_time) {
+  TELEGRAM_CALL_SCOPE();
+  TELEGRAM_HEAP_SCOPE("answerCallbackQuery");
   JsonDocument payload;
 
   payload["callback_query_id"] = query_id;
@@ -897,10 +1350,6 @@ bool UniversalTelegramBot::answerCallbackQuery(const String &query_id, const Str
   if (url.length() > 0) payload["url"] = url;
 
   String response = sendPostToTelegram(BOT_CMD("answerCallbackQuery"), payload.as<JsonObject>());
-  #ifdef TELEGRAM_DEBUG
-     Serial.print(F("answerCallbackQuery response:"));
-     Serial.println(response);
-  #endif
   bool answer = checkForOkResponse(response);
   closeClient();
   return answer;
@@ -930,4 +1379,345 @@ long UniversalTelegramBot::getUpdateIdFromResponse(String response) {
   }
 
   return atol(updateId);
-}
\ No newline at end of file
+}
+/***************************************************************
+ * Asynchronous calls, see TelegramAsync.h                     *
+ ***************************************************************/
+TelegramAsyncHandle UniversalTelegramBot::getUpdatesAsync(long offset, TelegramAsyncDone onDone) {
+  // It would be read on the same connection
+  dropPrefetch();
+  TELEGRAM_HEAP_SCOPE("getUpdatesAsync");
+  int limit;
+  offset = pollOffset(offset, limit);
+  if (limit == 0) return 0;
+  acknowledge(offset);
+  String command = updatesCommand(offset, limit);
+  TELEGRAM_LOCK_SCOPE(_asyncLock);
+  return queued(queueAsync(command, onDone));
+}
+
+TelegramAsyncHandle UniversalTelegramBot::sendPostToTelegramAsync(const String& command,
+                                                                  JsonObject payload,
+                                                                  TelegramAsyncDone onDone) {
+  TELEGRAM_HEAP_SCOPE("sendPostToTelegramAsync");
+  TELEGRAM_LOCK_SCOPE(_asyncLock);
+  TelegramAsyncRequest *request = queueAsync(command, onDone);
+  if (request) serializeJson(payload, request->payload);
+  return queued(request);
+}
+
+TelegramAsyncHandle UniversalTelegramBot::sendMessageAsync(const String& chat_id, const String& text,
+                                                           TelegramAsyncDone onDone,
+                                                           const String& parse_mode) {
+  TELEGRAM_HEAP_SCOPE("sendMessageAsync");
+  if (text == "") {
+    TELEGRAM_TRACE_WARN(TELEGRAM_EVENT_INVALID_ARGUMENT, TELEGRAM_SEND_MESSAGE);
+    return 0;
+  }
+
+  JsonDocument payload;
+  payload["chat_id"] = chat_id;
+  payload["text"] = text;
+  if (parse_mode != "")
+    payload["parse_mode"] = parse_mode;
+
+  TELEGRAM_LOCK_SCOPE(_asyncLock);
+  TelegramAsyncRequest *request = queueAsync(BOT_CMD("sendMessage"), onDone);
+  if (request) {
+    serializeJson(payload, request->payload);
+    request->retry = true; // like sendMessage
+  }
+  return queued(request);
+}
+
+TelegramAsyncHandle UniversalTelegramBot::answerCallbackQueryAsync(const String &query_id,
+                                                                   const String &text,
+                                                                   TelegramAsyncDone onDone) {
+  TELEGRAM_HEAP_SCOPE("answerCallbackQueryAsync");
+  JsonDocument payload;
+  payload["callback_query_id"] = query_id;
+  if (text.length() > 0) payload["text"] = text;
+
+  return sendPostToTelegramAsync(BOT_CMD("answerCallbackQuery"), payload.as<JsonObject>(), onDone);
+}
+
+TelegramAsyncHandle UniversalTelegramBot::sendPhotoByBinaryAsync(
+    const String& chat_id, const String& contentType, int fileSize,
+    MoreDataAvailable moreDataAvailableCallback,
+    GetNextByte getNextByteCallback, GetNextBuffer getNextBufferCallback,
+    GetNextBufferLen getNextBufferLenCallback, TelegramAsyncDone onDone) {
+  TELEGRAM_HEAP_SCOPE("sendPhotoByBinaryAsync");
+  TELEGRAM_LOCK_SCOPE(_asyncLock);
+  // Built now, so the upload goes out as the token it was queued with
+  TelegramAsyncRequest *request = queueAsync(BOT_CMD("sendPhoto"), onDone);
+  if (request) {
+    multipartParts(request->payload, request->tail, F("photo"), F("img.jpg"), contentType, chat_id);
+    request->fileSize = fileSize;
+    request->moreDataAvailable = moreDataAvailableCallback;
+    request->getNextByte = getNextByteCallback;
+    request->getNextBuffer = getNextBufferCallback;
+    request->getNextBufferLen = getNextBufferLenCallback;
+  }
+  return queued(request);
+}
+
+/***************************************************************
+ * QueueAsync - a free request for command, nullptr when all   *
+ * TELEGRAM_MAX_ASYNC are taken. Called with _asyncLock held.  *
+ ***************************************************************/
+TelegramAsyncRequest *UniversalTelegramBot::queueAsync(const String& command, TelegramAsyncDone onDone) {
+  for (int i = 0; i < TELEGRAM_MAX_ASYNC; i++) {
+    TelegramAsyncRequest &request = _async[i];
+    if (request.state != TelegramAsyncRequest::IDLE) continue;
+
+    if (++_lastHandle == 0) _lastHandle = 1;
+    request.handle = _lastHandle;
+    request.method = telegramMethodId(command.c_str());
+    request.retry = false;
+    request.onDone = onDone;
+    request.command = command;
+    request.payload = "";
+    request.tail = "";
+    request.fileSize = 0;
+    request.moreDataAvailable = nullptr;
+    request.started = millis();
+    request.result = TelegramResult();
+    return &request;
+  }
+  TELEGRAM_TRACE_WARN(TELEGRAM_EVENT_ASYNC_FULL, telegramMethodId(command.c_str()));
+  return nullptr;
+}
+
+TelegramAsyncHandle UniversalTelegramBot::queued(TelegramAsyncRequest *request) {
+  if (!request) return 0;
+  request->state = TelegramAsyncRequest::QUEUED;
+  TELEGRAM_TRACE_DEBUG(TELEGRAM_EVENT_ASYNC_QUEUED, request->handle, request->method);
+  return request->handle;
+}
+
+int UniversalTelegramBot::tick() {
+  TELEGRAM_HEAP_SCOPE("tick");
+#ifndef TELEGRAM_THREAD_SAFE
+  // No blocking call is running, so the connection the last one used is
+  // free for asynchronous requests
+  pool.release(_call.slot);
+  _call.slot = -1;
+  _call.client = nullptr;
+#endif
+  pumpAsync(true);
+
+  // Callbacks run with the request already freed and outside the lock, so
+  // they can queue the next call
+  int pending = 0;
+  for (int i = 0; i < TELEGRAM_MAX_ASYNC; i++) {
+    TelegramAsyncDone onDone;
+    TelegramAsyncHandle handle;
+    TelegramResult result;
+    String body;
+    {
+      TELEGRAM_LOCK_SCOPE(_asyncLock);
+      TelegramAsyncRequest &request = _async[i];
+      if (request.state != TelegramAsyncRequest::DONE) {
+        if (request.state != TelegramAsyncRequest::IDLE) pending++;
+        continue;
+      }
+      onDone = request.onDone;
+      handle = request.handle;
+      result = request.result;
+      body = request.body;
+      request.body = "";
+      request.payload = "";
+      request.state = TelegramAsyncRequest::IDLE;
+    }
+    if (onDone) onDone(handle, result, body);
+  }
+  return pending;
+}
+
+bool UniversalTelegramBot::pending(TelegramAsyncHandle handle) {
+  TELEGRAM_LOCK_SCOPE(_asyncLock);
+  for (int i = 0; i < TELEGRAM_MAX_ASYNC; i++) {
+    if (_async[i].handle == handle && _async[i].state != TelegramAsyncRequest::IDLE) return true;
+  }
+  return false;
+}
+
+bool UniversalTelegramBot::sending() {
+  TELEGRAM_LOCK_SCOPE(_asyncLock);
+  for (int i = 0; i < TELEGRAM_MAX_ASYNC; i++) {
+    const TelegramAsyncRequest &request = _async[i];
+    if (request.state == TelegramAsyncRequest::UPLOADING) return true;
+    if (request.state == TelegramAsyncRequest::QUEUED && pool.available(request.method)) return true;
+  }
+  return false;
+}
+
+/***************************************************************
+ * PumpAsync - does what I/O the asynchronous requests can do  *
+ * without waiting, starting queued ones if start is set.      *
+ * Returns whether any of them holds a connection.             *
+ ***************************************************************/
+bool UniversalTelegramBot::pumpAsync(bool start) {
+  TELEGRAM_LOCK_SCOPE(_asyncLock);
+
+  // Oldest first, so messages to a chat keep their order. Bounded, as a
+  // request whose connect failed goes back to the queue.
+  for (int n = 0; start && n < TELEGRAM_MAX_ASYNC; n++) {
+    TelegramAsyncRequest *next = nullptr;
+    for (int i = 0; i < TELEGRAM_MAX_ASYNC; i++) {
+      TelegramAsyncRequest &request = _async[i];
+      if (request.state == TelegramAsyncRequest::QUEUED &&
+          (!next || (uint16_t)(request.handle - next->handle) > 0x8000)) {
+        next = &request;
+      }
+    }
+    if (!next || !startAsync(*next)) break;
+  }
+
+  bool inFlight = false;
+  for (int i = 0; i < TELEGRAM_MAX_ASYNC; i++) {
+    TelegramAsyncRequest &request = _async[i];
+    if (request.state == TelegramAsyncRequest::UPLOADING) uploadAsync(request);
+    if (request.state == TelegramAsyncRequest::READING) readAsync(request);
+    if (request.inFlight()) inFlight = true;
+  }
+  return inFlight;
+}
+
+/***************************************************************
+ * StartAsync - takes a connection for a queued request and    *
+ * writes it out. False when no connection is free.            *
+ ***************************************************************/
+bool UniversalTelegramBot::startAsync(TelegramAsyncRequest &request) {
+  int slot = pool.acquire(request.method);
+  if (slot < 0) return false;
+
+  Client *client = pool.client(slot);
+  request.slot = slot;
+  request.out.target = client;
+  TELEGRAM_LOCKED(_statsLock, stats.requests[request.method]++);
+
+  if (!client->connected() && !openConnection(client, slot)) {
+    pool.release(slot);
+    request.slot = -1;
+    request.result = TelegramResult();
+    finishAsync(request, false);
+    return true;
+  }
+
+  request.body = "";
+  request.response.begin(&request.body, maxMessageLength);
+  request.received = 0;
+
+  if (request.moreDataAvailable) {
+    int contentLength = -1;
+    if (request.fileSize >= 0) {
+      contentLength = request.fileSize + request.payload.length() + request.tail.length();
+    }
+    printMultipartHead(request.out, request.command, contentLength);
+    TELEGRAM_TRACE_DEBUG(TELEGRAM_EVENT_UPLOAD, request.method, request.fileSize);
+    writeBody(request.out, (const uint8_t *)request.payload.c_str(), request.payload.length(),
+              contentLength < 0);
+    request.state = TelegramAsyncRequest::UPLOADING;
+    return true;
+  }
+
+  if (request.payload.length() > 0) {
+    printPostRequest(request.out, request.command, request.payload);
+  } else {
+    printGetRequest(request.out, request.command);
+  }
+  TELEGRAM_TRACE_DEBUG(TELEGRAM_EVENT_REQUEST, request.method, request.command.length(),
+                       request.payload.length());
+  request.sentAt = millis();
+  request.state = TelegramAsyncRequest::READING;
+  return true;
+}
+
+/***************************************************************
+ * UploadAsync - writes the next buffer of an upload, or its   *
+ * end once the data is used up                                *
+ ***************************************************************/
+void UniversalTelegramBot::uploadAsync(TelegramAsyncRequest &request) {
+  bool chunked = request.fileSize < 0;
+
+  if (request.moreDataAvailable()) {
+    if (request.getNextByte == nullptr) {
+      const uint8_t *buffer = (const uint8_t *)request.getNextBuffer();
+      int length = request.getNextBufferLen();
+      writeBody(request.out, buffer, length, chunked);
+      TELEGRAM_TRACE_DEBUG(TELEGRAM_EVENT_UPLOAD_BUFFER, length);
+    } else {
+      byte buffer[512];
+      int count = 0;
+      do {
+        buffer[count++] = request.getNextByte();
+      } while (count < 512 && request.moreDataAvailable());
+      writeBody(request.out, (const uint8_t *)buffer, count, chunked);
+      TELEGRAM_TRACE_DEBUG(TELEGRAM_EVENT_UPLOAD_BUFFER, count);
+    }
+    return;
+  }
+
+  writeBody(request.out, (const uint8_t *)request.tail.c_str(), request.tail.length(), chunked);
+  if (chunked) {
+    // Zero length chunk terminates the body
+    request.out.print(F("0\r\n\r\n"));
+  }
+  request.sentAt = millis();
+  request.state = TelegramAsyncRequest::READING;
+}
+
+/***************************************************************
+ * ReadAsync - feeds what has arrived of an answer to its      *
+ * parser and completes the request once it is all there, the  *
+ * server hung up or waitForResponse ran out                   *
+ ***************************************************************/
+void UniversalTelegramBot::readAsync(TelegramAsyncRequest &request) {
+  Client *client = pool.client(request.slot);
+  TelegramHttpResponse &response = request.response;
+
+  while (client->available()) {
+    request.received++;
+    if (response.feed(client->read())) break;
+  }
+
+  if (!response.finished()) {
+    // A long poll is answered when it times out on the server
+    unsigned long timeout = waitForResponse;
+    if (request.method == TELEGRAM_GET_UPDATES) timeout += longPoll * 1000ul;
+
+    if (!client->connected() && !client->available()) {
+      // Server closed the connection, which ends a body sent without a length
+      response.closed();
+    } else if (millis() - request.sentAt < timeout) {
+      return;
+    }
+  }
+
+  responseReceived(response, request.received);
+  closeConnection(client, request.slot, response.finished());
+  pool.release(request.slot);
+  request.slot = -1;
+  TELEGRAM_LOCKED(_statsLock, stats.bytesOut += request.bytesOut);
+  request.bytesOut = 0;
+
+  finishAsync(request, parseResult(request.body, request.result));
+}
+
+/***************************************************************
+ * FinishAsync - hands a request to tick() for its callback,   *
+ * or queues it again while its retry budget lasts             *
+ ***************************************************************/
+void UniversalTelegramBot::finishAsync(TelegramAsyncRequest &request, bool ok) {
+  if (!ok && request.retry && millis() - request.started < 8000ul) {
+    TELEGRAM_LOCKED(_statsLock, stats.retries++);
+    request.state = TelegramAsyncRequest::QUEUED;
+    return;
+  }
+
+  TELEGRAM_TRACE_INFO(TELEGRAM_EVENT_ASYNC_DONE, request.handle, ok, request.result.errorCode);
+  // A poll that worked reports its batch from parseUpdates()
+  if (!ok && request.method == TELEGRAM_GET_UPDATES) polling.failed();
+  request.state = TelegramAsyncRequest::DONE;
+}
@@ -22,19 +22,47 @@ Foundation, Inc., 51 Franklin St, Fifth Floor, Boston, MA 02110-1301 USA
 #ifndef UniversalTelegramBot_h
 #define UniversalTelegramBot_h
 
-//unmark following line to enable debug mode
+//unmark following line to enable debug mode (trace level 4, echoed to Serial)
 //#define TELEGRAM_DEBUG 1
+//or select what is traced into bot.trace, see TelegramTrace.h
+//#define TELEGRAM_TRACE_LEVEL 2
+//unmark following line to time every request, see TelegramLatency.h
+//#define TELEGRAM_LATENCY_STATS 1
+//unmark following line to track the heap around every call, see TelegramHeap.h
+//#define TELEGRAM_HEAP_TRACKING 1
+//unmark following line to share the bot between tasks, see TelegramLock.h
+//#define TELEGRAM_THREAD_SAFE 1
 #define ARDUINOJSON_DECODE_UNICODE 1
 #define ARDUINOJSON_USE_LONG_LONG 1
 #include <Arduino.h>
 #include <ArduinoJson.h>
 #include <Client.h>
+#include <TelegramAck.h>
+#include <TelegramAsync.h>
 #include <TelegramCertificate.h>
+#include <TelegramDedup.h>
+#include <TelegramCall.h>
+#include <TelegramCommands.h>
+#include <TelegramClientPool.h>
+#include <TelegramHttpResponse.h>
+#include <TelegramHeap.h>
+#include <TelegramLatency.h>
+#include <TelegramLock.h>
+#include <TelegramOffsetStore.h>
+#include <TelegramPollScheduler.h>
+#include <TelegramStats.h>
+#include <TelegramTrace.h>
 
 #define TELEGRAM_HOST "api.telegram.org"
 #define TELEGRAM_SSL_PORT 443
+#define TELEGRAM_PORT 80
 #define HANDLE_MESSAGES 1
 
+// Pass as fileSize to sendPhotoByBinary / sendMultipartFormDataToTelegram
+// when the length of the data is not known in advance. The upload is then
+// sent with Transfer-Encoding: chunked and nothing needs to be buffered.
+#define TELEGRAM_CHUNKED_UPLOAD -1
+
 typedef bool (*MoreDataAvailable)();
 typedef byte (*GetNextByte)();
 typedef byte* (*GetNextBuffer)();
@@ -71,6 +99,11 @@ public:
   UniversalTelegramBot(const String& token, Client &client, int maxMessageLength = 1500);
   void updateToken(const String& token);
   String getToken();
+  void setServer(const String& host, int port = TELEGRAM_SSL_PORT, bool secure = true);
+  String getServer();
+  // Another connection for outbound calls, see TelegramClientPool.h.
+  // False when TELEGRAM_MAX_CLIENTS are in use already.
+  bool addClient(Client &client);
   String sendGetToTelegram(const String& command);
   String sendPostToTelegram(const String& command, JsonObject payload);
   String
@@ -117,26 +150,157 @@ public:
 
   bool setMyCommands(const String& commandArray);
 
+  // Asynchronous calls, see TelegramAsync.h. They return at once with a
+  // handle, 0 when TELEGRAM_MAX_ASYNC calls are pending already; onDone is
+  // called from tick() with the result.
+  TelegramAsyncHandle getUpdatesAsync(long offset, TelegramAsyncDone onDone = nullptr);
+  TelegramAsyncHandle sendPostToTelegramAsync(const String& command, JsonObject payload,
+                                              TelegramAsyncDone onDone = nullptr);
+  TelegramAsyncHandle sendMessageAsync(const String& chat_id, const String& text,
+                                       TelegramAsyncDone onDone = nullptr,
+                                       const String& parse_mode = "");
+  TelegramAsyncHandle answerCallbackQueryAsync(const String &query_id,
+                                               const String &text = "",
+                                               TelegramAsyncDone onDone = nullptr);
+  TelegramAsyncHandle sendPhotoByBinaryAsync(const String& chat_id, const String& contentType,
+                                             int fileSize,
+                                             MoreDataAvailable moreDataAvailableCallback,
+                                             GetNextByte getNextByteCallback,
+                                             GetNextBuffer getNextBufferCallback,
+                                             GetNextBufferLen getNextBufferLenCallback,
+                                             TelegramAsyncDone onDone = nullptr);
+  // Moves the asynchronous calls along and runs the callbacks of those
+  // that finished. Returns how many are still pending.
+  int tick();
+  bool pending(TelegramAsyncHandle handle);
+  // Whether the next tick() has something to write: an upload under way,
+  // or a queued call a connection has come free for
+  bool sending();
+  // Fills messages[] from the body a getUpdatesAsync(offset) call returned
+  int parseUpdates(const String& response, long offset);
+
   String buildCommand(const String& cmd);
 
   int getUpdates(long offset);
+  // Keeps the acknowledged update offset in store and resumes from the one
+  // saved there, see TelegramOffsetStore.h
+  void setOffsetStore(TelegramOffsetStore *store, int saveEveryUpdates = 20,
+                      unsigned long saveEveryMs = 60000);
+  // Writes the acknowledged offset now if it changed since the last write
+  bool saveOffset();
+  // At-least-once processing, see TelegramAck.h: updates are confirmed to
+  // Telegram only once ack()ed. ack() is false for an update not handed
+  // out or acknowledged already.
+  void setManualAck(bool manual);
+  bool ack(long update_id);
+  int unacked();
+  // Command routing, see TelegramCommands.h. on() is false when
+  // TELEGRAM_MAX_COMMANDS are registered; dispatch() is false for a
+  // message that is not one of the commands.
+  bool on(const char *command, TelegramCommandHandler handler);
+  bool dispatch(telegramMessage &message);
   bool checkForOkResponse(const String& response);
+  // Outcome of the last call, of the calling task's last call with
+  // TELEGRAM_THREAD_SAFE
+  const TelegramResult &lastResult();
   telegramMessage messages[HANDLE_MESSAGES];
-  long last_message_received;
+  long last_message_received = 0;
   String name;
   String userName;
   int longPoll = 0;
+  // Ask for the next updates as soon as a batch is parsed, on the polling
+  // connection while the sketch handles the batch. Needs a second client,
+  // see addClient(); not combined with getUpdatesAsync.
+  bool prefetchUpdates = false;
   unsigned int waitForResponse = 1500;
   int _lastError;
   int last_sent_message_id = 0;
   int maxMessageLength = 1500;
+  TelegramStats stats;
+  TelegramClientPool pool;
+  // When to poll and for how long, see TelegramPollScheduler.h
+  TelegramPollScheduler polling;
+#ifdef TELEGRAM_LATENCY_STATS
+  TelegramLatencyStats latency;
+#endif
+#if TELEGRAM_TRACE_LEVEL > 0
+  TelegramTrace trace;
+#endif
+#ifdef TELEGRAM_HEAP_TRACKING
+  TelegramHeapTracker heap;
+#endif
 
 private:
+  friend class TelegramBotGroup;  // swaps per-token state along with the token
   // JsonObject * parseUpdates(String response);
   String _token;
-  Client *client;
+  String _host;
+  int _port = 0;
+  bool _secure;
+  TelegramCall _call;         // the call in progress, see call()
+#ifdef TELEGRAM_THREAD_SAFE
+  // Gives each public call its own TelegramCall for as long as it runs
+  class CallScope {
+  public:
+    CallScope(UniversalTelegramBot &bot);
+    ~CallScope();
+
+  private:
+    UniversalTelegramBot &_bot;
+    TelegramCall _call;
+    bool _nested;
+  };
+  TelegramMutex _statsLock;   // stats, last_sent_message_id
+  TelegramMutex _asyncLock;   // _async
+  TelegramMutex _ackLock;     // _acks
+#endif
+  TelegramAsyncRequest _async[TELEGRAM_MAX_ASYNC];
+  TelegramAsyncHandle _lastHandle = 0;
+  TelegramUpdateFilter _seen;
+  bool _manualAck = false;
+  TelegramAckWindow _acks;
+  long _refetchedAt = -1;     // acks.confirmed() when a poll brought only outstanding updates
+  TelegramOffsetStore *_offsetStore = nullptr;
+  TelegramCommandRouter _commands;
+  int _saveEveryUpdates = 0;
+  unsigned long _saveEveryMs = 0;
+  long _ackedOffset = 0;      // last update acknowledged by a getUpdates
+  long _savedOffset = 0;      // last update written to _offsetStore
+  long _prefetchOffset = 0;   // offset the poll sent ahead asked for, 0 if none
+  unsigned long _savedAt = 0;
+  TelegramCall &call();
+  bool connectClient();
+  bool openConnection(Client *client, int slot);
+  void requestStarted(const String& command);
+  void sampleHeap();
+  void printHostHeader(Print &out);
+  void printGetRequest(Print &out, const String& command);
+  bool sendGetRequest(const String& command);
+  void printPostRequest(Print &out, const String& command, const String& json);
+  void printMultipartHead(Print &out, const String& command, int contentLength);
+  void multipartParts(String &start, String &end, const String& binaryPropertyName,
+                      const String& fileName, const String& contentType, const String& chat_id);
+  void responseReceived(const TelegramHttpResponse &response, unsigned long received);
+  bool parseResult(const String& response, TelegramResult &result);
   void closeClient();
+  void closeConnection(Client *client, int slot, bool responseComplete);
+  void writeBody(Print &out, const uint8_t *data, size_t len, bool chunked);
+  TelegramAsyncRequest *queueAsync(const String& command, TelegramAsyncDone onDone);
+  TelegramAsyncHandle queued(TelegramAsyncRequest *request);
+  bool pumpAsync(bool start);
+  bool startAsync(TelegramAsyncRequest &request);
+  void uploadAsync(TelegramAsyncRequest &request);
+  void readAsync(TelegramAsyncRequest &request);
+  void finishAsync(TelegramAsyncRequest &request, bool ok);
   bool getFile(String& file_path, long& file_size, const String& file_id);
+  long pollOffset(long offset, int &limit);
+  void skipped(long update_id);
+  String updatesCommand(long offset, int limit);
+  void prefetch(long offset, bool pollComplete);
+  String readPrefetched();
+  void dropPrefetch();
+  void acknowledge(long offset);
+  int readUpdates(const String& response, long offset, long &skipTo);
   bool processResult(JsonObject result, int messageIndex);
   long getUpdateIdFromResponse(String response);
 };